@@ -0,0 +1,72 @@
+/*
+Compile: make bench_arena bench_arena_release
+Run: ./bench_arena && ./bench_arena_release
+make bench_arena bench_arena_release && ./bench_arena && ./bench_arena_release
+
+Simulates request handlers that build temporary strings, lists, and arrays. 
+Compares freeing each object individually with allocating everything from 
+an arena that is reset after each request.
+*/
+
+#include "base.h"
+
+#define REQUESTS 200000
+
+static bool is_even(int value, int index, int x) {
+    return value % 2 == 0;
+}
+
+static int times_3(int value, int index, int x) {
+    return 3 * value;
+}
+
+// Handles a single request. Frees its temporary objects individually.
+static int handle(String request) {
+    List words = sl_split(request, ' ');
+    String joined = s_join(words, ',');
+    Array numbers = ia_range(0, 32);
+    Array even = ia_filter(numbers, is_even, 0);
+    List values = il_range(0, 16);
+    List tripled = il_map(values, times_3, 0);
+    int result = s_length(joined) + even->n + il_get(tripled, 15);
+    sl_free(words);
+    s_free(joined);
+    a_free(numbers);
+    a_free(even);
+    l_free(values);
+    l_free(tripled);
+    return result;
+}
+
+static double heap_ms(int *result) {
+    clock_t t = clock();
+    for (int i = 0; i < REQUESTS; i++) {
+        *result += handle("GET /index.html HTTP/1.1 Host example.org");
+    }
+    t = clock() - t;
+    return t * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static double arena_ms(int *result) {
+    Arena arena = arena_create(16 * 1024);
+    clock_t t = clock();
+    for (int i = 0; i < REQUESTS; i++) {
+        arena_enter(arena);
+        *result += handle("GET /index.html HTTP/1.1 Host example.org");
+        arena_leave();
+        arena_reset(arena);
+    }
+    t = clock() - t;
+    arena_free(arena);
+    return t * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    int result = 0;
+    printf("%-28s %10.1f ms\n", "individual free", heap_ms(&result));
+    printf("%-28s %10.1f ms\n", "arena reset per request", arena_ms(&result));
+    printf("(%d)\n", result);
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+Compile: make bench_array_layout bench_array_layout_release
+Run: ./bench_array_layout && ./bench_array_layout_release
+make bench_array_layout bench_array_layout_release && ./bench_array_layout && ./bench_array_layout_release
+
+Measures the cost of the array layout. The first loop creates and frees
+small int arrays. The second loop reads the elements of many small arrays
+in random order, such that the head and the elements of an array are
+rarely in the cache.
+*/
+
+#include "base.h"
+
+#define CREATE_N 5000000
+#define ARRAYS 200000
+#define ELEMENTS 8
+#define ACCESS_N 20000000
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+
+    clock_t t = clock();
+    for (int i = 0; i < CREATE_N; i++) {
+        Array a = ia_create(ELEMENTS, i);
+        a_free(a);
+    }
+    double create = (double)(clock() - t) / CLOCKS_PER_SEC;
+    printf("create/free: %8.1f Marrays/s\n", CREATE_N / create / 1e6);
+
+    Array *arrays = xmalloc(ARRAYS * sizeof(Array));
+    for (int i = 0; i < ARRAYS; i++) {
+        arrays[i] = ia_create(ELEMENTS, i);
+    }
+    int *order = xmalloc(ACCESS_N * sizeof(int));
+    for (int i = 0; i < ACCESS_N; i++) {
+        order[i] = i_rnd(ARRAYS);
+    }
+    t = clock();
+    long sum = 0;
+    for (int i = 0; i < ACCESS_N; i++) {
+        Array a = arrays[order[i]];
+        sum += ia_get(a, i % ELEMENTS);
+    }
+    double access = (double)(clock() - t) / CLOCKS_PER_SEC;
+    printf("access:      %8.1f Mgets/s (sum %ld)\n", ACCESS_N / access / 1e6, sum);
+
+    for (int i = 0; i < ARRAYS; i++) {
+        a_free(arrays[i]);
+    }
+    free(arrays);
+    free(order);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+Compile: make bench_builtins bench_builtins_release
+Run: ./bench_builtins && ./bench_builtins_release
+make bench_builtins bench_builtins_release && ./bench_builtins && ./bench_builtins_release
+
+Compares ia_filter, ia_map, ia_foldl, and the da_ counterparts with a
+builtin predicate or function (ia_gt, ia_times, int_plus, ...), which they
+recognize and replace by a vectorized loop (da_foldl by a plain loop, to
+get the same result as the callback), to the same calls with an
+equivalent user-defined callback, which is called for each element. The
+arrays have 4K elements (in the L1 or L2 cache) or 4M elements (main
+memory), the filters keep about half of the elements. Prints million
+elements per second.
+*/
+
+#include "base.h"
+
+#define TOTAL 200000000.0 // elements processed per size and variant
+
+static bool user_gt(int value, int index, int x) { return value > x; }
+static bool user_even(int value, int index, int x) { return (value & 1) == 0; }
+static int user_times(int value, int index, int x) { return value * x; }
+static int user_plus(int x, int y, int index) { return x + y; }
+static int user_mult(int x, int y, int index) { return x * y; }
+static bool user_lt_double(double value, int index, double x) { return value < x; }
+static double user_times_double(double value, int index, double x) { return value * x; }
+static double user_plus_double(double x, double y, int index) { return x + y; }
+
+typedef enum {
+    IA_FILTER_GT, IA_FILTER_EVEN, IA_MAP_TIMES, IA_FOLDL_PLUS, IA_FOLDL_MULT,
+    DA_FILTER_LT, DA_MAP_TIMES, DA_FOLDL_PLUS,
+    VARIANTS
+} Variant;
+
+static const char *variant_names[] = {
+    "ia_filter(gt)", "ia_filter(even)", "ia_map(times)", "ia_foldl(plus)", "ia_foldl(mult)",
+    "da_filter(lt)", "da_map(times)", "da_foldl(plus)"
+};
+
+// Runs the variant repeatedly, returns million elements per second. The
+// results are summed into sink, such that the calls are not optimized away.
+static double measure(Variant v, Array ints, Array doubles, bool builtin, double *sink) {
+    int n = v < DA_FILTER_LT ? ints->n : doubles->n;
+    long reps = (long)(TOTAL / n);
+    clock_t t = clock();
+    for (long r = 0; r < reps; r++) {
+        Array b = NULL;
+        switch (v) {
+            case IA_FILTER_GT: b = ia_filter(ints, builtin ? ia_gt : user_gt, 0); break;
+            case IA_FILTER_EVEN: b = ia_filter(ints, builtin ? ia_even : user_even, 0); break;
+            case IA_MAP_TIMES: b = ia_map(ints, builtin ? ia_times : user_times, 3); break;
+            case IA_FOLDL_PLUS: *sink += ia_foldl(ints, builtin ? int_plus : user_plus, 0); break;
+            case IA_FOLDL_MULT: *sink += ia_foldl(ints, builtin ? int_mult : user_mult, 1); break;
+            case DA_FILTER_LT: b = da_filter(doubles, builtin ? da_lt : user_lt_double, 0.0); break;
+            case DA_MAP_TIMES: b = da_map(doubles, builtin ? da_times : user_times_double, 3.0); break;
+            case DA_FOLDL_PLUS: *sink += da_foldl(doubles, builtin ? double_plus : user_plus_double, 0.0); break;
+            default: break;
+        }
+        if (b != NULL) {
+            *sink += b->n;
+            a_free(b);
+        }
+    }
+    double seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    double sink = 0;
+    int sizes[] = { 4096, 4 * 1024 * 1024 };
+    printf("%16s %21s %21s\n", "", "4K elements", "4M elements");
+    printf("%16s %10s %10s %10s %10s   (Melements/s)\n", "", "callback", "builtin", "callback", "builtin");
+    Array ints[2], doubles[2];
+    for (int k = 0; k < 2; k++) {
+        ints[k] = ia_create(sizes[k], 0);
+        doubles[k] = da_create(sizes[k], 0);
+        for (int i = 0; i < sizes[k]; i++) {
+            ia_set(ints[k], i, i_rnd(2001) - 1000);
+            da_set(doubles[k], i, d_rnd(2.0) - 1.0);
+        }
+    }
+    for (Variant v = 0; v < VARIANTS; v++) {
+        printf("%16s", variant_names[v]);
+        for (int k = 0; k < 2; k++) {
+            printf(" %10.1f", measure(v, ints[k], doubles[k], false, &sink));
+            printf(" %10.1f", measure(v, ints[k], doubles[k], true, &sink));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    for (int k = 0; k < 2; k++) {
+        a_free(ints[k]);
+        a_free(doubles[k]);
+    }
+    printf("(%g)\n", sink);
+    return 0;
+}
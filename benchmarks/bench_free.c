@@ -0,0 +1,34 @@
+/*
+Compile: make bench_free
+Run: ./bench_free
+make bench_free && ./bench_free
+
+Measures the cost of free as the number of live allocations grows. Allocates 
+n blocks, then frees them in allocation order (oldest first). The cost per 
+free should stay flat as n grows.
+*/
+
+#include "base.h"
+
+static double free_ns(int n) {
+    Any *blocks = xmalloc(n * sizeof(Any));
+    for (int i = 0; i < n; i++) {
+        blocks[i] = xmalloc(16);
+    }
+    clock_t t = clock();
+    for (int i = 0; i < n; i++) {
+        free(blocks[i]);
+    }
+    t = clock() - t;
+    free(blocks);
+    return t * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+int main(void) {
+    report_memory_leaks(true);
+    printf("%10s %12s\n", "live", "ns/free");
+    for (int n = 1000; n <= 512000; n *= 2) {
+        printf("%10d %12.1f\n", n, free_ns(n));
+    }
+    return 0;
+}
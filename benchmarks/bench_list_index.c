@@ -0,0 +1,90 @@
+/*
+Compile: make bench_list_index bench_list_index_release
+Run: ./bench_list_index && ./bench_list_index_release
+make bench_list_index bench_list_index_release && ./bench_list_index && ./bench_list_index_release
+
+Measures indexed traversal of int lists, for (i = 0; i < n; i++) il_get(list, i),
+and the same with il_inc and l_get. These start at the cursor of the list (the
+node last accessed by index), thus each access moves one node. For comparison,
+"walk" starts at the first node for each index, as il_get did before (only up
+to 10K elements, it takes O(n^2) time), and "iterator" traverses the list with
+l_iterator and il_next. Prints million elements per second.
+*/
+
+#include "base.h"
+
+#define TOTAL 20000000 // elements accessed per size and variant
+
+typedef enum { WALK, IL_GET, IL_INC, L_GET, ITERATOR, VARIANTS } Variant;
+
+static const char *variant_names[] = { "walk", "il_get", "il_inc", "l_get", "iterator" };
+
+// Returns the element at index, starting at the first node.
+static int walk_get(List list, int index) {
+    IntListNode *node = list->first;
+    for (int i = 0; i < index; i++) {
+        node = node->next;
+    }
+    return node->value;
+}
+
+// Traverses the list repeatedly, returns million elements per second. The
+// elements are summed into sink, such that the loops are not optimized away.
+static double measure(Variant v, List list, long *sink) {
+    int n = l_length(list);
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    if (v == WALK) reps = 1;
+    clock_t t = clock();
+    for (int r = 0; r < reps; r++) {
+        switch (v) {
+            case WALK:
+                for (int i = 0; i < n; i++) *sink += walk_get(list, i);
+                break;
+            case IL_GET:
+                for (int i = 0; i < n; i++) *sink += il_get(list, i);
+                break;
+            case IL_INC:
+                for (int i = 0; i < n; i++) il_inc(list, i, 1);
+                break;
+            case L_GET:
+                for (int i = 0; i < n; i++) *sink += *(int*)l_get(list, i);
+                break;
+            case ITERATOR: {
+                ListIterator iter = l_iterator(list);
+                while (l_has_next(iter)) *sink += il_next(&iter);
+                break;
+            }
+            default: break;
+        }
+    }
+    double seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    long sink = 0;
+    printf("%10s", "n");
+    for (Variant v = 0; v < VARIANTS; v++) printf(" %10s", variant_names[v]);
+    printf("   (Melements/s)\n");
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        List list = il_create();
+        for (int i = 0; i < n; i++) {
+            il_append(list, i_rnd(1000));
+        }
+        printf("%10d", n);
+        for (Variant v = 0; v < VARIANTS; v++) {
+            if (v == WALK && n > 10000) {
+                printf(" %10s", "-");
+            } else {
+                printf(" %10.2f", measure(v, list, &sink));
+            }
+            fflush(stdout);
+        }
+        printf("\n");
+        l_free(list);
+    }
+    printf("(%ld)\n", sink);
+    return 0;
+}
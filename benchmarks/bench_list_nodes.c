@@ -0,0 +1,32 @@
+/*
+Compile: make bench_list_nodes bench_list_nodes_release
+Run: ./bench_list_nodes && ./bench_list_nodes_release
+make bench_list_nodes bench_list_nodes_release && ./bench_list_nodes && ./bench_list_nodes_release
+
+Measures the throughput of building a large int list with il_append and 
+freeing it with l_free. The second round reuses the nodes freed in the 
+first round.
+*/
+
+#include "base.h"
+
+#define N 10000000
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    printf("%6s %16s %16s\n", "round", "build Mnodes/s", "free Mnodes/s");
+    for (int r = 1; r <= 2; r++) {
+        clock_t t = clock();
+        List list = il_create();
+        for (int i = 0; i < N; i++) {
+            il_append(list, i);
+        }
+        double build = (double)(clock() - t) / CLOCKS_PER_SEC;
+        t = clock();
+        l_free(list);
+        double release = (double)(clock() - t) / CLOCKS_PER_SEC;
+        printf("%6d %16.1f %16.1f\n", r, N / build / 1e6, N / release / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+Compile: make bench_malloc
+Run: ./bench_malloc
+make bench_malloc && ./bench_malloc
+
+Measures the cost of tracked allocation for list-node-sized blocks. Builds 
+int lists of n elements and frees them again.
+*/
+
+#include "base.h"
+
+static double malloc_ns(int n) {
+    Any *blocks = xmalloc(n * sizeof(Any));
+    clock_t t = clock();
+    for (int i = 0; i < n; i++) {
+        blocks[i] = xmalloc(sizeof(IntListNode));
+    }
+    t = clock() - t;
+    for (int i = 0; i < n; i++) {
+        free(blocks[i]);
+    }
+    free(blocks);
+    return t * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+static double il_build_free_ns(int n) {
+    clock_t t = clock();
+    List list = il_range(0, n);
+    l_free(list);
+    t = clock() - t;
+    return t * 1.0e9 / CLOCKS_PER_SEC / n;
+}
+
+int main(void) {
+    report_memory_leaks(true);
+    printf("%10s %14s %18s\n", "n", "ns/xmalloc", "ns/il element");
+    for (int n = 1000; n <= 1024000; n *= 4) {
+        printf("%10d %14.1f %18.1f\n", n, malloc_ns(n), il_build_free_ns(n));
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+Compile: make bench_reduce bench_reduce_release
+Run: ./bench_reduce && ./bench_reduce_release
+make bench_reduce bench_reduce_release && ./bench_reduce && ./bench_reduce_release
+
+Throughput of the reductions in GB/s (bytes of the input arrays read per 
+second). ia_sum, da_sum, and da_sum_fast are compared to ia_foldl and 
+da_foldl with a function that adds (not int_plus and double_plus, which 
+they recognize, see bench_builtins.c), the other reductions to a plain 
+loop. The arrays fit into the L1 cache (16 KB) or only main memory (64 MB).
+*/
+
+#include "base.h"
+
+#define TOTAL_BYTES 2000000000.0 // bytes read per size and variant
+
+typedef enum { 
+    IA_FOLDL, IA_SUM, IA_LOOP_MAX, IA_MAX_INDEX, IA_LOOP_DOT, IA_DOT, IA_VARIANCE, 
+    DA_FOLDL, DA_SUM, DA_SUM_FAST, DA_LOOP_MIN, DA_MIN_INDEX, DA_LOOP_DOT, DA_DOT, DA_VARIANCE, 
+    VARIANTS
+} Variant;
+
+static const char *variant_names[] = { 
+    "ia_foldl(+)", "ia_sum", "loop max", "ia_max_index", "loop dot", "ia_dot", "ia_variance", 
+    "da_foldl(+)", "da_sum", "da_sum_fast", "loop min", "da_min_index", "loop dot", "da_dot", "da_variance" 
+};
+
+static int plus(int x, int y, int index) {
+    return x + y;
+}
+
+static double plus_double(double x, double y, int index) {
+    return x + y;
+}
+
+static int loop_max_index_int(const int *a, int n) {
+    int m = 0;
+    for (int i = 1; i < n; i++) {
+        if (a[i] > a[m]) m = i;
+    }
+    return m;
+}
+
+static long loop_dot_int(const int *a, const int *b, int n) {
+    long sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += (long)a[i] * b[i];
+    }
+    return sum;
+}
+
+static int loop_min_index_double(const double *a, int n) {
+    int m = 0;
+    for (int i = 1; i < n; i++) {
+        if (a[i] < a[m]) m = i;
+    }
+    return m;
+}
+
+static double loop_dot_double(const double *a, const double *b, int n) {
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Runs the reduction repeatedly, returns GB/s. The results are summed into 
+// sink, such that the calls are not optimized away.
+static double measure(Variant v, Array ints, Array ints2, Array doubles, Array doubles2, double *sink) {
+    bool dot = v == IA_LOOP_DOT || v == IA_DOT || v == DA_LOOP_DOT || v == DA_DOT;
+    Array a = v < DA_FOLDL ? ints : doubles;
+    long bytes = (long)a->n * a->s * (dot ? 2 : 1);
+    long reps = (long)(TOTAL_BYTES / bytes);
+    clock_t t = clock();
+    for (long r = 0; r < reps; r++) {
+        switch (v) {
+            case IA_FOLDL: *sink += ia_foldl(ints, plus, 0); break;
+            case IA_SUM: *sink += ia_sum(ints); break;
+            case IA_LOOP_MAX: *sink += loop_max_index_int(ints->a, ints->n); break;
+            case IA_MAX_INDEX: *sink += ia_max_index(ints); break;
+            case IA_LOOP_DOT: *sink += loop_dot_int(ints->a, ints2->a, ints->n); break;
+            case IA_DOT: *sink += ia_dot(ints, ints2); break;
+            case IA_VARIANCE: *sink += ia_variance(ints); break;
+            case DA_FOLDL: *sink += da_foldl(doubles, plus_double, 0); break;
+            case DA_SUM: *sink += da_sum(doubles); break;
+            case DA_SUM_FAST: *sink += da_sum_fast(doubles); break;
+            case DA_LOOP_MIN: *sink += loop_min_index_double(doubles->a, doubles->n); break;
+            case DA_MIN_INDEX: *sink += da_min_index(doubles); break;
+            case DA_LOOP_DOT: *sink += loop_dot_double(doubles->a, doubles2->a, doubles->n); break;
+            case DA_DOT: *sink += da_dot(doubles, doubles2); break;
+            case DA_VARIANCE: *sink += da_variance(doubles); break;
+            default: break;
+        }
+    }
+    double seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)bytes * reps / seconds / 1e9 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    double sink = 0;
+    long sizes[] = { 16 * 1024, 64 * 1024 * 1024 };
+    printf("%14s %10s %10s   (GB/s)\n", "", "16 KB", "64 MB");
+    Array arrays[2][4];
+    for (int k = 0; k < 2; k++) {
+        int n_ints = (int)(sizes[k] / sizeof(int)), n_doubles = (int)(sizes[k] / sizeof(double));
+        arrays[k][0] = ia_create(n_ints, 0);
+        arrays[k][1] = ia_create(n_ints, 0);
+        arrays[k][2] = da_create(n_doubles, 0);
+        arrays[k][3] = da_create(n_doubles, 0);
+        for (int i = 0; i < n_ints; i++) {
+            ia_set(arrays[k][0], i, i_rnd(2000001) - 1000000);
+            ia_set(arrays[k][1], i, i_rnd(2001) - 1000);
+        }
+        for (int i = 0; i < n_doubles; i++) {
+            da_set(arrays[k][2], i, d_rnd(2.0) - 1.0);
+            da_set(arrays[k][3], i, d_rnd(2.0) - 1.0);
+        }
+    }
+    for (Variant v = 0; v < VARIANTS; v++) {
+        printf("%14s", variant_names[v]);
+        for (int k = 0; k < 2; k++) {
+            printf(" %10.2f", measure(v, arrays[k][0], arrays[k][1], arrays[k][2], arrays[k][3], &sink));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    for (int k = 0; k < 2; k++) {
+        for (int j = 0; j < 4; j++) a_free(arrays[k][j]);
+    }
+    printf("(%g)\n", sink);
+    return 0;
+}
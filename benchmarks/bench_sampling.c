@@ -0,0 +1,49 @@
+/*
+Compile: make bench_sampling bench_sampling_release
+Run: ./bench_sampling && ./bench_sampling_release
+make bench_sampling bench_sampling_release && ./bench_sampling && ./bench_sampling_release
+
+Compares the cost of sampling mode, full allocation tracking, and no 
+tracking (bench_sampling_release, linked with libprog1_release.a, where both 
+rows run untracked). For a fair comparison, build both library variants with 
+the same optimization level:
+cd ../lib && make clean && make DEBUG=-O2 && make release
+*/
+
+#include "base.h"
+
+#define N 1000000
+#define ROUNDS 5
+
+static int times_3(int value, int index, int x) {
+    return 3 * value;
+}
+
+static double workload_ms(void) {
+    clock_t t = clock();
+    for (int r = 0; r < ROUNDS; r++) {
+        List a = il_range(0, N);
+        List b = il_map(a, times_3, 0);
+        l_free(a);
+        l_free(b);
+        for (int i = 0; i < N / 10; i++) {
+            List words = sl_split("alpha beta gamma delta", ' ');
+            String s = s_join(words, ',');
+            sl_free(words);
+            s_free(s);
+        }
+    }
+    t = clock() - t;
+    return t * 1000.0 / CLOCKS_PER_SEC / ROUNDS;
+}
+
+int main(int argc, char *argv[]) {
+    printsln(argv[0]);
+    // sampling first, so that both runs start with the same heap layout as 
+    // in bench_sampling_release
+    sample_allocations(512 * 1024);
+    printf("%-28s %10.1f ms\n", "sampling (512 KB interval)", workload_ms());
+    sample_allocations(0);
+    printf("%-28s %10.1f ms\n", "full tracking", workload_ms());
+    return 0;
+}
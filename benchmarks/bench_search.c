@@ -0,0 +1,110 @@
+/*
+Compile: make bench_search bench_search_release
+Run: ./bench_search && ./bench_search_release
+make bench_search bench_search_release && ./bench_search && ./bench_search_release
+
+Throughput of the search functions ia_index, ia_last_index, ia_contains, 
+ba_index, and da_index compared to a plain loop, in GB/s. The value is not 
+in the array, so the whole array is scanned. The array sizes fit into the 
+L1 cache (16 KB), the L2 cache (256 KB), or only main memory (64 MB).
+*/
+
+#include "base.h"
+
+#define TOTAL_BYTES 4000000000.0 // bytes scanned per size and variant
+
+typedef enum { IA_INDEX, IA_LAST_INDEX, IA_CONTAINS, BA_INDEX, DA_INDEX } Variant;
+
+static const char *variant_names[] = { "ia_index", "ia_last_index", "ia_contains", 
+    "ba_index", "da_index" };
+
+static int loop_index_int(const int *a, int n, int value) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] == value) return i;
+    }
+    return -1;
+}
+
+static int loop_last_index_int(const int *a, int n, int value) {
+    for (int i = n - 1; i >= 0; i--) {
+        if (a[i] == value) return i;
+    }
+    return -1;
+}
+
+static int loop_index_byte(const Byte *a, int n, Byte value) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] == value) return i;
+    }
+    return -1;
+}
+
+static int loop_index_double(const double *a, int n, double value, double epsilon) {
+    for (int i = 0; i < n; i++) {
+        if (fabs(a[i] - value) < epsilon) return i;
+    }
+    return -1;
+}
+
+// Searches the array repeatedly, returns GB/s. The results are summed into 
+// sink, such that the calls are not optimized away.
+static double measure(Variant v, Array a, bool library, long *sink) {
+    long bytes = (long)a->n * a->s;
+    long reps = (long)(TOTAL_BYTES / bytes);
+    clock_t t = clock();
+    for (long r = 0; r < reps; r++) {
+        int x = -1 - (int)(r & 1); // not in the array
+        switch (v) {
+            case IA_INDEX:
+                *sink += library ? ia_index(a, x) : loop_index_int(a->a, a->n, x);
+                break;
+            case IA_LAST_INDEX:
+                *sink += library ? ia_last_index(a, x) : loop_last_index_int(a->a, a->n, x);
+                break;
+            case IA_CONTAINS:
+                *sink += library ? ia_contains(a, x) : loop_index_int(a->a, a->n, x) >= 0;
+                break;
+            case BA_INDEX:
+                *sink += library ? ba_index(a, (Byte)(200 + x)) : loop_index_byte(a->a, a->n, (Byte)(200 + x));
+                break;
+            case DA_INDEX:
+                *sink += library ? da_index(a, x, 0.5) : loop_index_double(a->a, a->n, x, 0.5);
+                break;
+        }
+    }
+    double seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)bytes * reps / seconds / 1e9 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    long sink = 0;
+    long sizes[] = { 16 * 1024, 256 * 1024, 64 * 1024 * 1024 };
+    printf("%14s", "");
+    for (int k = 0; k < 3; k++) printf(" %8ld KB         ", sizes[k] / 1024);
+    printf("\n%14s", "");
+    for (int k = 0; k < 3; k++) printf(" %9s %9s", "loop", "library");
+    printf("   (GB/s)\n");
+    for (Variant v = IA_INDEX; v <= DA_INDEX; v++) {
+        printf("%14s", variant_names[v]);
+        for (int k = 0; k < 3; k++) {
+            Array a = NULL;
+            if (v == BA_INDEX) {
+                a = ba_create((int)sizes[k], 0);
+                for (int i = 0; i < a->n; i++) ba_set(a, i, (Byte)(i % 190));
+            } else if (v == DA_INDEX) {
+                a = da_range(0, sizes[k] / sizeof(double), 1);
+            } else {
+                a = ia_range(0, (int)(sizes[k] / sizeof(int)));
+            }
+            printf(" %9.2f", measure(v, a, false, &sink));
+            printf(" %9.2f", measure(v, a, true, &sink));
+            fflush(stdout);
+            a_free(a);
+        }
+        printf("\n");
+    }
+    printf("(%ld)\n", sink);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+Compile: make bench_sort bench_sort_release
+Run: ./bench_sort && ./bench_sort_release
+make bench_sort bench_sort_release && ./bench_sort && ./bench_sort_release
+
+Compares qsort with a comparator, which ia_sort, ia_sort_dec, da_sort, and
+ba_sort used before, to the sort functions. These use introsort for short
+arrays and radix sort from A_RADIX_SORT_MIN elements on
+(A_RADIX_SORT_MIN_DOUBLE for doubles). The
+elements are random. The sizes go from 16 to 10M elements, an optional
+argument sets the maximum size, e.g., ./bench_sort_release 100000000 for
+up to 100M elements. Prints million elements sorted per second.
+*/
+
+#include "base.h"
+
+#define TOTAL 10000000 // elements sorted per size and variant
+#define POOL 1000000 // small arrays are taken from a pool of random elements
+
+static int compare_int(const void *a, const void *b) {
+    int x = *(int*)a, y = *(int*)b;
+    return (x == y) ? 0 : (x < y ? -1 : 1);
+}
+
+static int compare_int_dec(const void *a, const void *b) {
+    int x = *(int*)a, y = *(int*)b;
+    return (x == y) ? 0 : (x < y ? 1 : -1);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(double*)a, y = *(double*)b;
+    return (x == y) ? 0 : (x < y ? -1 : 1);
+}
+
+static int compare_byte(const void *a, const void *b) {
+    Byte x = *(Byte*)a, y = *(Byte*)b;
+    return (x == y) ? 0 : (x < y ? -1 : 1);
+}
+
+typedef enum { INTS, INTS_DEC, DOUBLES, BYTES } Variant;
+
+// Sorts copies of n consecutive elements of the source array, each 
+// repetition at a different position, such that the branch predictor 
+// cannot learn the input. Returns million elements per second.
+static double measure(Array source, int n, Variant v, bool use_qsort) {
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    int positions = a_length(source) - n + 1;
+    Array a = a_sub(source, 0, n);
+    clock_t total = 0;
+    for (int r = 0; r < reps; r++) {
+        Byte *slice = (Byte*)source->a + (size_t)((long)r * n % positions) * source->s;
+        memcpy(a->a, slice, (size_t)n * source->s);
+        clock_t t = clock();
+        if (use_qsort) {
+            switch (v) {
+                case INTS: qsort(a->a, n, sizeof(int), compare_int); break;
+                case INTS_DEC: qsort(a->a, n, sizeof(int), compare_int_dec); break;
+                case DOUBLES: qsort(a->a, n, sizeof(double), compare_double); break;
+                case BYTES: qsort(a->a, n, sizeof(Byte), compare_byte); break;
+            }
+        } else {
+            switch (v) {
+                case INTS: ia_sort(a); break;
+                case INTS_DEC: ia_sort_dec(a); break;
+                case DOUBLES: da_sort(a); break;
+                case BYTES: ba_sort(a); break;
+            }
+        }
+        total += clock() - t;
+    }
+    a_free(a);
+    double seconds = (double)total / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    int max = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    printf("%10s %19s %19s %19s %19s\n", "", "ints", "ints (dec)", "doubles", "bytes");
+    printf("%10s", "n");
+    for (int v = INTS; v <= BYTES; v++) printf(" %9s %9s", "qsort", "sort");
+    printf("   (Melements/s)\n");
+    for (long n = 16; n <= max; n = n < 1000 ? (n == 256 ? 1000 : 4 * n) : 10 * n) {
+        int m = n < POOL ? POOL : n;
+        Array ints = ia_create(m, 0);
+        Array doubles = da_create(m, 0);
+        Array bytes = ba_create(m, 0);
+        for (int i = 0; i < m; i++) {
+            int x = (int)(((unsigned)rand() << 16) ^ (unsigned)rand());
+            ia_set(ints, i, x);
+            da_set(doubles, i, x * 1e-3);
+            ba_set(bytes, i, (Byte)x);
+        }
+        printf("%10ld", n);
+        for (int v = INTS; v <= BYTES; v++) {
+            Array source = v == DOUBLES ? doubles : (v == BYTES ? bytes : ints);
+            printf(" %9.1f", measure(source, n, v, true));
+            printf(" %9.1f", measure(source, n, v, false));
+            fflush(stdout);
+        }
+        printf("\n");
+        a_free(ints);
+        a_free(doubles);
+        a_free(bytes);
+    }
+    return 0;
+}
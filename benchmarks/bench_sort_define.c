@@ -0,0 +1,124 @@
+/*
+Compile: make bench_sort_define bench_sort_define_release
+Run: ./bench_sort_define && ./bench_sort_define_release
+make bench_sort_define bench_sort_define_release && ./bench_sort_define && ./bench_sort_define_release
+
+Compares a_sort, which calls qsort with a comparator, to sort functions
+generated with A_SORT_DEFINE (see array_sort.h) for arrays of IntPair
+(ordered by i, then j), DoublePair (ordered by i), and a 24-byte struct
+(ordered by key). The elements are random. Prints million elements sorted
+per second.
+*/
+
+#include "base.h"
+#include "array_sort.h"
+
+#define TOTAL 10000000 // elements sorted per size and variant
+#define POOL 1000000 // small arrays are taken from a pool of random elements
+
+typedef struct {
+    int key;
+    int data[5];
+} Record;
+
+static CmpResult int_pair_compare(ConstAny a, ConstAny b) {
+    const IntPair *x = a, *y = b;
+    if (x->i != y->i) return x->i < y->i ? LT : GT;
+    return (x->j == y->j) ? EQ : (x->j < y->j ? LT : GT);
+}
+
+static inline bool int_pair_less(const IntPair *x, const IntPair *y) {
+    return x->i < y->i || (x->i == y->i && x->j < y->j);
+}
+
+A_SORT_DEFINE(int_pair_sort, IntPair, int_pair_less)
+
+static CmpResult double_pair_compare(ConstAny a, ConstAny b) {
+    const DoublePair *x = a, *y = b;
+    return (x->i == y->i) ? EQ : (x->i < y->i ? LT : GT);
+}
+
+static inline bool double_pair_less(const DoublePair *x, const DoublePair *y) {
+    return x->i < y->i;
+}
+
+A_SORT_DEFINE(double_pair_sort, DoublePair, double_pair_less)
+
+static CmpResult record_compare(ConstAny a, ConstAny b) {
+    const Record *x = a, *y = b;
+    return (x->key == y->key) ? EQ : (x->key < y->key ? LT : GT);
+}
+
+static inline bool record_less(const Record *x, const Record *y) {
+    return x->key < y->key;
+}
+
+A_SORT_DEFINE(record_sort, Record, record_less)
+
+typedef enum { INT_PAIRS, DOUBLE_PAIRS, RECORDS } Variant;
+
+// Sorts copies of n consecutive elements of the source array, each 
+// repetition at a different position, such that the branch predictor 
+// cannot learn the input. Returns million elements per second.
+static double measure(Array source, int n, Variant v, bool generated) {
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    int positions = a_length(source) - n + 1;
+    Array a = a_sub(source, 0, n);
+    clock_t total = 0;
+    for (int r = 0; r < reps; r++) {
+        Byte *slice = (Byte*)source->a + (size_t)((long)r * n % positions) * source->s;
+        memcpy(a->a, slice, (size_t)n * source->s);
+        clock_t t = clock();
+        switch (v) {
+            case INT_PAIRS:
+                if (generated) int_pair_sort(a); else a_sort(a, int_pair_compare);
+                break;
+            case DOUBLE_PAIRS:
+                if (generated) double_pair_sort(a); else a_sort(a, double_pair_compare);
+                break;
+            case RECORDS:
+                if (generated) record_sort(a); else a_sort(a, record_compare);
+                break;
+        }
+        total += clock() - t;
+    }
+    a_free(a);
+    double seconds = (double)total / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+
+    printf("%10s %19s %19s %19s\n", "", "IntPair", "DoublePair", "Record (24 bytes)");
+    printf("%10s", "n");
+    for (int v = INT_PAIRS; v <= RECORDS; v++) printf(" %9s %9s", "a_sort", "generated");
+    printf("   (Melements/s)\n");
+    for (int n = 10; n <= 1000000; n *= 10) {
+        int m = n < POOL ? POOL : n;
+        Array pairs = a_create(m, sizeof(IntPair));
+        Array double_pairs = a_create(m, sizeof(DoublePair));
+        Array records = a_create(m, sizeof(Record));
+        for (int i = 0; i < m; i++) {
+            IntPair p = { i_rnd(1000), rand() };
+            a_set(pairs, i, &p);
+            DoublePair d = { d_rnd(1.0), i };
+            a_set(double_pairs, i, &d);
+            Record r = { rand(), { i } };
+            a_set(records, i, &r);
+        }
+        printf("%10d", n);
+        for (int v = INT_PAIRS; v <= RECORDS; v++) {
+            Array source = v == INT_PAIRS ? pairs : (v == DOUBLE_PAIRS ? double_pairs : records);
+            printf(" %9.1f", measure(source, n, v, false));
+            printf(" %9.1f", measure(source, n, v, true));
+            fflush(stdout);
+        }
+        printf("\n");
+        a_free(pairs);
+        a_free(double_pairs);
+        a_free(records);
+    }
+    return 0;
+}
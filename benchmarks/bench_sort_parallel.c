@@ -0,0 +1,119 @@
+/*
+Compile: make bench_sort_parallel bench_sort_parallel_release
+Run: ./bench_sort_parallel && ./bench_sort_parallel_release
+make bench_sort_parallel bench_sort_parallel_release && ./bench_sort_parallel && ./bench_sort_parallel_release
+
+Scaling of the parallel sorts. Sorts random arrays with ia_sort_parallel, 
+da_sort_parallel, sa_sort_parallel, and a_sort_parallel (IntPair by i) 
+with 1, 2, 4, ... threads, up to twice the number of processors. Reports 
+wall clock time, speedup over 1 thread, and whether the result is 
+identical to the sequential sort (ia_sort, da_sort, sa_sort, 
+a_sort_stable). The optional arguments set the number of elements 
+(default 10M, 1M for strings) and the maximum number of threads, e.g., 
+./bench_sort_parallel_release 100000000 16.
+*/
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include <unistd.h> // sysconf
+#include "base.h"
+
+typedef enum { INTS, DOUBLES, STRINGS, INT_PAIRS } Variant;
+
+static const char *variant_names[] = { "ia_sort_parallel", "da_sort_parallel", 
+    "sa_sort_parallel", "a_sort_parallel" };
+
+static CmpResult compare_i(ConstAny a, ConstAny b) {
+    int x = ((IntPair*)a)->i;
+    int y = ((IntPair*)b)->i;
+    return (x < y) ? LT : ((x > y) ? GT : EQ);
+}
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1.0e6;
+}
+
+static Array create_input(Variant v, int n) {
+    Array a = NULL;
+    switch (v) {
+        case INTS:
+            a = ia_create(n, 0);
+            for (int i = 0; i < n; i++) ia_set(a, i, (int)(((unsigned)rand() << 16) ^ (unsigned)rand()));
+            break;
+        case DOUBLES:
+            a = da_create(n, 0);
+            for (int i = 0; i < n; i++) da_set(a, i, d_rnd(2.0) - 1.0);
+            break;
+        case STRINGS:
+            a = sa_create(n, NULL);
+            for (int i = 0; i < n; i++) sa_set(a, i, s_of_int(rand()));
+            break;
+        case INT_PAIRS:
+            a = a_create(n, sizeof(IntPair));
+            for (int i = 0; i < n; i++) {
+                IntPair p = { i_rnd(n / 4 + 1), i };
+                a_set(a, i, &p);
+            }
+            break;
+    }
+    return a;
+}
+
+static void sort_sequential(Variant v, Array a) {
+    switch (v) {
+        case INTS: ia_sort(a); break;
+        case DOUBLES: da_sort(a); break;
+        case STRINGS: sa_sort(a); break;
+        case INT_PAIRS: a_sort_stable(a, compare_i); break;
+    }
+}
+
+static void sort_parallel(Variant v, Array a, int threads) {
+    switch (v) {
+        case INTS: ia_sort_parallel(a, threads); break;
+        case DOUBLES: da_sort_parallel(a, threads); break;
+        case STRINGS: sa_sort_parallel(a, threads); break;
+        case INT_PAIRS: a_sort_parallel(a, compare_i, threads); break;
+    }
+}
+
+static bool identical(Variant v, Array a, Array b) {
+    if (v != STRINGS) return memcmp(a->a, b->a, (size_t)a->n * a->s) == 0;
+    for (int i = 0; i < a->n; i++) {
+        if (!s_equals(sa_get(a, i), sa_get(b, i))) return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 2 ? atoi(argv[2]) : 2 * (processors > 0 ? (int)processors : 1);
+    printf("%ld processors\n", processors);
+
+    for (Variant v = INTS; v <= INT_PAIRS; v++) {
+        int m = v == STRINGS && argc <= 1 ? n / 10 : n;
+        printf("%s, n = %d\n", variant_names[v], m);
+        printf("%8s %10s %10s %10s\n", "threads", "ms", "speedup", "identical");
+        Array input = create_input(v, m);
+        Array expected = a_copy(input);
+        sort_sequential(v, expected);
+        double base_ms = 0;
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            Array a = a_copy(input);
+            double t = now_ms();
+            sort_parallel(v, a, threads);
+            t = now_ms() - t;
+            if (threads == 1) base_ms = t;
+            printf("%8d %10.1f %10.2f %10s\n", threads, t, base_ms / t, 
+                    identical(v, a, expected) ? "yes" : "NO");
+            a_free(a);
+        }
+        a_free(expected);
+        if (v == STRINGS) sa_free(input); else a_free(input);
+    }
+    return 0;
+}
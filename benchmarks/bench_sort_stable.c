@@ -0,0 +1,119 @@
+/*
+Compile: make bench_sort_stable bench_sort_stable_release
+Run: ./bench_sort_stable && ./bench_sort_stable_release
+make bench_sort_stable bench_sort_stable_release && ./bench_sort_stable && ./bench_sort_stable_release
+
+Compares a_sort (qsort, not stable) to a_sort_stable (natural merge sort) 
+for arrays of IntPair ordered by i, and l_sort to l_sort_stable and 
+l_sort_inplace (which relinks the nodes instead of copying) for lists, on 
+random, sorted, reverse-sorted, and nearly sorted input (sorted with 1% 
+of the elements swapped with a random other element). The keys have 
+duplicates. Prints million elements sorted per second.
+*/
+
+#include "base.h"
+
+#define TOTAL 10000000 // elements sorted per size, input, and variant
+#define POOL 1000000 // small arrays are taken from a pool of elements
+
+static CmpResult compare_i(ConstAny a, ConstAny b) {
+    int x = ((IntPair*)a)->i;
+    int y = ((IntPair*)b)->i;
+    return (x < y) ? LT : ((x > y) ? GT : EQ);
+}
+
+typedef enum { RANDOM, SORTED, REVERSED, NEARLY_SORTED } Input;
+
+static const char *input_names[] = { "random", "sorted", "reversed", "nearly" };
+
+// Fills the pool with m elements of the given input kind. Slices of 
+// consecutive elements of the pool have the same kind.
+static void fill(Array pool, Input input) {
+    int m = a_length(pool);
+    IntPair *p = pool->a;
+    for (int i = 0; i < m; i++) {
+        p[i].i = input == RANDOM ? i_rnd(m / 4) : (input == REVERSED ? (m - i) / 4 : i / 4);
+        p[i].j = i;
+    }
+    if (input == NEARLY_SORTED) {
+        for (int k = 0; k < m / 100; k++) {
+            int x = i_rnd(m), y = i_rnd(m);
+            IntPair t = p[x]; p[x] = p[y]; p[y] = t;
+        }
+    }
+}
+
+// Sorts copies of n consecutive elements of the pool, each repetition at a 
+// different position. Returns million elements per second.
+static double measure_array(Array pool, int n, bool stable) {
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    int positions = a_length(pool) - n + 1;
+    Array a = a_sub(pool, 0, n);
+    clock_t total = 0;
+    for (int r = 0; r < reps; r++) {
+        Byte *slice = (Byte*)pool->a + (size_t)((long)r * n % positions) * pool->s;
+        memcpy(a->a, slice, (size_t)n * pool->s);
+        clock_t t = clock();
+        if (stable) a_sort_stable(a, compare_i); else a_sort(a, compare_i);
+        total += clock() - t;
+    }
+    a_free(a);
+    double seconds = (double)total / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+typedef enum { L_SORT, L_SORT_STABLE, L_SORT_INPLACE } ListSort;
+
+// Like measure_array, for a list of n elements. For l_sort and l_sort_stable 
+// includes copying the result into a new list.
+static double measure_list(Array pool, int n, ListSort sort) {
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    int positions = a_length(pool) - n + 1;
+    clock_t total = 0;
+    for (int r = 0; r < reps; r++) {
+        int offset = (int)((long)r * n % positions);
+        List list = l_create(sizeof(IntPair));
+        for (int i = 0; i < n; i++) {
+            l_append(list, a_get(pool, offset + i));
+        }
+        clock_t t = clock();
+        List sorted = NULL;
+        switch (sort) {
+            case L_SORT: sorted = l_sort(list, compare_i); break;
+            case L_SORT_STABLE: sorted = l_sort_stable(list, compare_i); break;
+            case L_SORT_INPLACE: l_sort_inplace(list, compare_i); break;
+        }
+        total += clock() - t;
+        l_free(sorted);
+        l_free(list);
+    }
+    double seconds = (double)total / CLOCKS_PER_SEC;
+    return seconds > 0 ? (double)n * reps / seconds / 1e6 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+
+    for (int n = 100; n <= 1000000; n *= 100) {
+        printf("n = %d\n", n);
+        printf("%10s %19s %29s\n", "", "array", "list");
+        printf("%10s %9s %9s %9s %9s %9s   (Melements/s)\n", "input", 
+                "a_sort", "stable", "l_sort", "stable", "inplace");
+        int m = n < POOL ? POOL : n;
+        Array pool = a_create(m, sizeof(IntPair));
+        for (Input input = RANDOM; input <= NEARLY_SORTED; input++) {
+            fill(pool, input);
+            printf("%10s", input_names[input]);
+            printf(" %9.1f", measure_array(pool, n, false));
+            printf(" %9.1f", measure_array(pool, n, true));
+            fflush(stdout);
+            printf(" %9.1f", measure_list(pool, n, L_SORT));
+            printf(" %9.1f", measure_list(pool, n, L_SORT_STABLE));
+            printf(" %9.1f", measure_list(pool, n, L_SORT_INPLACE));
+            printf("\n");
+        }
+        a_free(pool);
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+Compile: make bench_threads bench_threads_release
+Run: ./bench_threads && ./bench_threads_release
+make bench_threads bench_threads_release && ./bench_threads && ./bench_threads_release
+
+Stress test for the thread-safe runtime. N threads each build and free 
+lists, arrays, and strings (the same amount of work per thread). Reports 
+wall clock time and throughput for N = 1, 2, 4, 8. With perfect scaling the 
+throughput grows linearly up to the number of cores. At exit, the tracked 
+variant reports any blocks that were lost in the process.
+*/
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include <pthread.h>
+#include "base.h"
+
+#define ROUNDS 20000
+
+static void *work(void *arg) {
+    int *sum = arg;
+    for (int r = 0; r < ROUNDS; r++) {
+        List list = il_range(0, 64);
+        List words = sl_split("alpha beta gamma delta epsilon", ' ');
+        String s = s_join(words, ',');
+        Array array = ia_range(0, 64);
+        *sum += il_get(list, r % 64) + s_length(s) + ia_get(array, r % 64) + i_rnd(2);
+        l_free(list);
+        sl_free(words);
+        s_free(s);
+        a_free(array);
+    }
+    return NULL;
+}
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1.0e6;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    printf("%8s %10s %14s %10s\n", "threads", "ms", "rounds/s", "speedup");
+    double base_rate = 0;
+    for (int n = 1; n <= 8; n *= 2) {
+        pthread_t threads[8];
+        int sums[8] = { 0 };
+        double t = now_ms();
+        for (int i = 0; i < n; i++) {
+            pthread_create(&threads[i], NULL, work, &sums[i]);
+        }
+        for (int i = 0; i < n; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        t = now_ms() - t;
+        double rate = n * ROUNDS / (t / 1000.0);
+        if (n == 1) base_rate = rate;
+        printf("%8d %10.1f %14.0f %10.2f\n", n, t, rate, rate / base_rate);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+Compile: make bench_unrolled_list bench_unrolled_list_release
+Run: ./bench_unrolled_list && ./bench_unrolled_list_release
+make bench_unrolled_list bench_unrolled_list_release && ./bench_unrolled_list && ./bench_unrolled_list_release
+
+Compares the unrolled list of ints (UList, 64 ints per chunk) to the int list
+(List, one node per int): appending n elements, iterating over them (one by
+one, and for UList also chunk by chunk with ul_next_chunk), indexed
+access in order, inserting and removing at random indices (each takes O(n)
+time for both, as the position has to be found), and the bytes per element
+(see l_footprint and ul_footprint). Prints million elements (or operations)
+per second.
+*/
+
+#include "base.h"
+
+#define TOTAL 20000000 // elements accessed per size and variant
+#define UPDATES 2000000 // elements skipped by random inserts and removes per size
+
+typedef enum { APPEND, ITERATE, CHUNKS, GET, INSERT_REMOVE, VARIANTS } Variant;
+
+static const char *variant_names[] = { "append", "iterate", "chunks", "get", "insert/rem" };
+
+// Runs the variant on the list (unrolled or not) with n elements, returns
+// million elements or operations per second. The elements are summed into
+// sink, such that the loops are not optimized away.
+static double measure(Variant v, bool unrolled, int n, long *sink) {
+    List list = il_create();
+    UList ulist = uil_create();
+    for (int i = 0; i < n; i++) {
+        if (unrolled) uil_append(ulist, i); else il_append(list, i);
+    }
+    int reps = n >= TOTAL ? 1 : TOTAL / n;
+    int updates = UPDATES / n < 100 ? 100 : UPDATES / n;
+    long count = 0;
+    clock_t t = clock();
+    for (int r = 0; r < reps && count < TOTAL; r++) {
+        switch (v) {
+            case APPEND: {
+                List a = il_create();
+                UList b = uil_create();
+                for (int i = 0; i < n; i++) {
+                    if (unrolled) uil_append(b, i); else il_append(a, i);
+                }
+                *sink += unrolled ? ul_length(b) : l_length(a);
+                l_free(a);
+                ul_free(b);
+                count += n;
+                break;
+            }
+            case ITERATE:
+                if (unrolled) {
+                    UListIterator iter = ul_iterator(ulist);
+                    while (ul_has_next(iter)) *sink += uil_next(&iter);
+                } else {
+                    ListIterator iter = l_iterator(list);
+                    while (l_has_next(iter)) *sink += il_next(&iter);
+                }
+                count += n;
+                break;
+            case CHUNKS: {
+                UListIterator iter = ul_iterator(ulist);
+                while (ul_has_next(iter)) {
+                    int k;
+                    int *a = ul_next_chunk(&iter, &k);
+                    for (int i = 0; i < k; i++) *sink += a[i];
+                }
+                count += n;
+                break;
+            }
+            case GET:
+                for (int i = 0; i < n; i++) {
+                    *sink += unrolled ? uil_get(ulist, i) : il_get(list, i);
+                }
+                count += n;
+                break;
+            case INSERT_REMOVE:
+                for (int i = 0; i < updates; i++) {
+                    int index = i_rnd(n);
+                    if (unrolled) {
+                        uil_insert(ulist, index, i);
+                        ul_remove(ulist, i_rnd(n + 1));
+                    } else {
+                        il_insert(list, index, i);
+                        l_remove(list, i_rnd(n + 1));
+                    }
+                }
+                count += 2 * updates;
+                r = reps; // once per size
+                break;
+            default: break;
+        }
+    }
+    double seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    l_free(list);
+    ul_free(ulist);
+    return seconds > 0 ? count / seconds / 1e6 : 0;
+}
+
+// Returns the bytes per element of a list (unrolled or not) with n elements.
+static double bytes_per_element(bool unrolled, int n) {
+    List list = il_create();
+    UList ulist = uil_create();
+    for (int i = 0; i < n; i++) {
+        if (unrolled) uil_append(ulist, i); else il_append(list, i);
+    }
+    Footprint f = unrolled ? ul_footprint(ulist) : l_footprint(list);
+    l_free(list);
+    ul_free(ulist);
+    return (double)(f.payload + f.structure + f.tracker) / n;
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    long sink = 0;
+    printf("%10s", "n");
+    for (Variant v = 0; v < VARIANTS; v++) printf(" %21s", variant_names[v]);
+    printf(" %21s\n", "bytes/element");
+    printf("%10s", "");
+    for (Variant v = 0; v <= VARIANTS; v++) printf(" %10s %10s", "List", "UList");
+    printf("   (Melements/s)\n");
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        printf("%10d", n);
+        for (Variant v = 0; v < VARIANTS; v++) {
+            if (v == CHUNKS) {
+                printf(" %10s", "-");
+            } else {
+                printf(" %10.2f", measure(v, false, n, &sink));
+            }
+            printf(" %10.2f", measure(v, true, n, &sink));
+            fflush(stdout);
+        }
+        printf(" %10.2f %10.2f\n", bytes_per_element(false, n), bytes_per_element(true, n));
+    }
+    printf("(%ld)\n", sink);
+    return 0;
+}
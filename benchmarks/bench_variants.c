@@ -0,0 +1,64 @@
+/*
+Compile: make bench_variants bench_variants_release
+Run: ./bench_variants && ./bench_variants_release
+make bench_variants bench_variants_release && ./bench_variants && ./bench_variants_release
+
+Runs list- and string-heavy workloads. bench_variants is linked with 
+libprog1.a (allocation tracking), bench_variants_release with 
+libprog1_release.a (no tracking, no garbage fill; build with "make release" 
+in ../lib).
+*/
+
+#include "base.h"
+
+#define N 1000000
+
+static int times_3(int value, int index, int x) {
+    return 3 * value;
+}
+
+static void int_list_workload(void) {
+    List a = il_range(0, N);
+    List b = il_map(a, times_3, 0);
+    List c = l_reverse(b);
+    l_free(a);
+    l_free(b);
+    l_free(c);
+}
+
+static void string_list_workload(void) {
+    for (int i = 0; i < N / 10; i++) {
+        List words = sl_split("alpha beta gamma delta epsilon zeta eta theta", ' ');
+        String s = s_join(words, ',');
+        sl_free(words);
+        words = sl_of_string(s);
+        sl_append(words, s_of_int(i));
+        sl_free(words);
+        s_free(s);
+    }
+}
+
+static void string_workload(void) {
+    String s = s_repeat(1000, 'x');
+    for (int i = 0; i < N; i++) {
+        String t = s_sub(s, i % 100, i % 100 + 20);
+        s_free(t);
+    }
+    s_free(s);
+}
+
+static void run(String name, void (*workload)(void)) {
+    clock_t t = clock();
+    workload();
+    t = clock() - t;
+    printf("%-22s %10.1f ms\n", name, t * 1000.0 / CLOCKS_PER_SEC);
+}
+
+int main(int argc, char *argv[]) {
+    report_memory_leaks(true);
+    printsln(argv[0]);
+    run("int list workload", int_list_workload);
+    run("string list workload", string_list_workload);
+    run("string workload", string_workload);
+    return 0;
+}
@@ -4,10 +4,18 @@
 @copyright Apache License, Version 2.0
 */
 
+#define _DEFAULT_SOURCE // sysconf
 #include "array.h"
+#include "array_sort.h"
 #include "int_array.h"
 #include "list.h"
 #include "string.h"
+#include <limits.h> // INT_MAX
+#include <stdint.h> // uint32_t, uint64_t
+#ifndef NO_THREADS
+#include <pthread.h>
+#include <unistd.h> // sysconf
+#endif
 
 
 
@@ -54,16 +62,164 @@ static void a_create_test(void) {
     a_free(a);
 }
 
-Array a_create(int n, int s) {
+/*
+ * An array is a single block: the head fills the first cache line, the 
+ * elements follow inline. Blocks of large arrays are cache line aligned, so 
+ * their elements are, too. Small arrays are only 16-byte aligned, because 
+ * aligned allocation costs several times as much as a plain malloc. If the 
+ * array outgrows its block (a_reserve, a_push, etc.), the elements move to a 
+ * separate block, while the head stays in place.
+ */
+#define A_HEAD_SIZE 64
+#define A_ALIGN_MIN 256 // minimum number of element bytes for an aligned block
+#define A_INLINE_DATA(array) ((Byte*)(array) + A_HEAD_SIZE)
+
+static bool a_is_inline(Array array) {
+    return array->base == NULL && array->a == A_INLINE_DATA(array);
+}
+
+Array a_alloc_file_line(const char *file, const char *function, int line, int n, int s, bool clear) {
     require("non-negative length", n >= 0);
     require("positive size", s > 0);
-    Array result = xmalloc(sizeof(ArrayHead));
+    require_x("array smaller than 2 GB", (size_t)n * s <= INT_MAX, "n == %d, s == %d", n, s);
+    size_t size = A_HEAD_SIZE + (size_t)n * s;
+    Array result;
+    if ((size_t)n * s < A_ALIGN_MIN) {
+        result = clear ? base_calloc(file, function, line, 1, size) 
+                       : base_malloc(file, function, line, size);
+    } else {
+        result = clear ? base_calloc_aligned(file, function, line, 1, size) 
+                       : base_malloc_aligned(file, function, line, size);
+    }
     result->n = n;
     result->s = s;
-    result->a = xcalloc(n, s);
+    result->a = A_INLINE_DATA(result);
+    result->c = n;
+    result->base = NULL;
+    result->share = NULL;
     return result;
 }
 
+Array a_create(int n, int s) {
+    require("non-negative length", n >= 0);
+    require("positive size", s > 0);
+    return a_alloc(n, s, true);
+}
+
+static void a_aligned_test(void) {
+    printsln((String)__func__);
+    Array a = a_create(3, sizeof(Address));
+    test_equal_i((size_t)a->a % 16, 0); // small arrays are 16-byte aligned
+    a_free(a);
+    a = a_create(100, sizeof(Address));
+    test_equal_i((size_t)a->a % 64, 0);
+    Array b = a_sub(a, 1, 50);
+    test_equal_i((size_t)b->a % 64, 0);
+    a_free(b);
+
+    // growing and shrinking keep the alignment
+    a_reserve(a, 1000);
+    test_equal_i((size_t)a->a % 64, 0);
+    a_shrink_to_fit(a);
+    test_equal_i((size_t)a->a % 64, 0);
+    a_free(a);
+    Byte *p = xmalloc_aligned(10);
+    p = xrealloc(p, 1000);
+    test_equal_i((size_t)p % 64, 0);
+    p = xrealloc(p, 10);
+    test_equal_i((size_t)p % 64, 0);
+    free(p);
+
+    // also inside an arena and in sampling mode
+    Arena arena = arena_create(1000);
+    arena_enter(arena);
+    a = a_create(300, sizeof(char));
+    b = a_create(300, sizeof(char));
+    test_equal_i((size_t)a->a % 64, 0);
+    test_equal_i((size_t)b->a % 64, 0);
+    arena_leave();
+    arena_free(arena);
+
+    sample_allocations(1 << 20); // most blocks have no sample point
+    p = xmalloc(10); // freed after sampling mode ends
+    a = a_create(300, sizeof(char));
+    test_equal_i((size_t)a->a % 64, 0);
+    a_reserve(a, 1000);
+    test_equal_i((size_t)a->a % 64, 0);
+    a_shrink_to_fit(a);
+    test_equal_i((size_t)a->a % 64, 0);
+    a_free(a);
+    sample_allocations(0);
+    p = xrealloc(p, 1000);
+#ifndef NO_MEMORY_TRACKING
+    test_equal_b(memory_footprint(p, 1000).tracker > 0, true); // recognised although not sampled
+#endif
+    free(p);
+
+    use_huge_pages(true);
+    a = a_create(1 << 20, sizeof(int));
+    test_equal_i((size_t)a->a % 64, 0);
+    a_free(a);
+    use_huge_pages(false);
+}
+
+static void a_inline_test(void) {
+    printsln((String)__func__);
+    Array a = ia_of_string("1, 2, 3");
+    test_equal_b(a->a == (Byte*)a + 64, true);
+    Array b = a_sub(a, 0, 3);
+    test_equal_b(b->a == (Byte*)b + 64, true);
+    a_free(b);
+    // growing moves the elements out of the head block
+    ia_push(a, 4);
+    test_equal_b(a->a == (Byte*)a + 64, false);
+    b = ia_of_string("1, 2, 3, 4");
+    ia_test_equal(a, b);
+    a_free(b);
+    // inline elements are not shrunk
+    b = ia_of_string("1, 2, 3");
+    ia_pop(b);
+    a_shrink_to_fit(b);
+    test_equal_i(a_capacity(b), 3);
+    test_equal_i(a_length(b), 2);
+    a_free(b);
+    a_free(a);
+}
+
+static void a_footprint_test(void) {
+    printsln((String)__func__);
+    Array a = a_create(10, sizeof(int));
+    Footprint f = a_footprint(a);
+    Footprint block = memory_footprint(a, 10 * sizeof(int));
+    test_equal_i(f.payload, 10 * sizeof(int));
+    test_equal_i(f.structure, block.structure);
+    test_equal_i(f.tracker, block.tracker);
+    test_equal_b(f.structure >= 64, true); // head
+    
+    // elements in a separate block
+    a_reserve(a, 20);
+    f = a_footprint(a);
+    Footprint head = memory_footprint(a, 0);
+    Footprint elements = memory_footprint(a->a, 10 * sizeof(int));
+    test_equal_i(f.payload, 10 * sizeof(int));
+    test_equal_i(f.structure, head.structure + elements.structure);
+    test_equal_i(f.tracker, head.tracker + elements.tracker);
+    test_equal_b(elements.structure >= 10 * sizeof(int), true); // unused capacity
+    test_equal_i(head.payload, 0);
+    a_free(a);
+
+    // arena blocks have no tracking header
+    Arena arena = arena_create(1000);
+    arena_enter(arena);
+    a = a_create(10, sizeof(int));
+    f = a_footprint(a);
+    test_equal_i(f.payload, 10 * sizeof(int));
+    test_equal_i(f.tracker, 0);
+    test_equal_b(f.structure >= sizeof(ArrayHead), true);
+    arena_leave();
+    arena_free(arena);
+}
+
 static void a_of_buffer_test(void) {
     printsln((String)__func__);
     Address addr[] = {
@@ -98,10 +254,7 @@ Array a_of_buffer(Any buffer, int n, int s) {
     require_not_null(buffer);
     require("non-negative length", n >= 0);
     require("positive size", s > 0);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = s;
-    result->a = xmalloc(n * s);
+    Array result = a_alloc(n, s, false);
     memcpy(result->a, buffer, n * s);
     return result;
 }
@@ -145,15 +298,12 @@ Array a_fn(int n, int s, AnyFn init, Any state) {
     require("positive size", s > 0);
     require_not_null(init);
     AnyIntAnyToVoid f = init;
-    Byte *a = xcalloc(n, s);
+    Array result = a_alloc(n, s, true);
+    Byte *a = result->a;
     for (int i = 0; i < n; i++) {
         Any element = a + i * s;
         f(element, i, state);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = s;
-    result->a = a;
     return result;
 }
 
@@ -227,18 +377,255 @@ static void a_copy_test(void) {
     a_free(copy);
 }
 
+/*
+ * Copy-on-write. a_copy_shared lets the copy share the elements of the array. The 
+ * shared elements are described by an ArrayShare record that counts the 
+ * arrays holding them. An array uses the shared elements as long as its 
+ * element pointer equals share->data. Before an array modifies its elements, 
+ * a_unshare copies them to a new block, unless no other array holds them. 
+ * 
+ * If the elements are inline in the head block of the original array, that 
+ * block must live until the last holder lets go. Thus the original remains 
+ * a holder even after it has copied its elements, and a_free keeps its head 
+ * block if other arrays still share the elements in it.
+ */
+typedef struct ArrayShare {
+    int refs; // number of arrays holding the shared elements
+    bool viewed; // the elements have views, they must not be shared
+    Any data; // the shared elements
+    Any block; // the block to free when the last holder lets go
+    Array owner; // the array that owned the elements before they were shared, NULL once it has let go
+} ArrayShare;
+
+static long a_shared_copies; // number of copies that shared the elements
+static long a_made_copies; // number of shared copies that had to be made on write
+
+static bool a_is_shared(Array array) {
+    return array->share != NULL && array->a == array->share->data;
+}
+
+static ArrayShare *a_share_new(Array array) {
+    ArrayShare *share = xmalloc(sizeof(ArrayShare));
+    share->refs = 1;
+    share->viewed = false;
+    share->data = array->a;
+    share->block = a_is_inline(array) ? (Any)array : array->a;
+    share->owner = array;
+    return share;
+}
+
+// Lets go of the shared elements. Returns true iff the head block of array 
+// has to stay, because it holds elements that other arrays still share. 
+// Once refs is decremented, another holder may free the record, so it is 
+// only touched afterwards by the last holder.
+static bool a_release(Array array) {
+    ArrayShare *share = array->share;
+    array->share = NULL;
+    Any block = share->block; // does not change
+    Array owner = array;
+    __atomic_compare_exchange_n(&share->owner, &owner, NULL, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    if (__atomic_sub_fetch(&share->refs, 1, __ATOMIC_ACQ_REL) > 0) {
+        return block == (Any)array;
+    }
+    if (block != (Any)array) free(block);
+    free(share);
+    return false;
+}
+
+// Moves the elements of a sharing array to a new block of the given capacity.
+static void a_move_shared(Array array, int capacity) {
+    if (__atomic_load_n(&array->share->refs, __ATOMIC_ACQUIRE) > 1) {
+        __atomic_add_fetch(&a_made_copies, 1, __ATOMIC_RELAXED);
+    }
+    size_t size = (size_t)capacity * array->s;
+    Any a = size < A_ALIGN_MIN ? xmalloc(size) : xmalloc_aligned(size);
+    memcpy(a, array->a, (size_t)array->n * array->s);
+    array->a = a;
+    array->c = capacity;
+    if (array->share->block == (Any)array) {
+        __atomic_store_n(&array->share->owner, NULL, __ATOMIC_RELAXED); // keeps holding its head block
+    } else {
+        a_release(array);
+    }
+}
+
+void a_unshare_elements(Array array) {
+    require_not_null(array);
+    if (a_is_shared(array) && __atomic_load_n(&array->share->refs, __ATOMIC_ACQUIRE) > 1) {
+        a_move_shared(array, array->c);
+    }
+}
+
+long a_copies_avoided(void) {
+    return __atomic_load_n(&a_shared_copies, __ATOMIC_RELAXED) 
+            - __atomic_load_n(&a_made_copies, __ATOMIC_RELAXED);
+}
+
+void a_print_copy_stats(void) {
+    long shared = __atomic_load_n(&a_shared_copies, __ATOMIC_RELAXED);
+    long made = __atomic_load_n(&a_made_copies, __ATOMIC_RELAXED);
+    fprintf(stderr, "a_copy_shared: %ld shared, %ld copied on write, %ld copies avoided\n", 
+            shared, made, shared - made);
+}
+
 Array a_copy(Array array) {
     require_not_null(array);
     int n = array->n * array->s;
-    Any a = xmalloc(n);
+    Array result = a_alloc(array->n, array->s, false);
+    Any a = result->a;
     memcpy(a, array->a, n);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = array->s;
-    result->a = a;
     return result;
 }
 
+Array a_copy_shared(Array array) {
+    require_not_null(array);
+#ifndef NO_COPY_ON_WRITE
+    if (array->base == NULL && (array->share == NULL || (a_is_shared(array) && !array->share->viewed))) {
+        if (array->share == NULL) array->share = a_share_new(array);
+        __atomic_add_fetch(&array->share->refs, 1, __ATOMIC_ACQ_REL);
+        Array result = xmalloc(sizeof(ArrayHead));
+        result->n = array->n;
+        result->s = array->s;
+        result->a = array->a;
+        result->c = array->n;
+        result->base = NULL;
+        result->share = array->share;
+        __atomic_add_fetch(&a_shared_copies, 1, __ATOMIC_RELAXED);
+        return result;
+    }
+#endif
+    return a_copy(array);
+}
+
+#ifndef NO_THREADS
+static void *a_free_worker(void *array) {
+    a_free(array);
+    return NULL;
+}
+#endif
+
+static void a_copy_on_write_test(void) {
+    printsln((String)__func__);
+    Array a, c, ex;
+    long avoided = a_copies_avoided();
+
+    // a_copy copies right away, writing through a_get does not change the original
+    a = ia_of_string("1, 2, 3");
+    c = a_copy(a);
+    test_equal_b(c->a == a->a, false);
+    *(int*)a_get(c, 0) = 99;
+    test_equal_i(ia_get(a, 0), 1);
+    a_free(c);
+    a_free(a);
+
+    // the shared copy shares the elements until it is modified
+    a = ia_of_string("1, 2, 3");
+    c = a_copy_shared(a);
+    test_equal_b(c->a == a->a, true);
+    ia_test_equal(c, a);
+    ia_set(c, 0, 9);
+    test_equal_b(c->a == a->a, false);
+    test_equal_i(ia_get(a, 0), 1);
+    test_equal_i(ia_get(c, 0), 9);
+    a_free(c);
+    a_free(a);
+    test_equal_i(a_copies_avoided(), avoided);
+
+    // modifying the original copies, too
+    a = ia_of_string("1, 2, 3");
+    c = a_copy_shared(a);
+    ia_fill(a, 0);
+    ex = ia_of_string("1, 2, 3");
+    ia_test_equal(c, ex);
+    a_free(a);
+    ia_sort(c); // the last holder need not copy
+    ia_test_equal(c, ex);
+    a_free(ex);
+    a_free(c);
+
+    // the copy outlives the original, whose head block holds the elements
+    a = ia_of_string("3, 1, 2");
+    c = a_copy_shared(a);
+    Array c2 = a_copy_shared(c);
+    a_free(a);
+    ia_push(c, 4);
+    ex = ia_of_string("3, 1, 2, 4");
+    ia_test_equal(c, ex);
+    a_free(ex);
+    ex = ia_of_string("3, 1, 2");
+    ia_test_equal(c2, ex);
+    a_free(ex);
+    a_free(c);
+    a_free(c2);
+    test_equal_i(a_copies_avoided(), avoided + 1);
+
+    // copies that are never modified are avoided
+    a = da_of_string("1.5, 2.5");
+    c = a_copy_shared(a);
+    test_within_d(da_get(c, 1), 2.5, EPSILON);
+    a_free(a);
+    a_free(c);
+    test_equal_i(a_copies_avoided(), avoided + 2);
+
+    // string arrays share the string pointers
+    a = sa_of_string("a, b");
+    c = a_copy_shared(a);
+    sa_set(c, 1, "x");
+    test_equal_s(sa_get(a, 1), "b");
+    test_equal_s(sa_get(c, 1), "x");
+    a_free(c);
+    sa_free(a);
+
+    // arrays with views are copied right away
+    a = ia_of_string("1, 2, 3");
+    Array v = a_view(a, 0, 2);
+    c = a_copy_shared(a);
+    test_equal_b(c->a == a->a, false);
+    ia_set(v, 0, 9);
+    test_equal_i(ia_get(c, 0), 1);
+    a_free(v);
+    a_free(c);
+    a_free(a);
+
+    // writing through a_get after a_unshare_elements
+    a = ia_of_string("1, 2, 3");
+    c = a_copy_shared(a);
+    a_unshare_elements(c);
+    *(int*)a_get(c, 0) = 99;
+    test_equal_i(ia_get(a, 0), 1);
+    a_free(c);
+    a_free(a);
+
+    // views of copies see their own elements
+    a = ia_of_string("1, 2, 3");
+    c = a_copy_shared(a);
+    v = a_view(c, 1, 3);
+    ia_fill(v, 0);
+    test_equal_i(ia_get(a, 1), 2);
+    test_equal_i(ia_get(c, 1), 0);
+    a_free(v);
+    a_free(c);
+    a_free(a);
+
+#ifndef NO_THREADS
+    // holders let go in parallel, the last one frees the elements
+    for (int r = 0; r < 200; r++) {
+        a = ia_range(0, 100);
+        Array copies[4];
+        pthread_t ids[4];
+        bool started[4];
+        for (int i = 0; i < 4; i++) copies[i] = a_copy_shared(a);
+        for (int i = 0; i < 4; i++) {
+            started[i] = pthread_create(&ids[i], NULL, a_free_worker, copies[i]) == 0;
+        }
+        a_free(a);
+        for (int i = 0; i < 4; i++) {
+            if (started[i]) pthread_join(ids[i], NULL); else a_free(copies[i]);
+        }
+    }
+#endif
+}
+
 static void print_int_pair(IntPair *element) {
     printf("(%d, %d)", element->i, element->j);
 }
@@ -359,26 +746,105 @@ static void a_sub_test(void) {
 Array a_sub(Array array, int i, int j) {
     require_not_null(array);
     if (i >= j || i >= array->n || j <= 0) {
-        Array result = xmalloc(sizeof(ArrayHead));
-        result->n = 0;
-        result->s = array->s;
-        result->a = NULL;
-        return result;
+        return a_alloc(0, array->s, false);
     }
     // assert: i < j && i < array->n && j > 0
     if (i < 0) i = 0;
     if (j > array->n) j = array->n;
     int n = j - i;
-    Any a = xmalloc(n * array->s);
+    Array result = a_alloc(n, array->s, false);
+    Any a = result->a;
     Byte *p = array->a;
     memcpy(a, p + i * array->s, n * array->s);
+    return result;
+}
+
+static void a_view_test(void) {
+    printsln((String)__func__);
+    Array a = ia_of_string("1, 2, 3, 4, 5, 6");
+    Array v = a_view(a, 1, 4);
+    test_equal_b(a_is_view(v), true);
+    test_equal_b(a_is_view(a), false);
+    test_equal_i(a_length(v), 3);
+    test_equal_i(ia_get(v, 0), 2);
+    test_equal_i(ia_foldl(v, int_plus, 0), 2 + 3 + 4);
+    test_equal_i(ia_index(v, 4), 2);
+    test_equal_i(ia_index(v, 5), -1);
+    Array f = ia_filter(v, ia_gt, 2);
+    Array ex = ia_of_string("3, 4");
+    ia_test_equal(f, ex);
+    test_equal_b(a_is_view(f), false);
+    a_free(f);
+    a_free(ex);
+
+    // writing through the view modifies the viewed array
+    ia_set(v, 0, 20);
+    ia_sort_dec(v);
+    ex = ia_of_string("1, 20, 4, 3, 5, 6");
+    ia_test_equal(a, ex);
+    a_free(ex);
+
+    // views of views refer to the same elements
+    Array w = a_view(v, 1, 3);
+    test_equal_b(w->base == a, true);
+    ia_fill(w, 0);
+    ex = ia_of_string("1, 20, 0, 0, 5, 6");
+    ia_test_equal(a, ex);
+    a_free(ex);
+    a_free(w);
+
+    // empty views, would violate precondition:
+    // a_view(a, 2, 1);
+    w = a_view(a, 6, 6);
+    test_equal_i(a_length(w), 0);
+    a_free(w);
+
+    // growing a view copies its elements, the view becomes independent
+    ia_push(v, 7);
+    test_equal_b(a_is_view(v), false);
+    ex = ia_of_string("20, 0, 0, 7");
+    ia_test_equal(v, ex);
+    a_free(ex);
+    ex = ia_of_string("1, 20, 0, 0, 5, 6");
+    ia_test_equal(a, ex);
+    a_free(ex);
+    a_free(v);
+    a_free(a);
+
+    // views of string arrays do not own the strings
+    a = sa_of_string("a, b, c");
+    v = a_view(a, 0, 2);
+    test_equal_b(sa_contains(v, "b"), true);
+    test_equal_b(sa_contains(v, "c"), false);
+    sa_free(v);
+    test_equal_s(sa_get(a, 1), "b");
+    sa_free(a);
+}
+
+Array a_view(Array array, int i, int j) {
+    require_not_null(array);
+    require_x("valid range", 0 <= i && i <= j && j <= array->n, "i == %d, j == %d, length == %d", i, j, array->n);
+    if (array->base == NULL) {
+        // the view modifies the elements in place, so they must not be shared
+        a_unshare(array);
+        if (array->share == NULL) array->share = a_share_new(array);
+        if (a_is_shared(array)) array->share->viewed = true;
+    }
     Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
+    result->n = j - i;
     result->s = array->s;
-    result->a = a;
+    result->a = (Byte*)array->a + i * array->s;
+    result->c = result->n;
+    result->base = array->base != NULL ? array->base : array;
+    result->share = NULL;
     return result;
 }
 
+bool a_is_view(Array array) {
+    require_not_null(array);
+    return array->base != NULL;
+}
+
 Array a_of_l(List list) {
     require_not_null(list);
     int n = l_length(list);
@@ -533,6 +999,7 @@ void a_blit(Array source, int source_index, Array destination, int destination_i
             "source_index + count == %d, source->n == %d", source_index + count, source->n);
     require_x("(destination_index + count) in range", destination_index + count <= destination->n, 
             "destination_index + count == %d, destination->n == %d", destination_index + count, destination->n);
+    a_unshare(destination);
     Byte *src = (Byte*)source->a + source_index * source->s;
     Byte *dst = (Byte*)destination->a + destination_index * destination->s;
     memcpy(dst, src, count * source->s);
@@ -542,14 +1009,38 @@ void a_blit(Array source, int source_index, Array destination, int destination_i
 
 void a_free(Array array) {
     if (array != NULL) {
+        bool keep_head = false;
         array->n = 0;
         array->s = 0;
-        if (array->a != NULL) {
+        array->c = 0;
+        if (array->share != NULL) {
+            if (!a_is_shared(array)) free(array->a); // copied on write
+            keep_head = a_release(array);
+        } else if (array->a != NULL && array->base == NULL && !a_is_inline(array)) {
             free(array->a);
-            array->a = NULL;
         }
-        free(array);
+        array->a = NULL;
+        if (!keep_head) free(array);
+    }
+}
+
+Footprint a_footprint(Array array) {
+    require_not_null(array);
+    if (array->base != NULL) {
+        return memory_footprint(array, 0); // the elements belong to the viewed array
+    }
+    if (a_is_shared(array) && __atomic_load_n(&array->share->owner, __ATOMIC_RELAXED) != array) {
+        return memory_footprint(array, 0); // the elements belong to the original
     }
+    if (a_is_inline(array)) {
+        return memory_footprint(array, (size_t)array->n * array->s);
+    }
+    Footprint f = memory_footprint(array, 0);
+    Footprint e = memory_footprint(array->a, (size_t)array->n * array->s);
+    f.payload += e.payload;
+    f.structure += e.structure;
+    f.tracker += e.tracker;
+    return f;
 }
 
 Any a_get(Array array, int index) {
@@ -561,6 +1052,7 @@ Any a_get(Array array, int index) {
 void a_set(Array array, int index, Any value) {
     require_not_null(array);
     require_x("index in range", index >= 0 && index < array->n, "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     memcpy((Byte*)array->a + index * array->s, value, array->s);
 }
 
@@ -768,17 +1260,180 @@ Array a_concat(Array x, Array y) {
     require_not_null(y);
     require_x("equal element sizes", x->s == y->s, "x->s == %d, y->s == %d", x->s, y->s);
     int n = x->n + y->n;
-    Byte *a = xmalloc(n * x->s);
+    Array result = a_alloc(n, x->s, false);
+    Byte *a = result->a;
     memcpy(a,               x->a, x->n * x->s);
     memcpy(a + x->n * x->s, y->a, y->n * y->s);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = x->s;
-    result->a = a;
     return result;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Growable arrays
+
+static void a_push_pop_test(void) {
+    printsln((String)__func__);
+    Array a = a_create(0, sizeof(IntPair));
+    test_equal_i(a_length(a), 0);
+    for (int i = 0; i < 100; i++) {
+        IntPair p = { i, i * i };
+        a_push(a, &p);
+        test_equal_b(a_capacity(a) >= a_length(a), true);
+    }
+    test_equal_i(a_length(a), 100);
+    IntPair *p = a_get(a, 99);
+    test_equal_i(p->j, 99 * 99);
+    // growing keeps the elements aligned
+    test_equal_i((size_t)a->a % 64, 0);
+    
+    p = a_pop(a);
+    test_equal_i(p->i, 99);
+    test_equal_i(a_length(a), 99);
+    p = a_pop(a);
+    test_equal_i(p->i, 98);
+    // would violate precondition:
+    // a_pop(a_create(0, sizeof(IntPair)));
+
+    a_shrink_to_fit(a);
+    test_equal_i(a_capacity(a), 98);
+    p = a_get(a, 97);
+    test_equal_i(p->j, 97 * 97);
+    while (a_length(a) > 0) a_pop(a);
+    a_shrink_to_fit(a);
+    test_equal_i(a_capacity(a), 0);
+    IntPair q = { 1, 2 };
+    a_push(a, &q);
+    test_equal_i(((IntPair*)a_get(a, 0))->j, 2);
+    a_free(a);
+}
+
+static void a_reserve_test(void) {
+    printsln((String)__func__);
+    Array a = ia_of_string("1, 2, 3");
+    test_equal_i(a_capacity(a), 3);
+    a_reserve(a, 1000);
+    test_equal_i(a_capacity(a), 1000);
+    test_equal_i(a_length(a), 3);
+    Any data = a->a;
+    for (int i = 0; i < 997; i++) {
+        ia_push(a, i);
+    }
+    test_equal_b(a->a == data, true); // no reallocation
+    test_equal_i(ia_get(a, 999), 996);
+    a_reserve(a, 10); // does not shrink
+    test_equal_i(a_capacity(a), 1000);
+    a_free(a);
+}
+
+static void a_append_test(void) {
+    printsln((String)__func__);
+    Array a = ia_of_string("1, 2, 3");
+    Array b = ia_of_string("4, 5");
+    a_append(a, b);
+    Array ex = ia_of_string("1, 2, 3, 4, 5");
+    ia_test_equal(a, ex);
+    a_free(ex);
+    a_append(a, a); // appending to itself is allowed
+    ex = ia_of_string("1, 2, 3, 4, 5, 1, 2, 3, 4, 5");
+    ia_test_equal(a, ex);
+    a_free(ex);
+    int c[] = { 6, 7, 8 };
+    a_append_buffer(a, c, 3);
+    a_append_buffer(a, c, 0);
+    ex = ia_of_string("1, 2, 3, 4, 5, 1, 2, 3, 4, 5, 6, 7, 8");
+    ia_test_equal(a, ex);
+    a_free(ex);
+    test_equal_i(ia_pop(a), 8);
+    test_equal_i(a_length(a), 12);
+    a_free(a);
+    a_free(b);
+}
+
+int a_capacity(Array array) {
+    require_not_null(array);
+    return array->c;
+}
+
+void a_reserve(Array array, int capacity) {
+    require_not_null(array);
+    require("non-negative capacity", capacity >= 0);
+    if (capacity > array->c) {
+        if (a_is_shared(array)) {
+            a_move_shared(array, capacity);
+            return;
+        }
+        size_t size = (size_t)capacity * array->s;
+        bool own_block = array->base == NULL && !a_is_inline(array);
+        if (!own_block || (size >= A_ALIGN_MIN && (size_t)array->a % 64 != 0)) {
+            // the head stays in place, the elements move to a new block
+            Any a = size < A_ALIGN_MIN ? xmalloc(size) : xmalloc_aligned(size);
+            memcpy(a, array->a, (size_t)array->n * array->s);
+            if (own_block) free(array->a);
+            array->a = a;
+            array->base = NULL; // a view becomes an independent array
+        } else {
+            array->a = xrealloc(array->a, size);
+        }
+        array->c = capacity;
+    }
+}
+
+void a_grow(Array array, int n) {
+    require_x("length fits into int", n <= INT_MAX - array->n, "n == %d, length == %d", n, array->n);
+    int needed = array->n + n;
+    if (needed > array->c) {
+        int capacity = array->c < 4 ? 4 : array->c;
+        while (capacity < needed) {
+            capacity = capacity <= INT_MAX / 2 ? 2 * capacity : INT_MAX;
+        }
+        a_reserve(array, capacity);
+    }
+}
+
+void a_shrink_to_fit(Array array) {
+    require_not_null(array);
+    if (array->c > array->n && array->base == NULL && !a_is_inline(array) && !a_is_shared(array)) {
+        array->a = xrealloc(array->a, (size_t)array->n * array->s);
+        array->c = array->n;
+    }
+}
+
+void a_push(Array array, Any value) {
+    require_not_null(array);
+    require_not_null(value);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    memcpy((Byte*)array->a + array->n * array->s, value, array->s);
+    array->n++;
+}
+
+Any a_pop(Array array) {
+    require_not_null(array);
+    require("not empty", array->n > 0);
+    array->n--;
+    return (Byte*)array->a + array->n * array->s;
+}
+
+void a_append(Array array, Array x) {
+    require_not_null(array);
+    require_not_null(x);
+    require_x("equal element sizes", array->s == x->s, "array->s == %d, x->s == %d", array->s, x->s);
+    a_unshare(array);
+    int n = x->n; // x may be array
+    a_grow(array, n);
+    memcpy((Byte*)array->a + array->n * array->s, x->a, n * x->s);
+    array->n += n;
+}
 
+void a_append_buffer(Array array, Any buffer, int n) {
+    require_not_null(array);
+    require("non-negative length", n >= 0);
+    a_unshare(array);
+    if (n == 0) return;
+    require_not_null(buffer);
+    a_grow(array, n);
+    memcpy((Byte*)array->a + array->n * array->s, buffer, n * array->s);
+    array->n += n;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -889,6 +1544,7 @@ static void a_reverse_test(void) {
 
 void a_reverse(Array array) {
     require_not_null(array);
+    a_unshare(array);
     if (array->n <= 1) return;
     Byte *tmp = xmalloc(array->s);
     for (int i = 0, j = array->n - 1; i < j; i++, j--) {
@@ -910,6 +1566,7 @@ static void a_shuffle_test(void) {
 
 void a_shuffle(Array array) {
     require_not_null(array);
+    a_unshare(array);
     Byte *tmp = xmalloc(array->s);
     for (int i = array->n - 1; i > 0; i--) {
         int r = i_rnd(i + 1); // random number between [0,i]
@@ -969,84 +1626,2083 @@ static void a_sort_test(void) {
 void a_sort(Array array, Comparator c) {
     require_not_null(array);
     require_not_null(c);
+    a_unshare(array);
     qsort(array->a, array->n, array->s, c);
 }
 
+static void a_sort_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = ia_of_string("5, 4, 3, 2, 1");
+    a_sort_from_to(ac, a_compare_i, 1, 4);
+    Array ex = ia_of_string("5, 2, 3, 4, 1");
+    ia_test_equal(ac, ex);
+    a_free(ex);
+    a_sort_from_to(ac, a_compare_i, -1, 10);
+    ex = ia_of_string("1, 2, 3, 4, 5");
+    ia_test_equal(ac, ex);
+    a_sort_from_to(ac, a_compare_i, 3, 2); // empty range
+    ia_test_equal(ac, ex);
+    a_free(ex);
+    a_free(ac);
+}
 
-
-///////////////////////////////////////////////////////////////////////////////
-
-
-static void a_inc(IntPair *element, int index, Any state, IntPair *mapped_element) {
-    mapped_element->i = element->i + 1;
-    mapped_element->j = element->j + 1;
+void a_sort_from_to(Array array, Comparator c, int from, int to) {
+    require_not_null(array);
+    require_not_null(c);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    if (from < to) {
+        qsort((Byte*)array->a + from * array->s, to - from, array->s, c);
+    }
 }
 
-static void a_int_pair_i(IntPair *element, int index, Any state, int *mapped_element) {
-    *mapped_element = element->i;
+static CmpResult a_compare_int_pair_i(ConstAny a, ConstAny b) {
+    int x = ((IntPair*)a)->i;
+    int y = ((IntPair*)b)->i;
+    return (x < y) ? LT : ((x > y) ? GT : EQ);
 }
 
-static void a_map_test(void) {
+static void a_sort_stable_test(void) {
     printsln((String)__func__);
-    Array ac, acm, ex;
-    IntPair ip;
-
-    ac = a_create(3, sizeof(IntPair));
-    ip = make_int_pair(1, 10);
-    a_set(ac, 0, &ip);
-    ip = make_int_pair(2, 20);
-    a_set(ac, 1, &ip);
-    ip = make_int_pair(3, 30);
-    a_set(ac, 2, &ip);
-    // a_println(ac, print_int_pair);
-    
-    acm = a_map(ac, a_inc, sizeof(IntPair), NULL);
-    // a_println(acm, print_int_pair);
+    // pairs are ordered by i only, j records the original position
+    int sizes[] = { 0, 1, 2, 3, 31, 32, 33, 64, 100, 1000, 5000 };
+    for (int k = 0; k < (int)(sizeof(sizes) / sizeof(sizes[0])); k++) {
+        int n = sizes[k];
+        for (int kind = 0; kind < 5; kind++) {
+            Array a = a_create(n, sizeof(IntPair));
+            for (int i = 0; i < n; i++) {
+                IntPair *p = (IntPair*)a->a + i;
+                switch (kind) {
+                    case 0: p->i = i_rnd(n / 4 + 1); break; // random with duplicates
+                    case 1: p->i = i / 3; break; // sorted
+                    case 2: p->i = (n - i) / 3; break; // reverse-sorted
+                    case 3: p->i = i % 2 == 0 || i % 17 == 0 ? i : i - 7; break; // nearly sorted
+                    case 4: p->i = i % 10 < 5 ? i / 10 : n - i / 10; break; // alternating runs
+                }
+                p->j = i;
+            }
+            a_sort_stable(a, a_compare_int_pair_i);
+            IntPair *p = a->a;
+            bool stable = true;
+            for (int i = 1; i < n; i++) {
+                stable = stable && (p[i - 1].i < p[i].i || (p[i - 1].i == p[i].i && p[i - 1].j < p[i].j));
+            }
+            test_equal_b(stable, true);
+            a_free(a);
+        }
+    }
 
-    ex = a_create(3, sizeof(IntPair));
-    ip = make_int_pair(2, 11);
-    a_set(ex, 0, &ip);
-    ip = make_int_pair(3, 21);
-    a_set(ex, 1, &ip);
-    ip = make_int_pair(4, 31);
-    a_set(ex, 2, &ip);
-    
-    a_test_equal(acm, ex);
-    a_free(acm);
+    Array ac = ia_of_string("3, 1, 2, 1, 3, 2");
+    a_sort_stable(ac, a_compare_i);
+    Array ex = ia_of_string("1, 1, 2, 2, 3, 3");
+    ia_test_equal(ac, ex);
+    a_free(ac);
     a_free(ex);
+}
 
-    ex = a_create(3, sizeof(int));
-    int i = 1;
-    a_set(ex, 0, &i);
-    i = 2;
-    a_set(ex, 1, &i);
-    i = 3;
-    a_set(ex, 2, &i);
+// Natural merge sort (TimSort without galloping). The input is split into 
+// ascending and strictly descending runs, descending runs are reversed, 
+// runs shorter than min_run are extended with binary insertion sort, and 
+// the runs are merged through a buffer for n / 2 elements that is allocated 
+// once per sort.
+
+#define A_SORT_STABLE_MIN_MERGE 32
+#define A_SORT_STABLE_MAX_RUNS 85
+
+typedef struct {
+    Byte *a; // elements
+    int s; // element size
+    Comparator c;
+    Byte *tmp; // one element
+    Byte *buffer; // n / 2 elements, allocated by the first merge
+    int buffer_size; // in elements
+    int run_base[A_SORT_STABLE_MAX_RUNS];
+    int run_length[A_SORT_STABLE_MAX_RUNS];
+    int runs;
+} StableSort;
+
+#define at(i) (st->a + (size_t)(i) * st->s)
+
+// Returns the minimum run length, such that n / min_run is a power of 2 or 
+// slightly less.
+static int a_min_run(int n) {
+    int r = 0;
+    while (n >= A_SORT_STABLE_MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
 
-    acm = a_map(ac, a_int_pair_i, sizeof(int), NULL);
+// Returns the length of the run that starts at lo. Reverses the run if it 
+// is strictly descending, which keeps equal elements in order.
+static int a_count_run(StableSort *st, int lo, int hi) {
+    int i = lo + 1;
+    if (i == hi) return 1;
+    if (st->c(at(i), at(lo)) < 0) {
+        while (i + 1 < hi && st->c(at(i + 1), at(i)) < 0) i++;
+        for (int l = lo, r = i; l < r; l++, r--) {
+            memcpy(st->tmp, at(l), st->s);
+            memcpy(at(l), at(r), st->s);
+            memcpy(at(r), st->tmp, st->s);
+        }
+    } else {
+        while (i + 1 < hi && st->c(at(i + 1), at(i)) >= 0) i++;
+    }
+    return i + 1 - lo;
+}
 
-    a_test_equal(acm, ex);
-    
-    ia_println(acm);
+// Sorts [lo, hi), of which [lo, start) is already sorted. Each element is 
+// inserted after the equal elements before it.
+static void a_binary_insertion_sort(StableSort *st, int lo, int hi, int start) {
+    for (int i = start; i < hi; i++) {
+        int l = lo, r = i;
+        while (l < r) {
+            int m = l + (r - l) / 2;
+            if (st->c(at(i), at(m)) < 0) r = m; else l = m + 1;
+        }
+        if (l < i) {
+            memcpy(st->tmp, at(i), st->s);
+            memmove(at(l + 1), at(l), (size_t)(i - l) * st->s);
+            memcpy(at(l), st->tmp, st->s);
+        }
+    }
+}
 
-    a_free(ex);
-    a_free(acm);
-    a_free(ac);
+// Returns the first index in [lo, hi) whose element is greater than x 
+// (upper == true) or not less than x (upper == false).
+static int a_bound(StableSort *st, int lo, int hi, Byte *x, bool upper) {
+    while (lo < hi) {
+        int m = lo + (hi - lo) / 2;
+        CmpResult r = st->c(at(m), x);
+        if (r < 0 || (upper && r == 0)) lo = m + 1; else hi = m;
+    }
+    return lo;
 }
 
-Array a_map(Array array, AnyFn f, int mapped_element_size, Any state) {
-    require_not_null(array);
+// Merges the sorted ranges [lo, mid) in the buffer and [mid, hi) in place 
+// forward into [lo, hi). Ties take the left element. Inlined for constant 
+// element sizes s, such that memcpy becomes a move.
+static inline void a_merge_lo(Byte *a, int lo, int mid, int hi, int s, Comparator c, Byte *buffer) {
+    Byte *l = buffer, *le = l + (size_t)(mid - lo) * s;
+    Byte *r = a + (size_t)mid * s, *re = a + (size_t)hi * s, *d = a + (size_t)lo * s;
+    while (l < le && r < re) {
+        if (c(r, l) < 0) {
+            memcpy(d, r, s);
+            r += s;
+        } else {
+            memcpy(d, l, s);
+            l += s;
+        }
+        d += s;
+    }
+    memcpy(d, l, le - l); // rest of the right run is in place
+}
+
+// Merges the sorted ranges [lo, mid) in place and [mid, hi) in the buffer 
+// backward into [lo, hi). Ties take the right element.
+static inline void a_merge_hi(Byte *a, int lo, int mid, int hi, int s, Comparator c, Byte *buffer) {
+    Byte *ls = a + (size_t)lo * s, *l = a + (size_t)mid * s;
+    Byte *rs = buffer, *r = rs + (size_t)(hi - mid) * s, *d = a + (size_t)hi * s;
+    while (l > ls && r > rs) {
+        d -= s;
+        if (c(r - s, l - s) < 0) {
+            l -= s;
+            memcpy(d, l, s);
+        } else {
+            r -= s;
+            memcpy(d, r, s);
+        }
+    }
+    memcpy(d - (r - rs), rs, r - rs); // rest of the left run is in place
+}
+
+// Merges the adjacent sorted ranges [lo, mid) and [mid, hi). Only the shorter 
+// part that is not already in place is copied to the buffer.
+static void a_merge_runs(StableSort *st, int lo, int mid, int hi) {
+    // elements of the left run that are not greater than the first of the right run stay
+    lo = a_bound(st, lo, mid, at(mid), true);
+    if (lo == mid) return;
+    // elements of the right run that are not less than the last of the left run stay
+    hi = a_bound(st, mid, hi, at(mid - 1), false);
+    int n1 = mid - lo, n2 = hi - mid, s = st->s;
+    if (st->buffer == NULL) {
+        st->buffer = xmalloc((size_t)st->buffer_size * s);
+    }
+    assert("buffer is large enough", n1 <= st->buffer_size || n2 <= st->buffer_size);
+    if (n1 <= n2) {
+        memcpy(st->buffer, at(lo), (size_t)n1 * s);
+        switch (s) {
+            case 4: a_merge_lo(st->a, lo, mid, hi, 4, st->c, st->buffer); break;
+            case 8: a_merge_lo(st->a, lo, mid, hi, 8, st->c, st->buffer); break;
+            default: a_merge_lo(st->a, lo, mid, hi, s, st->c, st->buffer); break;
+        }
+    } else {
+        memcpy(st->buffer, at(mid), (size_t)n2 * s);
+        switch (s) {
+            case 4: a_merge_hi(st->a, lo, mid, hi, 4, st->c, st->buffer); break;
+            case 8: a_merge_hi(st->a, lo, mid, hi, 8, st->c, st->buffer); break;
+            default: a_merge_hi(st->a, lo, mid, hi, s, st->c, st->buffer); break;
+        }
+    }
+}
+
+// Merges runs i and i + 1.
+static void a_merge_at(StableSort *st, int i) {
+    int lo = st->run_base[i], mid = st->run_base[i + 1];
+    int hi = mid + st->run_length[i + 1];
+    st->run_length[i] += st->run_length[i + 1];
+    if (i == st->runs - 3) {
+        st->run_base[i + 1] = st->run_base[i + 2];
+        st->run_length[i + 1] = st->run_length[i + 2];
+    }
+    st->runs--;
+    a_merge_runs(st, lo, mid, hi);
+}
+
+// Merges runs until the lengths on the stack decrease faster than the 
+// Fibonacci numbers, which bounds the stack size and balances the merges.
+static void a_merge_collapse(StableSort *st) {
+    int *len = st->run_length;
+    while (st->runs > 1) {
+        int k = st->runs - 2;
+        if ((k > 0 && len[k - 1] <= len[k] + len[k + 1]) 
+                || (k > 1 && len[k - 2] <= len[k - 1] + len[k])) {
+            if (len[k - 1] < len[k + 1]) k--;
+        } else if (len[k] > len[k + 1]) {
+            break;
+        }
+        a_merge_at(st, k);
+    }
+}
+
+#undef at
+
+// Sorts the n elements of size s at a.
+static void a_sort_stable_n(Any a, int n, int s, Comparator c) {
+    if (n < 2) return;
+    StableSort st;
+    st.a = a;
+    st.s = s;
+    st.c = c;
+    st.tmp = xmalloc(s);
+    st.buffer = NULL;
+    st.buffer_size = n / 2;
+    st.runs = 0;
+    int min_run = a_min_run(n);
+    for (int lo = 0; lo < n; ) {
+        int run = a_count_run(&st, lo, n);
+        if (run < min_run) {
+            int force = n - lo < min_run ? n - lo : min_run;
+            a_binary_insertion_sort(&st, lo, lo + force, lo + run);
+            run = force;
+        }
+        assert("run stack is large enough", st.runs < A_SORT_STABLE_MAX_RUNS);
+        st.run_base[st.runs] = lo;
+        st.run_length[st.runs] = run;
+        st.runs++;
+        a_merge_collapse(&st);
+        lo += run;
+    }
+    while (st.runs > 1) {
+        int k = st.runs - 2;
+        if (k > 0 && st.run_length[k - 1] < st.run_length[k + 1]) k--;
+        a_merge_at(&st, k);
+    }
+    free(st.buffer);
+    free(st.tmp);
+}
+
+void a_sort_stable(Array array, Comparator c) {
+    require_not_null(array);
+    require_not_null(c);
+    a_unshare(array);
+    a_sort_stable_n(array->a, array->n, array->s, c);
+}
+
+static void a_sort_parallel_test(void) {
+    printsln((String)__func__);
+    // pairs are ordered by i only, the result has to be that of the stable sort
+    int n = 3 * A_SORT_PARALLEL_MIN + 17;
+    Array input = a_create(n, sizeof(IntPair));
+    for (int k = 0; k < n; k++) {
+        IntPair *p = (IntPair*)input->a + k;
+        p->i = i_rnd(1000);
+        p->j = k;
+    }
+    Array ex = a_sub(input, 0, n);
+    a_sort_stable(ex, a_compare_int_pair_i);
+    for (int threads = 0; threads <= 4; threads++) {
+        Array ac = a_sub(input, 0, n);
+        a_sort_parallel(ac, a_compare_int_pair_i, threads);
+        test_equal_b(memcmp(ac->a, ex->a, (size_t)n * sizeof(IntPair)) == 0, true);
+        a_free(ac);
+    }
+    a_free(input);
+    a_free(ex);
+
+    Array ac = ia_of_string("3, 1, 2");
+    a_sort_parallel(ac, a_compare_i, 4);
+    ex = ia_of_string("1, 2, 3");
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
+}
+
+// Returns the number of threads to sort n elements with, at most the given 
+// number (0 for one per processor).
+static int a_sort_threads(int threads, int n) {
+#ifdef NO_THREADS
+    return 1;
+#else
+    if (threads == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = processors > 0 ? (int)processors : 1;
+    }
+    if (threads > n / A_SORT_PARALLEL_MIN) threads = n / A_SORT_PARALLEL_MIN;
+    if (threads > A_SORT_PARALLEL_MAX_THREADS) threads = A_SORT_PARALLEL_MAX_THREADS;
+    return threads < 1 ? 1 : threads;
+#endif
+}
+
+// Sorts the range [lo, hi) of src (merge == false) or merges the ranges 
+// [lo, mid) and [mid, hi) of src into dst, but only the merged elements 
+// [from, to) relative to lo.
+typedef struct {
+    const ASortParallel *ops;
+    Comparator c;
+    int s;
+    Byte *src;
+    Byte *dst;
+    bool merge;
+    int lo, mid, hi;
+    int from, to;
+} ASortTask;
+
+static void a_sort_task_run(ASortTask *t) {
+    int s = t->s;
+    Byte *a = t->src + (size_t)t->lo * s;
+    if (!t->merge) {
+        t->ops->sort(a, t->hi - t->lo, s, t->c);
+        return;
+    }
+    int na = t->mid - t->lo, nb = t->hi - t->mid;
+    Byte *b = t->src + (size_t)t->mid * s;
+    int i0 = t->ops->split(a, na, b, nb, t->from, s, t->c);
+    int i1 = t->ops->split(a, na, b, nb, t->to, s, t->c);
+    int j0 = t->from - i0, j1 = t->to - i1;
+    t->ops->merge(a + (size_t)i0 * s, i1 - i0, b + (size_t)j0 * s, j1 - j0, 
+            t->dst + ((size_t)t->lo + t->from) * s, s, t->c);
+}
+
+// Tasks first, first + stride, first + 2 * stride, ... of a thread.
+typedef struct {
+    ASortTask *tasks;
+    int count;
+    int first;
+    int stride;
+} ASortWorker;
+
+static void *a_sort_worker(void *arg) {
+    ASortWorker *w = arg;
+    for (int i = w->first; i < w->count; i += w->stride) {
+        a_sort_task_run(&w->tasks[i]);
+    }
+    return NULL;
+}
+
+// Runs the tasks with the given number of threads, including the calling 
+// thread. If a thread cannot be started, the calling thread does its tasks.
+static void a_sort_run_tasks(ASortTask *tasks, int count, int threads) {
+    if (threads > count) threads = count;
+    ASortWorker workers[A_SORT_PARALLEL_MAX_THREADS] = { { NULL, 0, 0, 0 } };
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (ASortWorker){ tasks, count, i, threads };
+    }
+#ifdef NO_THREADS
+    for (int i = 0; i < threads; i++) {
+        a_sort_worker(&workers[i]);
+    }
+#else
+    pthread_t ids[A_SORT_PARALLEL_MAX_THREADS];
+    bool started[A_SORT_PARALLEL_MAX_THREADS] = { false };
+    for (int i = 1; i < threads; i++) {
+        started[i] = pthread_create(&ids[i], NULL, a_sort_worker, &workers[i]) == 0;
+    }
+    a_sort_worker(&workers[0]);
+    for (int i = 1; i < threads; i++) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        } else {
+            a_sort_worker(&workers[i]);
+        }
+    }
+#endif
+}
+
+void a_sort_parallel_with(Array array, Comparator c, int threads, const ASortParallel *ops) {
+    require_not_null(array);
+    require_not_null(ops);
+    require("non-negative thread count", threads >= 0);
+    a_unshare(array);
+    int n = array->n, s = array->s;
+    threads = a_sort_threads(threads, n);
+    if (threads == 1) {
+        ops->sort(array->a, n, s, c);
+        return;
+    }
+
+    // each thread sorts one range
+    ASortTask tasks[2 * A_SORT_PARALLEL_MAX_THREADS];
+    int bounds[A_SORT_PARALLEL_MAX_THREADS + 1];
+    int runs = threads;
+    for (int i = 0; i <= runs; i++) {
+        bounds[i] = (int)((long)n * i / runs);
+    }
+    for (int i = 0; i < runs; i++) {
+        tasks[i] = (ASortTask){ ops, c, s, array->a, NULL, false, bounds[i], 0, bounds[i + 1], 0, 0 };
+    }
+    a_sort_run_tasks(tasks, runs, threads);
+
+    // merge pairs of ranges, the threads share each merge
+    Byte *src = array->a, *dst = xmalloc((size_t)n * s), *buffer = dst;
+    while (runs > 1) {
+        int pairs = (runs + 1) / 2;
+        int parts = threads / pairs > 1 ? threads / pairs : 1;
+        int count = 0;
+        for (int p = 0; p < pairs; p++) {
+            int lo = bounds[2 * p];
+            int hi = bounds[2 * p + 2 <= runs ? 2 * p + 2 : runs];
+            int mid = 2 * p + 1 < runs ? bounds[2 * p + 1] : hi; // odd range is copied
+            for (int q = 0; q < parts; q++) {
+                int from = (int)((long)(hi - lo) * q / parts);
+                int to = (int)((long)(hi - lo) * (q + 1) / parts);
+                tasks[count++] = (ASortTask){ ops, c, s, src, dst, true, lo, mid, hi, from, to };
+            }
+            bounds[p] = lo;
+        }
+        bounds[pairs] = n;
+        runs = pairs;
+        a_sort_run_tasks(tasks, count, threads);
+        Byte *t = src; src = dst; dst = t;
+    }
+    if (src != (Byte*)array->a) memcpy(array->a, src, (size_t)n * s);
+    free(buffer);
+}
+
+// Returns how many of the first d merged elements come from a.
+static int a_split_generic(ConstAny a, int na, ConstAny b, int nb, int d, int s, Comparator c) {
+    const Byte *x = a, *y = b;
+    int lo = d > nb ? d - nb : 0, hi = d < na ? d : na;
+    while (lo < hi) {
+        int i = lo + (hi - lo + 1) / 2;
+        if (c(y + (size_t)(d - i) * s, x + (size_t)(i - 1) * s) < 0) hi = i - 1; else lo = i;
+    }
+    return lo;
+}
+
+static void a_merge_generic(ConstAny a, int na, ConstAny b, int nb, Any out, int s, Comparator c) {
+    const Byte *x = a, *xe = x + (size_t)na * s, *y = b, *ye = y + (size_t)nb * s;
+    Byte *d = out;
+    while (x < xe && y < ye) {
+        if (c(y, x) < 0) {
+            memcpy(d, y, s);
+            y += s;
+        } else {
+            memcpy(d, x, s);
+            x += s;
+        }
+        d += s;
+    }
+    memcpy(d, x, xe - x);
+    d += xe - x;
+    memcpy(d, y, ye - y);
+}
+
+static const ASortParallel a_sort_parallel_stable = { a_sort_stable_n, a_split_generic, a_merge_generic };
+
+void a_sort_parallel(Array array, Comparator c, int threads) {
+    require_not_null(array);
+    require_not_null(c);
+    a_sort_parallel_with(array, c, threads, &a_sort_parallel_stable);
+}
+
+static void a_fill_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = a_create(4, sizeof(IntPair));
+    IntPair p = { 1, 2 };
+    a_fill_from_to(ac, &p, 1, 3);
+    IntPair *q = a_get(ac, 0);
+    test_equal_i(q->i, 0);
+    q = a_get(ac, 2);
+    test_equal_i(q->j, 2);
+    q = a_get(ac, 3);
+    test_equal_i(q->j, 0);
+    a_free(ac);
+}
+
+void a_fill_from_to(Array array, Any value, int from, int to) {
+    require_not_null(array);
+    require_not_null(value);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    for (int i = from; i < to; i++) {
+        memcpy((Byte*)array->a + i * array->s, value, array->s);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static CmpResult a_compare_int(ConstAny a, ConstAny b) {
+    int x = *(int*)a;
+    int y = *(int*)b;
+    return (x == y) ? EQ : (x < y ? LT : GT);
+}
+
+static CmpResult a_compare_double(ConstAny a, ConstAny b) {
+    double x = *(double*)a;
+    double y = *(double*)b;
+    return (x == y) ? EQ : (x < y ? LT : GT);
+}
+
+static CmpResult a_compare_byte(ConstAny a, ConstAny b) {
+    Byte x = *(Byte*)a;
+    Byte y = *(Byte*)b;
+    return (x == y) ? EQ : (x < y ? LT : GT);
+}
+
+static inline bool a_int_pair_less(const IntPair *x, const IntPair *y) {
+    return x->i < y->i || (x->i == y->i && x->j < y->j);
+}
+
+A_SORT_DEFINE(a_int_pair_sort, IntPair, a_int_pair_less)
+
+static bool a_int_pair_sorted(Array array) {
+    for (int i = 1; i < array->n; i++) {
+        if (a_int_pair_less(a_get(array, i), a_get(array, i - 1))) return false;
+    }
+    return true;
+}
+
+static void a_sort_define_test(void) {
+    printsln((String)__func__);
+    int sizes[] = { 0, 1, 2, 16, 17, 100, 10000 };
+    for (int k = 0; k < 7; k++) {
+        int n = sizes[k];
+        Array a = a_create(n, sizeof(IntPair));
+        IntPair *p = a->a;
+        for (int i = 0; i < n; i++) {
+            p[i] = make_int_pair(i_rnd(10), i_rnd(1000));
+        }
+        long sum = 0;
+        for (int i = 0; i < n; i++) sum += p[i].i * 1000 + p[i].j;
+        Array c = a_copy(a);
+        a_int_pair_sort(c);
+        test_equal_b(a_int_pair_sorted(c), true);
+        p = c->a;
+        for (int i = 0; i < n; i++) sum -= p[i].i * 1000 + p[i].j;
+        test_equal_i(sum, 0);
+        // heapsort when the recursion gets too deep
+        a_int_pair_sort_state_intro(a->a, n, 0, 0);
+        test_equal_b(a_int_pair_sorted(a), true);
+        test_equal_b(a_equals(a, c), true);
+        a_free(a);
+        a_free(c);
+    }
+
+    // already sorted, reversed, and equal elements
+    Array a = a_create(1000, sizeof(IntPair));
+    IntPair *p = a->a;
+    for (int i = 0; i < 1000; i++) p[i] = make_int_pair(i, 0);
+    a_int_pair_sort(a);
+    test_equal_b(a_int_pair_sorted(a), true);
+    for (int i = 0; i < 1000; i++) p[i] = make_int_pair(1000 - i, 0);
+    a_int_pair_sort(a);
+    test_equal_b(a_int_pair_sorted(a), true);
+    test_equal_i(p[0].i, 1);
+    for (int i = 0; i < 1000; i++) p[i] = make_int_pair(7, 7);
+    a_int_pair_sort_n(p, 1000);
+    test_equal_b(a_int_pair_sorted(a), true);
+    a_free(a);
+}
+
+static bool a_radix_sort_test_case(int n, bool descending) {
+    int *xi = xmalloc(n * sizeof(int));
+    double *xd = xmalloc(n * sizeof(double));
+    Byte *xb = xmalloc(n);
+    for (int i = 0; i < n; i++) {
+        // few distinct high digits, such that some passes are skipped
+        xi[i] = i % 3 == 0 ? i_rnd(1000) - 500 : (int)(((unsigned)rand() << 16) ^ (unsigned)rand());
+        xd[i] = i % 5 == 0 ? -xi[i] * 0.5 : xi[i] * 1e-3;
+        xb[i] = (Byte)xi[i];
+    }
+    if (n > 2) {
+        xd[0] = -0.0;
+        xd[1] = 0.0;
+        xd[2] = -1e300;
+    }
+    int *yi = xmalloc(n * sizeof(int));
+    memcpy(yi, xi, n * sizeof(int));
+    qsort(yi, n, sizeof(int), a_compare_int);
+    double *yd = xmalloc(n * sizeof(double));
+    memcpy(yd, xd, n * sizeof(double));
+    qsort(yd, n, sizeof(double), a_compare_double);
+    Byte *yb = xmalloc(n);
+    memcpy(yb, xb, n);
+    qsort(yb, n, 1, a_compare_byte);
+
+    a_radix_sort_int(xi, n, descending);
+    a_radix_sort_double(xd, n, descending);
+    a_counting_sort_byte(xb, n, descending);
+    bool ok = true;
+    for (int i = 0; i < n; i++) {
+        int j = descending ? n - 1 - i : i;
+        ok = ok && xi[i] == yi[j] && xd[i] == yd[j] && xb[i] == yb[j];
+    }
+    free(xi);
+    free(yi);
+    free(xd);
+    free(yd);
+    free(xb);
+    free(yb);
+    return ok;
+}
+
+static void a_radix_sort_test(void) {
+    printsln((String)__func__);
+    int sizes[] = { 0, 1, 2, 3, 63, 64, 1000, 100000 };
+    for (int i = 0; i < 8; i++) {
+        test_equal_b(a_radix_sort_test_case(sizes[i], false), true);
+        test_equal_b(a_radix_sort_test_case(sizes[i], true), true);
+    }
+
+    double a[] = { 0.0, -0.0, 1.0, -1.0, HUGE_VAL, -HUGE_VAL, 1e-310, -1e-310 };
+    a_radix_sort_double(a, 8, false);
+    test_equal_b(a[0] == -HUGE_VAL && a[7] == HUGE_VAL, true);
+    test_equal_b(a[1] == -1.0 && a[6] == 1.0, true);
+    test_equal_b(a[2] == -1e-310 && a[5] == 1e-310, true);
+    test_equal_b(signbit(a[3]) && !signbit(a[4]), true);
+}
+
+void a_radix_sort_int(int *a, int n, bool descending) {
+    require_not_null(a);
+    if (n < 2) return;
+    // flipping the sign bit maps ints to unsigned keys in the same order, 
+    // flipping all other bits as well reverses the order
+    uint32_t flip = descending ? 0x7fffffffu : 0x80000000u;
+    uint32_t *src = (uint32_t*)a;
+    uint32_t *dst = xmalloc((size_t)n * sizeof(uint32_t));
+    uint32_t *buffer = dst;
+    int counts[4][256] = { { 0 } };
+    for (int i = 0; i < n; i++) {
+        uint32_t k = src[i] ^ flip;
+        counts[0][k & 0xff]++;
+        counts[1][(k >> 8) & 0xff]++;
+        counts[2][(k >> 16) & 0xff]++;
+        counts[3][k >> 24]++;
+    }
+    for (int d = 0; d < 4; d++) {
+        int *c = counts[d];
+        int shift = 8 * d;
+        if (c[((src[0] ^ flip) >> shift) & 0xff] == n) continue; // all elements have the same digit
+        for (int b = 0, sum = 0; b < 256; b++) {
+            int count = c[b];
+            c[b] = sum;
+            sum += count;
+        }
+        for (int i = 0; i < n; i++) {
+            uint32_t x = src[i];
+            dst[c[((x ^ flip) >> shift) & 0xff]++] = x;
+        }
+        uint32_t *t = src; src = dst; dst = t;
+    }
+    if (src != (uint32_t*)a) memcpy(a, src, (size_t)n * sizeof(uint32_t));
+    free(buffer);
+}
+
+// Maps the bits of a double to a key that compares like the double.
+static inline uint64_t a_double_key(uint64_t x, uint64_t flip) {
+    uint64_t mask = (uint64_t)((int64_t)x >> 63) | 0x8000000000000000u;
+    return (x ^ mask) ^ flip;
+}
+
+void a_radix_sort_double(double *a, int n, bool descending) {
+    require_not_null(a);
+    if (n < 2) return;
+    uint64_t flip = descending ? ~(uint64_t)0 : 0;
+    uint64_t *x = (uint64_t*)a;
+    uint64_t *src = x; // sorted in place as keys
+    uint64_t *dst = xmalloc((size_t)n * sizeof(uint64_t));
+    uint64_t *buffer = dst;
+    int counts[8][256] = { { 0 } };
+    for (int i = 0; i < n; i++) {
+        uint64_t k = a_double_key(src[i], flip);
+        src[i] = k;
+        for (int d = 0; d < 8; d++) {
+            counts[d][(k >> (8 * d)) & 0xff]++;
+        }
+    }
+    for (int d = 0; d < 8; d++) {
+        int *c = counts[d];
+        int shift = 8 * d;
+        if (c[(src[0] >> shift) & 0xff] == n) continue; // all elements have the same digit
+        for (int b = 0, sum = 0; b < 256; b++) {
+            int count = c[b];
+            c[b] = sum;
+            sum += count;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t k = src[i];
+            dst[c[(k >> shift) & 0xff]++] = k;
+        }
+        uint64_t *t = src; src = dst; dst = t;
+    }
+    // map the keys back to doubles
+    for (int i = 0; i < n; i++) {
+        uint64_t k = src[i] ^ flip;
+        x[i] = k ^ ((k >> 63) ? 0x8000000000000000u : ~(uint64_t)0);
+    }
+    free(buffer);
+}
+
+void a_counting_sort_byte(Byte *a, int n, bool descending) {
+    require_not_null(a);
+    int counts[256] = { 0 };
+    for (int i = 0; i < n; i++) {
+        counts[a[i]]++;
+    }
+    Byte *p = a;
+    for (int b = 0; b < 256; b++) {
+        int v = descending ? 255 - b : b;
+        memset(p, v, counts[v]);
+        p += counts[v];
+    }
+}
+
+// Vectorized search. On x86-64 with GCC or Clang, the kernels exist in 
+// SSE2 (part of every x86-64 CPU) and AVX2 variants, chosen at runtime. 
+// Elsewhere, or compiled with -DNO_SIMD, only the scalar loops are used.
+
+#if !defined(NO_SIMD) && defined(__x86_64__) && defined(__GNUC__)
+#define A_SIMD 1
+#include <immintrin.h>
+#else
+#define A_SIMD 0
+#endif
+
+#define A_SIMD_MIN 16 // shorter ranges are searched by the scalar loops
+
+static int a_index_int_scalar(const int *a, int n, int value) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] == value) return i;
+    }
+    return -1;
+}
+
+static int a_last_index_int_scalar(const int *a, int n, int value) {
+    for (int i = n - 1; i >= 0; i--) {
+        if (a[i] == value) return i;
+    }
+    return -1;
+}
+
+static int a_index_double_scalar(const double *a, int n, double value, double epsilon) {
+    for (int i = 0; i < n; i++) {
+        if (fabs(a[i] - value) < epsilon) return i;
+    }
+    return -1;
+}
+
+#if A_SIMD
+
+// The loops check 4 vectors at a time and find the exact position with the 
+// single-vector loop that follows.
+
+static int a_index_int_sse2(const int *a, int n, int value) {
+    __m128i v = _mm_set1_epi32(value);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)), v);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i + 4)), v);
+        __m128i e2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i + 8)), v);
+        __m128i e3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i + 12)), v);
+        __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3));
+        if (_mm_movemask_epi8(any) != 0) break;
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128i e = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)), v);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(e));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    int j = a_index_int_scalar(a + i, n - i, value);
+    return j < 0 ? -1 : i + j;
+}
+
+static int a_last_index_int_sse2(const int *a, int n, int value) {
+    __m128i v = _mm_set1_epi32(value);
+    int i = n; // a[i, n) has been searched
+    for (; i >= 16; i -= 16) {
+        __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i - 16)), v);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i - 12)), v);
+        __m128i e2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i - 8)), v);
+        __m128i e3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i - 4)), v);
+        __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3));
+        if (_mm_movemask_epi8(any) != 0) break;
+    }
+    for (; i >= 4; i -= 4) {
+        __m128i e = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i - 4)), v);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(e));
+        if (mask != 0) return i - 4 + 31 - __builtin_clz(mask);
+    }
+    return a_last_index_int_scalar(a, i, value);
+}
+
+static int a_index_double_sse2(const double *a, int n, double value, double epsilon) {
+    __m128d v = _mm_set1_pd(value), e = _mm_set1_pd(epsilon);
+    __m128d abs = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128d d0 = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i), v), abs);
+        __m128d d1 = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i + 2), v), abs);
+        __m128d d2 = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i + 4), v), abs);
+        __m128d d3 = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i + 6), v), abs);
+        __m128d any = _mm_or_pd(_mm_or_pd(_mm_cmplt_pd(d0, e), _mm_cmplt_pd(d1, e)), 
+                _mm_or_pd(_mm_cmplt_pd(d2, e), _mm_cmplt_pd(d3, e)));
+        if (_mm_movemask_pd(any) != 0) break;
+    }
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i), v), abs);
+        int mask = _mm_movemask_pd(_mm_cmplt_pd(d, e));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    int j = a_index_double_scalar(a + i, n - i, value, epsilon);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("avx2")))
+static int a_index_int_avx2(const int *a, int n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i e0 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+        __m256i e1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i + 8)), v);
+        __m256i e2 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i + 16)), v);
+        __m256i e3 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i + 24)), v);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+        if (!_mm256_testz_si256(any, any)) break;
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i e = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(e));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    int j = a_index_int_scalar(a + i, n - i, value);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("avx2")))
+static int a_last_index_int_avx2(const int *a, int n, int value) {
+    __m256i v = _mm256_set1_epi32(value);
+    int i = n; // a[i, n) has been searched
+    for (; i >= 32; i -= 32) {
+        __m256i e0 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i - 32)), v);
+        __m256i e1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i - 24)), v);
+        __m256i e2 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i - 16)), v);
+        __m256i e3 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i - 8)), v);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+        if (!_mm256_testz_si256(any, any)) break;
+    }
+    for (; i >= 8; i -= 8) {
+        __m256i e = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i - 8)), v);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(e));
+        if (mask != 0) return i - 8 + 31 - __builtin_clz(mask);
+    }
+    return a_last_index_int_scalar(a, i, value);
+}
+
+__attribute__((target("avx2")))
+static int a_index_double_avx2(const double *a, int n, double value, double epsilon) {
+    __m256d v = _mm256_set1_pd(value), e = _mm256_set1_pd(epsilon);
+    __m256d abs = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d d0 = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(a + i), v), abs);
+        __m256d d1 = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(a + i + 4), v), abs);
+        __m256d d2 = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(a + i + 8), v), abs);
+        __m256d d3 = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(a + i + 12), v), abs);
+        __m256d any = _mm256_or_pd(
+                _mm256_or_pd(_mm256_cmp_pd(d0, e, _CMP_LT_OQ), _mm256_cmp_pd(d1, e, _CMP_LT_OQ)), 
+                _mm256_or_pd(_mm256_cmp_pd(d2, e, _CMP_LT_OQ), _mm256_cmp_pd(d3, e, _CMP_LT_OQ)));
+        if (_mm256_movemask_pd(any) != 0) break;
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(a + i), v), abs);
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(d, e, _CMP_LT_OQ));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    int j = a_index_double_scalar(a + i, n - i, value, epsilon);
+    return j < 0 ? -1 : i + j;
+}
+
+static bool a_has_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+int a_index_int(const int *a, int n, int value) {
+#if A_SIMD
+    if (n >= A_SIMD_MIN) {
+        return a_has_avx2() ? a_index_int_avx2(a, n, value) : a_index_int_sse2(a, n, value);
+    }
+#endif
+    return a_index_int_scalar(a, n, value);
+}
+
+int a_last_index_int(const int *a, int n, int value) {
+#if A_SIMD
+    if (n >= A_SIMD_MIN) {
+        return a_has_avx2() ? a_last_index_int_avx2(a, n, value) : a_last_index_int_sse2(a, n, value);
+    }
+#endif
+    return a_last_index_int_scalar(a, n, value);
+}
+
+int a_index_double(const double *a, int n, double value, double epsilon) {
+#if A_SIMD
+    if (n >= A_SIMD_MIN) {
+        return a_has_avx2() 
+                ? a_index_double_avx2(a, n, value, epsilon) 
+                : a_index_double_sse2(a, n, value, epsilon);
+    }
+#endif
+    return a_index_double_scalar(a, n, value, epsilon);
+}
+
+static void a_index_simd_test(void) {
+    printsln((String)__func__);
+    // every position and length, compared to the scalar loops
+    int n = 100;
+    int *ints = xmalloc(n * sizeof(int));
+    double *doubles = xmalloc(n * sizeof(double));
+    bool ok = true;
+    for (int len = 0; len <= n; len++) {
+        for (int k = -1; k < len; k++) {
+            for (int i = 0; i < len; i++) {
+                ints[i] = i == k || i == len - 1 - k ? 7 : i;
+                doubles[i] = i == k ? 7.0 : i + 0.5;
+            }
+            if (len > 3) doubles[len / 2] = NAN;
+            int ex = a_index_int_scalar(ints, len, 7);
+            int ex_last = a_last_index_int_scalar(ints, len, 7);
+            int ex_double = a_index_double_scalar(doubles, len, 7.25, 0.3);
+            ok = ok && a_index_int(ints, len, 7) == ex;
+            ok = ok && a_last_index_int(ints, len, 7) == ex_last;
+            ok = ok && a_index_double(doubles, len, 7.25, 0.3) == ex_double;
+#if A_SIMD
+            ok = ok && a_index_int_sse2(ints, len, 7) == ex;
+            ok = ok && a_last_index_int_sse2(ints, len, 7) == ex_last;
+            ok = ok && a_index_double_sse2(doubles, len, 7.25, 0.3) == ex_double;
+            if (a_has_avx2()) {
+                ok = ok && a_index_int_avx2(ints, len, 7) == ex;
+                ok = ok && a_last_index_int_avx2(ints, len, 7) == ex_last;
+                ok = ok && a_index_double_avx2(doubles, len, 7.25, 0.3) == ex_double;
+            }
+#endif
+        }
+    }
+    test_equal_b(ok, true);
+    free(ints);
+    free(doubles);
+}
+
+// Reductions. The double kernels except a_sum_double_fast use 8 lanes: 
+// lane k adds up the elements i with i % 8 == k, then the lanes are 
+// combined in order and the last n % 8 elements are added. The scalar, 
+// SSE2 (4 x 2 lanes), and AVX2 (2 x 4 lanes) variants thus perform the same 
+// operations in the same order and return the same bits.
+
+#define A_LANES 8
+
+// Adds x to the sum s with compensation c (Kahan). Once the sum is not 
+// finite, (t - s) - y would be inf - inf, so the compensation is reset and 
+// the sum is inf, -inf, or NaN, like a plain sum.
+static inline void a_kahan_add(double *s, double *c, double x) {
+    double y = x - *c;
+    double t = *s + y;
+    *c = isfinite(t) ? (t - *s) - y : 0;
+    *s = t;
+}
+
+// Combines the lanes of a compensated sum and adds the rest elements.
+static double a_kahan_finish(const double *s, const double *c, const double *rest, int m) {
+    double sum = 0, comp = 0;
+    for (int k = 0; k < A_LANES; k++) {
+        a_kahan_add(&sum, &comp, s[k]);
+        a_kahan_add(&sum, &comp, -c[k]);
+    }
+    for (int i = 0; i < m; i++) {
+        a_kahan_add(&sum, &comp, rest[i]);
+    }
+    return sum - comp;
+}
+
+// Combines the lanes of a plain sum. The rest elements have been added by 
+// the caller.
+static double a_lanes_finish(const double *s, double rest) {
+    double sum = 0;
+    for (int k = 0; k < A_LANES; k++) {
+        sum += s[k];
+    }
+    return sum + rest;
+}
+
+static long a_sum_int_scalar(const int *a, int n) {
+    long sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += a[i];
+    }
+    return sum;
+}
+
+static long a_dot_int_scalar(const int *a, const int *b, int n) {
+    long sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += (long)a[i] * b[i];
+    }
+    return sum;
+}
+
+static double a_squares_int_scalar(const int *a, int n, double mean) {
+    double s[A_LANES] = { 0 };
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int k = 0; k < A_LANES; k++) {
+            double d = a[i + k] - mean;
+            s[k] += d * d;
+        }
+    }
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(s, rest);
+}
+
+static inline int a_extreme_index_int_scalar(const int *a, int n, bool max) {
+    if (n <= 0) return -1;
+    int m = 0;
+    for (int i = 1; i < n; i++) {
+        if (max ? a[i] > a[m] : a[i] < a[m]) m = i;
+    }
+    return m;
+}
+
+static double a_sum_double_scalar(const double *a, int n) {
+    double s[A_LANES] = { 0 }, c[A_LANES] = { 0 };
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int k = 0; k < A_LANES; k++) {
+            a_kahan_add(&s[k], &c[k], a[i + k]);
+        }
+    }
+    return a_kahan_finish(s, c, a + i, n - i);
+}
+
+static double a_sum_double_fast_scalar(const double *a, int n) {
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i];
+        s1 += a[i + 1];
+        s2 += a[i + 2];
+        s3 += a[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double a_dot_double_scalar(const double *a, const double *b, int n) {
+    double s[A_LANES] = { 0 };
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int k = 0; k < A_LANES; k++) {
+            s[k] += a[i + k] * b[i + k];
+        }
+    }
+    double rest = 0;
+    for (; i < n; i++) {
+        rest += a[i] * b[i];
+    }
+    return a_lanes_finish(s, rest);
+}
+
+static double a_squares_double_scalar(const double *a, int n, double mean) {
+    double s[A_LANES] = { 0 };
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int k = 0; k < A_LANES; k++) {
+            double d = a[i + k] - mean;
+            s[k] += d * d;
+        }
+    }
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(s, rest);
+}
+
+// NaNs are skipped. Returns -1 if there are only NaNs.
+static inline int a_extreme_index_double_scalar(const double *a, int n, bool max) {
+    int m = -1;
+    for (int i = 0; i < n; i++) {
+        if (a[i] == a[i] && (m < 0 || (max ? a[i] > a[m] : a[i] < a[m]))) m = i;
+    }
+    return m;
+}
+
+#if A_SIMD
+
+// Returns the index of the extreme element of the candidates of the vector 
+// lanes and the rest elements a[from, n). Candidates with index -1 are empty. 
+// On ties the smaller index wins.
+static int a_extreme_index_int_finish(const int *a, int n, const int *index, int lanes, int from, bool max) {
+    int m = -1;
+    for (int k = 0; k < lanes; k++) {
+        int i = index[k];
+        if (i >= 0 && (m < 0 || (max ? a[i] > a[m] : a[i] < a[m]) || (a[i] == a[m] && i < m))) m = i;
+    }
+    for (int i = from; i < n; i++) {
+        if (m < 0 || (max ? a[i] > a[m] : a[i] < a[m])) m = i;
+    }
+    return m;
+}
+
+static int a_extreme_index_double_finish(const double *a, int n, const long *index, int lanes, int from, bool max) {
+    int m = -1;
+    for (int k = 0; k < lanes; k++) {
+        int i = (int)index[k];
+        if (i >= 0 && (m < 0 || (max ? a[i] > a[m] : a[i] < a[m]) || (a[i] == a[m] && i < m))) m = i;
+    }
+    for (int i = from; i < n; i++) {
+        if (a[i] == a[i] && (m < 0 || (max ? a[i] > a[m] : a[i] < a[m]))) m = i;
+    }
+    if (from > 0 && (m < 0 || a[m] == (max ? -INFINITY : INFINITY))) {
+        // the vector loop only takes elements greater (less) than its start
+        // value -inf (inf), so a[0, from) may hold an earlier element equal 
+        // to the rest element m, or the only non-NaN elements
+        int k = a_extreme_index_double_scalar(a, from, max);
+        if (k >= 0) m = k;
+    }
+    return m;
+}
+
+static long a_sum_int_sse2(const int *a, int n) {
+    __m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i sign = _mm_srai_epi32(x, 31);
+        s0 = _mm_add_epi64(s0, _mm_unpacklo_epi32(x, sign));
+        s1 = _mm_add_epi64(s1, _mm_unpackhi_epi32(x, sign));
+    }
+    long s[2];
+    _mm_storeu_si128((__m128i*)s, _mm_add_epi64(s0, s1));
+    return s[0] + s[1] + a_sum_int_scalar(a + i, n - i);
+}
+
+static double a_squares_int_sse2(const int *a, int n, double mean) {
+    __m128d m = _mm_set1_pd(mean);
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(a + i + 4));
+        __m128d d0 = _mm_sub_pd(_mm_cvtepi32_pd(x), m);
+        __m128d d1 = _mm_sub_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x, 0xee)), m);
+        __m128d d2 = _mm_sub_pd(_mm_cvtepi32_pd(y), m);
+        __m128d d3 = _mm_sub_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(y, 0xee)), m);
+        s0 = _mm_add_pd(s0, _mm_mul_pd(d0, d0));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(d1, d1));
+        s2 = _mm_add_pd(s2, _mm_mul_pd(d2, d2));
+        s3 = _mm_add_pd(s3, _mm_mul_pd(d3, d3));
+    }
+    double s[A_LANES];
+    _mm_storeu_pd(s, s0);
+    _mm_storeu_pd(s + 2, s1);
+    _mm_storeu_pd(s + 4, s2);
+    _mm_storeu_pd(s + 6, s3);
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(s, rest);
+}
+
+static inline int a_extreme_index_int_sse2(const int *a, int n, bool max) {
+    if (n < 4) return a_extreme_index_int_scalar(a, n, max);
+    __m128i best = _mm_loadu_si128((const __m128i*)a);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3), best_index = index, four = _mm_set1_epi32(4);
+    int i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        index = _mm_add_epi32(index, four);
+        __m128i better = max ? _mm_cmpgt_epi32(x, best) : _mm_cmplt_epi32(x, best);
+        best = _mm_or_si128(_mm_and_si128(better, x), _mm_andnot_si128(better, best));
+        best_index = _mm_or_si128(_mm_and_si128(better, index), _mm_andnot_si128(better, best_index));
+    }
+    int indices[4];
+    _mm_storeu_si128((__m128i*)indices, best_index);
+    return a_extreme_index_int_finish(a, n, indices, 4, i, max);
+}
+
+static double a_sum_double_sse2(const double *a, int n) {
+    __m128d s[4], c[4];
+    for (int r = 0; r < 4; r++) {
+        s[r] = _mm_setzero_pd();
+        c[r] = _mm_setzero_pd();
+    }
+    int i = 0;
+    // |t| < inf is false for infinities and NaNs (see a_kahan_add)
+    __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    __m128d inf = _mm_set1_pd(INFINITY);
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int r = 0; r < 4; r++) {
+            __m128d y = _mm_sub_pd(_mm_loadu_pd(a + i + 2 * r), c[r]);
+            __m128d t = _mm_add_pd(s[r], y);
+            __m128d finite = _mm_cmplt_pd(_mm_and_pd(t, abs_mask), inf);
+            c[r] = _mm_and_pd(finite, _mm_sub_pd(_mm_sub_pd(t, s[r]), y));
+            s[r] = t;
+        }
+    }
+    double ls[A_LANES], lc[A_LANES];
+    for (int r = 0; r < 4; r++) {
+        _mm_storeu_pd(ls + 2 * r, s[r]);
+        _mm_storeu_pd(lc + 2 * r, c[r]);
+    }
+    return a_kahan_finish(ls, lc, a + i, n - i);
+}
+
+static double a_sum_double_fast_sse2(const double *a, int n) {
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm_add_pd(s0, _mm_loadu_pd(a + i));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(a + i + 2));
+        s2 = _mm_add_pd(s2, _mm_loadu_pd(a + i + 4));
+        s3 = _mm_add_pd(s3, _mm_loadu_pd(a + i + 6));
+    }
+    double s[2];
+    _mm_storeu_pd(s, _mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+    return s[0] + s[1] + a_sum_double_fast_scalar(a + i, n - i);
+}
+
+static double a_dot_double_sse2(const double *a, const double *b, int n) {
+    __m128d s[4];
+    for (int r = 0; r < 4; r++) s[r] = _mm_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int r = 0; r < 4; r++) {
+            __m128d p = _mm_mul_pd(_mm_loadu_pd(a + i + 2 * r), _mm_loadu_pd(b + i + 2 * r));
+            s[r] = _mm_add_pd(s[r], p);
+        }
+    }
+    double ls[A_LANES];
+    for (int r = 0; r < 4; r++) _mm_storeu_pd(ls + 2 * r, s[r]);
+    double rest = 0;
+    for (; i < n; i++) {
+        rest += a[i] * b[i];
+    }
+    return a_lanes_finish(ls, rest);
+}
+
+static double a_squares_double_sse2(const double *a, int n, double mean) {
+    __m128d m = _mm_set1_pd(mean), s[4];
+    for (int r = 0; r < 4; r++) s[r] = _mm_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        for (int r = 0; r < 4; r++) {
+            __m128d d = _mm_sub_pd(_mm_loadu_pd(a + i + 2 * r), m);
+            s[r] = _mm_add_pd(s[r], _mm_mul_pd(d, d));
+        }
+    }
+    double ls[A_LANES];
+    for (int r = 0; r < 4; r++) _mm_storeu_pd(ls + 2 * r, s[r]);
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(ls, rest);
+}
+
+static inline int a_extreme_index_double_sse2(const double *a, int n, bool max) {
+    __m128d best = _mm_set1_pd(max ? -INFINITY : INFINITY);
+    __m128i index = _mm_set_epi64x(1, 0), best_index = _mm_set1_epi64x(-1), two = _mm_set1_epi64x(2);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(a + i);
+        __m128d better = max ? _mm_cmpgt_pd(x, best) : _mm_cmplt_pd(x, best); // false for NaN
+        best = _mm_or_pd(_mm_and_pd(better, x), _mm_andnot_pd(better, best));
+        __m128i b = _mm_castpd_si128(better);
+        best_index = _mm_or_si128(_mm_and_si128(b, index), _mm_andnot_si128(b, best_index));
+        index = _mm_add_epi64(index, two);
+    }
+    long indices[2];
+    _mm_storeu_si128((__m128i*)indices, best_index);
+    return a_extreme_index_double_finish(a, n, indices, 2, i, max);
+}
+
+__attribute__((target("avx2")))
+static long a_sum_int_avx2(const int *a, int n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i))));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i + 4))));
+    }
+    long s[4];
+    _mm256_storeu_si256((__m256i*)s, _mm256_add_epi64(s0, s1));
+    return s[0] + s[1] + s[2] + s[3] + a_sum_int_scalar(a + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static long a_dot_int_avx2(const int *a, const int *b, int n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x0 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i y0 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i)));
+        __m256i x1 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i + 4)));
+        __m256i y1 = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i + 4)));
+        s0 = _mm256_add_epi64(s0, _mm256_mul_epi32(x0, y0));
+        s1 = _mm256_add_epi64(s1, _mm256_mul_epi32(x1, y1));
+    }
+    long s[4];
+    _mm256_storeu_si256((__m256i*)s, _mm256_add_epi64(s0, s1));
+    return s[0] + s[1] + s[2] + s[3] + a_dot_int_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double a_squares_int_avx2(const int *a, int n, double mean) {
+    __m256d m = _mm256_set1_pd(mean);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(a + i))), m);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(a + i + 4))), m);
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(d0, d0));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(d1, d1));
+    }
+    double s[A_LANES];
+    _mm256_storeu_pd(s, s0);
+    _mm256_storeu_pd(s + 4, s1);
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(s, rest);
+}
+
+__attribute__((target("avx2")))
+static inline int a_extreme_index_int_avx2(const int *a, int n, bool max) {
+    if (n < 8) return a_extreme_index_int_scalar(a, n, max);
+    __m256i best = _mm256_loadu_si256((const __m256i*)a);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), best_index = index;
+    __m256i eight = _mm256_set1_epi32(8);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        index = _mm256_add_epi32(index, eight);
+        __m256i better = max ? _mm256_cmpgt_epi32(x, best) : _mm256_cmpgt_epi32(best, x);
+        best = _mm256_blendv_epi8(best, x, better);
+        best_index = _mm256_blendv_epi8(best_index, index, better);
+    }
+    int indices[8];
+    _mm256_storeu_si256((__m256i*)indices, best_index);
+    return a_extreme_index_int_finish(a, n, indices, 8, i, max);
+}
+
+__attribute__((target("avx2")))
+static double a_sum_double_avx2(const double *a, int n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+    // |t| < inf is false for infinities and NaNs (see a_kahan_add)
+    __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    __m256d inf = _mm256_set1_pd(INFINITY);
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        __m256d y0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), c0);
+        __m256d y1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), c1);
+        __m256d t0 = _mm256_add_pd(s0, y0);
+        __m256d t1 = _mm256_add_pd(s1, y1);
+        __m256d finite0 = _mm256_cmp_pd(_mm256_and_pd(t0, abs_mask), inf, _CMP_LT_OQ);
+        __m256d finite1 = _mm256_cmp_pd(_mm256_and_pd(t1, abs_mask), inf, _CMP_LT_OQ);
+        c0 = _mm256_and_pd(finite0, _mm256_sub_pd(_mm256_sub_pd(t0, s0), y0));
+        c1 = _mm256_and_pd(finite1, _mm256_sub_pd(_mm256_sub_pd(t1, s1), y1));
+        s0 = t0;
+        s1 = t1;
+    }
+    double ls[A_LANES], lc[A_LANES];
+    _mm256_storeu_pd(ls, s0);
+    _mm256_storeu_pd(ls + 4, s1);
+    _mm256_storeu_pd(lc, c0);
+    _mm256_storeu_pd(lc + 4, c1);
+    return a_kahan_finish(ls, lc, a + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double a_sum_double_fast_avx2(const double *a, int n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_loadu_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_loadu_pd(a + i + 12));
+    }
+    double s[4];
+    _mm256_storeu_pd(s, _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+    return (s[0] + s[1]) + (s[2] + s[3]) + a_sum_double_fast_scalar(a + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double a_dot_double_avx2(const double *a, const double *b, int n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    double s[A_LANES];
+    _mm256_storeu_pd(s, s0);
+    _mm256_storeu_pd(s + 4, s1);
+    double rest = 0;
+    for (; i < n; i++) {
+        rest += a[i] * b[i];
+    }
+    return a_lanes_finish(s, rest);
+}
+
+__attribute__((target("avx2")))
+static double a_squares_double_avx2(const double *a, int n, double mean) {
+    __m256d m = _mm256_set1_pd(mean);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + A_LANES <= n; i += A_LANES) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), m);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), m);
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(d0, d0));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(d1, d1));
+    }
+    double s[A_LANES];
+    _mm256_storeu_pd(s, s0);
+    _mm256_storeu_pd(s + 4, s1);
+    double rest = 0;
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        rest += d * d;
+    }
+    return a_lanes_finish(s, rest);
+}
+
+__attribute__((target("avx2")))
+static inline int a_extreme_index_double_avx2(const double *a, int n, bool max) {
+    __m256d best = _mm256_set1_pd(max ? -INFINITY : INFINITY);
+    __m256i index = _mm256_setr_epi64x(0, 1, 2, 3), best_index = _mm256_set1_epi64x(-1);
+    __m256i four = _mm256_set1_epi64x(4);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        __m256d better = max ? _mm256_cmp_pd(x, best, _CMP_GT_OQ) : _mm256_cmp_pd(x, best, _CMP_LT_OQ);
+        best = _mm256_blendv_pd(best, x, better);
+        best_index = _mm256_blendv_epi8(best_index, index, _mm256_castpd_si256(better));
+        index = _mm256_add_epi64(index, four);
+    }
+    long indices[4];
+    _mm256_storeu_si256((__m256i*)indices, best_index);
+    return a_extreme_index_double_finish(a, n, indices, 4, i, max);
+}
+
+#endif
+
+// Selects the AVX2, SSE2, or scalar variant of a kernel.
+#if A_SIMD
+#define A_DISPATCH(kernel, ...) \
+    (a_has_avx2() ? kernel##_avx2(__VA_ARGS__) : kernel##_sse2(__VA_ARGS__))
+#else
+#define A_DISPATCH(kernel, ...) kernel##_scalar(__VA_ARGS__)
+#endif
+
+long a_sum_int(const int *a, int n) {
+    return A_DISPATCH(a_sum_int, a, n);
+}
+
+long a_dot_int(const int *a, const int *b, int n) {
+#if A_SIMD
+    // SSE2 has no signed 32 x 32 -> 64 bit multiplication
+    if (a_has_avx2()) return a_dot_int_avx2(a, b, n);
+#endif
+    return a_dot_int_scalar(a, b, n);
+}
+
+double a_squares_int(const int *a, int n, double mean) {
+    return A_DISPATCH(a_squares_int, a, n, mean);
+}
+
+int a_min_index_int(const int *a, int n) {
+    return A_DISPATCH(a_extreme_index_int, a, n, false);
+}
+
+int a_max_index_int(const int *a, int n) {
+    return A_DISPATCH(a_extreme_index_int, a, n, true);
+}
+
+double a_sum_double(const double *a, int n) {
+    return A_DISPATCH(a_sum_double, a, n);
+}
+
+double a_sum_double_fast(const double *a, int n) {
+    return A_DISPATCH(a_sum_double_fast, a, n);
+}
+
+double a_dot_double(const double *a, const double *b, int n) {
+    return A_DISPATCH(a_dot_double, a, b, n);
+}
+
+double a_squares_double(const double *a, int n, double mean) {
+    return A_DISPATCH(a_squares_double, a, n, mean);
+}
+
+int a_min_index_double(const double *a, int n) {
+    return A_DISPATCH(a_extreme_index_double, a, n, false);
+}
+
+int a_max_index_double(const double *a, int n) {
+    return A_DISPATCH(a_extreme_index_double, a, n, true);
+}
+
+static bool a_same_double(double x, double y) {
+    return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+static void a_reduce_simd_test(void) {
+    printsln((String)__func__);
+    // every length, compared to the scalar loops, the double sums bit for bit
+    int n = 100;
+    int *ints = xmalloc(n * sizeof(int));
+    int *ints2 = xmalloc(n * sizeof(int));
+    double *doubles = xmalloc(n * sizeof(double));
+    double *doubles2 = xmalloc(n * sizeof(double));
+    bool ok = true;
+    for (int len = 0; len <= n; len++) {
+        for (int i = 0; i < len; i++) {
+            ints[i] = i_rnd(2000001) - 1000000;
+            ints2[i] = i_rnd(2001) - 1000;
+            doubles[i] = (d_rnd(2.0) - 1.0) * (i % 3 == 0 ? 1e10 : 1.0);
+            doubles2[i] = d_rnd(1.0);
+        }
+        if (len > 5) {
+            ints[len / 3] = ints[len - 2]; // ties
+            doubles[len / 2] = NAN;
+        }
+        double mean = 0.25;
+        ok = ok && a_sum_int(ints, len) == a_sum_int_scalar(ints, len);
+        ok = ok && a_dot_int(ints, ints2, len) == a_dot_int_scalar(ints, ints2, len);
+        ok = ok && a_same_double(a_squares_int(ints, len, mean), a_squares_int_scalar(ints, len, mean));
+        ok = ok && a_min_index_int(ints, len) == a_extreme_index_int_scalar(ints, len, false);
+        ok = ok && a_max_index_int(ints, len) == a_extreme_index_int_scalar(ints, len, true);
+        ok = ok && a_same_double(a_sum_double(doubles2, len), a_sum_double_scalar(doubles2, len));
+        ok = ok && fabs(a_sum_double_fast(doubles2, len) - a_sum_double_scalar(doubles2, len)) < 1e-12;
+        ok = ok && a_same_double(a_dot_double(doubles, doubles2, len), a_dot_double_scalar(doubles, doubles2, len));
+        ok = ok && a_same_double(a_squares_double(doubles2, len, mean), a_squares_double_scalar(doubles2, len, mean));
+        ok = ok && a_min_index_double(doubles, len) == a_extreme_index_double_scalar(doubles, len, false);
+        ok = ok && a_max_index_double(doubles, len) == a_extreme_index_double_scalar(doubles, len, true);
+#if A_SIMD
+        ok = ok && a_sum_int_sse2(ints, len) == a_sum_int_scalar(ints, len);
+        ok = ok && a_same_double(a_squares_int_sse2(ints, len, mean), a_squares_int_scalar(ints, len, mean));
+        ok = ok && a_extreme_index_int_sse2(ints, len, false) == a_extreme_index_int_scalar(ints, len, false);
+        ok = ok && a_extreme_index_int_sse2(ints, len, true) == a_extreme_index_int_scalar(ints, len, true);
+        ok = ok && a_same_double(a_sum_double_sse2(doubles2, len), a_sum_double_scalar(doubles2, len));
+        ok = ok && a_same_double(a_dot_double_sse2(doubles, doubles2, len), a_dot_double_scalar(doubles, doubles2, len));
+        ok = ok && a_same_double(a_squares_double_sse2(doubles2, len, mean), a_squares_double_scalar(doubles2, len, mean));
+        ok = ok && a_extreme_index_double_sse2(doubles, len, false) == a_extreme_index_double_scalar(doubles, len, false);
+        ok = ok && a_extreme_index_double_sse2(doubles, len, true) == a_extreme_index_double_scalar(doubles, len, true);
+#endif
+    }
+    test_equal_b(ok, true);
+
+    // infinities and NaNs
+    double special[] = { NAN, INFINITY, NAN, -INFINITY, INFINITY, NAN, NAN, NAN, NAN };
+    test_equal_i(a_min_index_double(special, 9), 3);
+    test_equal_i(a_max_index_double(special, 9), 1);
+    test_equal_i(a_min_index_double(special + 4, 5), 0);
+    test_equal_i(a_min_index_double(special + 5, 4), -1);
+    test_equal_i(a_min_index_int(ints, 0), -1);
+    // all infinite, the first index wins
+    double infinities[] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+    test_equal_i(a_max_index_double(infinities, 5), 0);
+    test_equal_i(a_min_index_double(infinities, 5), 0);
+    for (int len = 1; len <= 9; len++) {
+        for (int j = 0; j < len; j++) { // one NaN at j
+            for (int max = 0; max <= 1; max++) {
+                for (int sign = 0; sign <= 1; sign++) {
+                    for (int i = 0; i < len; i++) doubles[i] = i == j ? NAN : (sign ? INFINITY : -INFINITY);
+                    int ex = a_extreme_index_double_scalar(doubles, len, max);
+                    ok = ok && ex == (j == 0 ? (len > 1 ? 1 : -1) : 0);
+                    ok = ok && (max ? a_max_index_double(doubles, len) : a_min_index_double(doubles, len)) == ex;
+#if A_SIMD
+                    ok = ok && a_extreme_index_double_sse2(doubles, len, max) == ex;
+#endif
+                }
+            }
+        }
+    }
+    test_equal_b(ok, true);
+
+    // compensated summation, a plain sum loses the small values added to 1.0
+    for (int i = 0; i < n; i++) doubles[i] = i == 0 ? 1.0 : 1e-16;
+    test_equal_b(a_sum_double(doubles, n) == 1.0 + 99e-16, true);
+    test_equal_b(a_sum_double_fast(doubles, n) < 1.0 + 99e-16, true);
+
+    // infinities are not lost in the compensation, at any position
+    for (int len = 1; len <= 20; len++) {
+        for (int j = 0; j < len; j++) {
+            for (int i = 0; i < len; i++) doubles[i] = i + 1;
+            doubles[j] = INFINITY;
+            ok = ok && a_sum_double(doubles, len) == INFINITY;
+            doubles[j] = -INFINITY;
+            ok = ok && a_sum_double(doubles, len) == -INFINITY;
+            doubles[len - 1 - j] = INFINITY;
+            ok = ok && (j == len - 1 - j ? a_sum_double(doubles, len) == INFINITY : isnan(a_sum_double(doubles, len)));
+            doubles[j] = 1e308; // overflow of finite elements
+            doubles[len - 1 - j] = 1e308;
+            ok = ok && (j == len - 1 - j || a_sum_double(doubles, len) == INFINITY);
+#if A_SIMD
+            ok = ok && a_same_double(a_sum_double_sse2(doubles, len), a_sum_double_scalar(doubles, len));
+#endif
+        }
+    }
+    test_equal_b(ok, true);
+    double mixed[] = { 1, INFINITY, 3 };
+    test_equal_b(a_sum_double(mixed, 3) == INFINITY, true);
+
+    free(ints);
+    free(ints2);
+    free(doubles);
+    free(doubles2);
+}
+
+// Kernels for the builtin predicates and functions (see ACompare). The 
+// comparison is loop invariant, so the branch on it is always predicted. 
+// The kernels only count A_GT, A_LT, and A_ODD for ints, a_count_int 
+// derives the other counts from these.
+
+static inline bool a_matches_int(int v, ACompare op, int x) {
+    switch (op) {
+        case A_GT: return v > x;
+        case A_GE: return v >= x;
+        case A_LT: return v < x;
+        case A_LE: return v <= x;
+        case A_EVEN: return (v & 1) == 0;
+        case A_ODD: return (v & 1) == 1;
+    }
+    return false;
+}
+
+static inline bool a_matches_double(double v, ACompare op, double x) {
+    switch (op) {
+        case A_GT: return v > x;
+        case A_GE: return v >= x;
+        case A_LT: return v < x;
+        case A_LE: return v <= x;
+        default: return false;
+    }
+}
+
+static int a_count_int_scalar(const int *a, int n, ACompare op, int x) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += a_matches_int(a[i], op, x);
+    }
+    return count;
+}
+
+static int a_count_double_scalar(const double *a, int n, ACompare op, double x) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += a_matches_double(a[i], op, x);
+    }
+    return count;
+}
+
+static void a_times_int_scalar(const int *a, int n, int x, int *out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = (int)((unsigned)a[i] * (unsigned)x);
+    }
+}
+
+static void a_times_double_scalar(const double *a, int n, double x, double *out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = a[i] * x;
+    }
+}
+
+// Called with a constant op, such that the comparison is inlined.
+static inline void a_select_int_with(const int *a, ACompare op, int x, int *out, int count) {
+    for (int i = 0, j = 0; j < count; i++) {
+        out[j] = a[i];
+        j += a_matches_int(a[i], op, x);
+    }
+}
+
+static inline void a_select_double_with(const double *a, ACompare op, double x, double *out, int count) {
+    for (int i = 0, j = 0; j < count; i++) {
+        out[j] = a[i];
+        j += a_matches_double(a[i], op, x);
+    }
+}
+
+#if A_SIMD
+
+static inline __m128i a_compare_int_sse2(__m128i y, ACompare op, __m128i x) {
+    switch (op) {
+        case A_GT: return _mm_cmpgt_epi32(y, x);
+        case A_LT: return _mm_cmplt_epi32(y, x);
+        default: return _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(y, _mm_set1_epi32(1))); // A_ODD
+    }
+}
+
+static int a_count_int_sse2(const int *a, int n, ACompare op, int x) {
+    __m128i v = _mm_set1_epi32(x), c0 = _mm_setzero_si128(), c1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // a match is -1
+        c0 = _mm_sub_epi32(c0, a_compare_int_sse2(_mm_loadu_si128((const __m128i*)(a + i)), op, v));
+        c1 = _mm_sub_epi32(c1, a_compare_int_sse2(_mm_loadu_si128((const __m128i*)(a + i + 4)), op, v));
+    }
+    int c[4];
+    _mm_storeu_si128((__m128i*)c, _mm_add_epi32(c0, c1));
+    return c[0] + c[1] + c[2] + c[3] + a_count_int_scalar(a + i, n - i, op, x);
+}
+
+static inline __m128d a_compare_double_sse2(__m128d y, ACompare op, __m128d x) {
+    switch (op) {
+        case A_GT: return _mm_cmpgt_pd(y, x);
+        case A_GE: return _mm_cmpge_pd(y, x);
+        case A_LT: return _mm_cmplt_pd(y, x);
+        default: return _mm_cmple_pd(y, x); // A_LE
+    }
+}
+
+static int a_count_double_sse2(const double *a, int n, ACompare op, double x) {
+    __m128d v = _mm_set1_pd(x);
+    __m128i c0 = _mm_setzero_si128(), c1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 = _mm_sub_epi64(c0, _mm_castpd_si128(a_compare_double_sse2(_mm_loadu_pd(a + i), op, v)));
+        c1 = _mm_sub_epi64(c1, _mm_castpd_si128(a_compare_double_sse2(_mm_loadu_pd(a + i + 2), op, v)));
+    }
+    long c[2];
+    _mm_storeu_si128((__m128i*)c, _mm_add_epi64(c0, c1));
+    return (int)(c[0] + c[1]) + a_count_double_scalar(a + i, n - i, op, x);
+}
+
+static void a_times_int_sse2(const int *a, int n, int x, int *out) {
+    // SSE2 multiplies only the even lanes, the odd ones are shifted there
+    __m128i v = _mm_set1_epi32(x);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i y = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i even = _mm_mul_epu32(y, v);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(y, 32), v);
+        __m128i p = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), 
+                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        _mm_storeu_si128((__m128i*)(out + i), p);
+    }
+    a_times_int_scalar(a + i, n - i, x, out + i);
+}
+
+static void a_times_double_sse2(const double *a, int n, double x, double *out) {
+    __m128d v = _mm_set1_pd(x);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), v));
+        _mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_loadu_pd(a + i + 2), v));
+    }
+    a_times_double_scalar(a + i, n - i, x, out + i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i a_compare_int_avx2(__m256i y, ACompare op, __m256i x) {
+    switch (op) {
+        case A_GT: return _mm256_cmpgt_epi32(y, x);
+        case A_LT: return _mm256_cmpgt_epi32(x, y);
+        default: return _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(y, _mm256_set1_epi32(1))); // A_ODD
+    }
+}
+
+__attribute__((target("avx2")))
+static int a_count_int_avx2(const int *a, int n, ACompare op, int x) {
+    __m256i v = _mm256_set1_epi32(x), c0 = _mm256_setzero_si256(), c1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        c0 = _mm256_sub_epi32(c0, a_compare_int_avx2(_mm256_loadu_si256((const __m256i*)(a + i)), op, v));
+        c1 = _mm256_sub_epi32(c1, a_compare_int_avx2(_mm256_loadu_si256((const __m256i*)(a + i + 8)), op, v));
+    }
+    int c[8];
+    _mm256_storeu_si256((__m256i*)c, _mm256_add_epi32(c0, c1));
+    int count = 0;
+    for (int k = 0; k < 8; k++) count += c[k];
+    return count + a_count_int_scalar(a + i, n - i, op, x);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d a_compare_double_avx2(__m256d y, ACompare op, __m256d x) {
+    switch (op) {
+        case A_GT: return _mm256_cmp_pd(y, x, _CMP_GT_OQ);
+        case A_GE: return _mm256_cmp_pd(y, x, _CMP_GE_OQ);
+        case A_LT: return _mm256_cmp_pd(y, x, _CMP_LT_OQ);
+        default: return _mm256_cmp_pd(y, x, _CMP_LE_OQ); // A_LE
+    }
+}
+
+__attribute__((target("avx2")))
+static int a_count_double_avx2(const double *a, int n, ACompare op, double x) {
+    __m256d v = _mm256_set1_pd(x);
+    __m256i c0 = _mm256_setzero_si256(), c1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        c0 = _mm256_sub_epi64(c0, _mm256_castpd_si256(a_compare_double_avx2(_mm256_loadu_pd(a + i), op, v)));
+        c1 = _mm256_sub_epi64(c1, _mm256_castpd_si256(a_compare_double_avx2(_mm256_loadu_pd(a + i + 4), op, v)));
+    }
+    long c[4];
+    _mm256_storeu_si256((__m256i*)c, _mm256_add_epi64(c0, c1));
+    return (int)(c[0] + c[1] + c[2] + c[3]) + a_count_double_scalar(a + i, n - i, op, x);
+}
+
+__attribute__((target("avx2")))
+static void a_times_int_avx2(const int *a, int n, int x, int *out) {
+    __m256i v = _mm256_set1_epi32(x);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i p0 = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+        __m256i p1 = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(a + i + 8)), v);
+        _mm256_storeu_si256((__m256i*)(out + i), p0);
+        _mm256_storeu_si256((__m256i*)(out + i + 8), p1);
+    }
+    a_times_int_scalar(a + i, n - i, x, out + i);
+}
+
+__attribute__((target("avx2")))
+static void a_times_double_avx2(const double *a, int n, double x, double *out) {
+    __m256d v = _mm256_set1_pd(x);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d p0 = _mm256_mul_pd(_mm256_loadu_pd(a + i), v);
+        __m256d p1 = _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), v);
+        _mm256_storeu_pd(out + i, p0);
+        _mm256_storeu_pd(out + i + 4, p1);
+    }
+    a_times_double_scalar(a + i, n - i, x, out + i);
+}
+
+#endif
+
+int a_count_int(const int *a, int n, ACompare op, int x) {
+    switch (op) {
+        case A_GE: return n - a_count_int(a, n, A_LT, x);
+        case A_LE: return n - a_count_int(a, n, A_GT, x);
+        case A_EVEN: return n - a_count_int(a, n, A_ODD, x);
+        default: return A_DISPATCH(a_count_int, a, n, op, x);
+    }
+}
+
+void a_select_int(const int *a, ACompare op, int x, int *out, int count) {
+    // one loop per comparison
+    switch (op) {
+        case A_GT: a_select_int_with(a, A_GT, x, out, count); break;
+        case A_GE: a_select_int_with(a, A_GE, x, out, count); break;
+        case A_LT: a_select_int_with(a, A_LT, x, out, count); break;
+        case A_LE: a_select_int_with(a, A_LE, x, out, count); break;
+        case A_EVEN: a_select_int_with(a, A_EVEN, x, out, count); break;
+        case A_ODD: a_select_int_with(a, A_ODD, x, out, count); break;
+    }
+}
+
+void a_times_int(const int *a, int n, int x, int *out) {
+    A_DISPATCH(a_times_int, a, n, x, out);
+}
+
+int a_count_double(const double *a, int n, ACompare op, double x) {
+    require("comparison", op <= A_LE);
+    return A_DISPATCH(a_count_double, a, n, op, x);
+}
+
+void a_select_double(const double *a, ACompare op, double x, double *out, int count) {
+    require("comparison", op <= A_LE);
+    switch (op) {
+        case A_GT: a_select_double_with(a, A_GT, x, out, count); break;
+        case A_GE: a_select_double_with(a, A_GE, x, out, count); break;
+        case A_LT: a_select_double_with(a, A_LT, x, out, count); break;
+        default: a_select_double_with(a, A_LE, x, out, count); break;
+    }
+}
+
+void a_times_double(const double *a, int n, double x, double *out) {
+    A_DISPATCH(a_times_double, a, n, x, out);
+}
+
+static void a_builtin_simd_test(void) {
+    printsln((String)__func__);
+    // every length and comparison, compared to the scalar loops
+    int n = 100;
+    int *ints = xmalloc(n * sizeof(int));
+    int *ints2 = xmalloc(n * sizeof(int));
+    int *ints3 = xmalloc(n * sizeof(int));
+    double *doubles = xmalloc(n * sizeof(double));
+    double *doubles2 = xmalloc(n * sizeof(double));
+    double *doubles3 = xmalloc(n * sizeof(double));
+    bool ok = true;
+    for (int len = 0; len <= n; len++) {
+        for (int i = 0; i < len; i++) {
+            ints[i] = i_rnd(21) - 10;
+            doubles[i] = i % 7 == 3 ? NAN : (double)(i_rnd(21) - 10);
+        }
+        if (len > 0) ints[len - 1] = i_rnd(2) ? INT_MIN : INT_MAX;
+        int x = i_rnd(21) - 10;
+        for (ACompare op = A_GT; op <= A_ODD; op++) {
+            int count = a_count_int(ints, len, op, x);
+            ok = ok && count == a_count_int_scalar(ints, len, op, x);
+            a_select_int(ints, op, x, ints2, count);
+            for (int i = 0, j = 0; i < len; i++) {
+                if (a_matches_int(ints[i], op, x)) ok = ok && ints2[j++] == ints[i];
+            }
+            if (op > A_LE) continue;
+            count = a_count_double(doubles, len, op, x);
+            ok = ok && count == a_count_double_scalar(doubles, len, op, x);
+            a_select_double(doubles, op, x, doubles2, count);
+            for (int i = 0, j = 0; i < len; i++) {
+                if (a_matches_double(doubles[i], op, x)) ok = ok && doubles2[j++] == doubles[i];
+            }
+        }
+        a_times_int(ints, len, x, ints2);
+        a_times_int_scalar(ints, len, x, ints3);
+        ok = ok && memcmp(ints2, ints3, len * sizeof(int)) == 0;
+        a_times_double(doubles, len, 0.5 * x, doubles2);
+        a_times_double_scalar(doubles, len, 0.5 * x, doubles3);
+        ok = ok && memcmp(doubles2, doubles3, len * sizeof(double)) == 0;
+#if A_SIMD
+        ACompare kernel_ops[] = { A_GT, A_LT, A_ODD }; // the others are derived
+        for (int k = 0; k < 3; k++) {
+            ACompare op = kernel_ops[k];
+            ok = ok && a_count_int_sse2(ints, len, op, x) == a_count_int_scalar(ints, len, op, x);
+        }
+        for (ACompare op = A_GT; op <= A_LE; op++) {
+            ok = ok && a_count_double_sse2(doubles, len, op, x) == a_count_double_scalar(doubles, len, op, x);
+        }
+        a_times_int_sse2(ints, len, x, ints2);
+        ok = ok && memcmp(ints2, ints3, len * sizeof(int)) == 0;
+        a_times_double_sse2(doubles, len, 0.5 * x, doubles2);
+        ok = ok && memcmp(doubles2, doubles3, len * sizeof(double)) == 0;
+#endif
+    }
+    test_equal_b(ok, true);
+
+    int odd[] = { -3, -2, -1, 0, 1, 2, 3 };
+    test_equal_i(a_count_int(odd, 7, A_ODD, 0), 4);
+    test_equal_i(a_count_int(odd, 7, A_EVEN, 0), 3);
+
+    free(ints);
+    free(ints2);
+    free(ints3);
+    free(doubles);
+    free(doubles2);
+    free(doubles3);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
+static void a_inc(IntPair *element, int index, Any state, IntPair *mapped_element) {
+    mapped_element->i = element->i + 1;
+    mapped_element->j = element->j + 1;
+}
+
+static void a_int_pair_i(IntPair *element, int index, Any state, int *mapped_element) {
+    *mapped_element = element->i;
+}
+
+static void a_map_test(void) {
+    printsln((String)__func__);
+    Array ac, acm, ex;
+    IntPair ip;
+
+    ac = a_create(3, sizeof(IntPair));
+    ip = make_int_pair(1, 10);
+    a_set(ac, 0, &ip);
+    ip = make_int_pair(2, 20);
+    a_set(ac, 1, &ip);
+    ip = make_int_pair(3, 30);
+    a_set(ac, 2, &ip);
+    // a_println(ac, print_int_pair);
+    
+    acm = a_map(ac, a_inc, sizeof(IntPair), NULL);
+    // a_println(acm, print_int_pair);
+
+    ex = a_create(3, sizeof(IntPair));
+    ip = make_int_pair(2, 11);
+    a_set(ex, 0, &ip);
+    ip = make_int_pair(3, 21);
+    a_set(ex, 1, &ip);
+    ip = make_int_pair(4, 31);
+    a_set(ex, 2, &ip);
+    
+    a_test_equal(acm, ex);
+    a_free(acm);
+    a_free(ex);
+
+    ex = a_create(3, sizeof(int));
+    int i = 1;
+    a_set(ex, 0, &i);
+    i = 2;
+    a_set(ex, 1, &i);
+    i = 3;
+    a_set(ex, 2, &i);
+
+    acm = a_map(ac, a_int_pair_i, sizeof(int), NULL);
+
+    a_test_equal(acm, ex);
+    
+    ia_println(acm);
+
+    a_free(ex);
+    a_free(acm);
+    a_free(ac);
+}
+
+Array a_map(Array array, AnyFn f, int mapped_element_size, Any state) {
+    require_not_null(array);
     require_not_null(f);
     require("positive size", mapped_element_size > 0);
     AnyIntAnyAnyToVoid ff = f;
-    Byte *a = xcalloc(array->n, mapped_element_size);
+    Array result = a_alloc(array->n, mapped_element_size, true);
+    Byte *a = result->a;
     for (int i = 0; i < array->n; i++) {
         ff((Byte*)array->a + i * array->s, i, state, a + i * mapped_element_size);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = mapped_element_size;
-    result->a = a;
     return result;
     
     return result;
@@ -1092,16 +3748,13 @@ Array a_map2(Array a1, Array a2, AnyFn f, int mapped_element_size, Any state) {
     require_not_null(f);
     AnyAnyIntAnyAnyToVoid ff = f;
     int n = (a1->n < a2->n) ? a1->n : a2->n;
-    Byte *a = xcalloc(n, mapped_element_size);
+    Array result = a_alloc(n, mapped_element_size, true);
+    Byte *a = result->a;
     for (int i = 0; i < n; i++) {
         ff((Byte*)a1->a + i * a1->s, 
           (Byte*)a2->a + i * a2->s, 
           i, state, a + i * mapped_element_size);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = mapped_element_size;
-    result->a = a;
     return result;
 }
 
@@ -1159,17 +3812,14 @@ Array a_map3(Array a1, Array a2, Array a3, AnyFn f, int mapped_element_size, Any
     require_not_null(f);
     AnyAnyAnyIntAnyAnyToVoid ff = f;
     int n = (a1->n < a2->n && a1->n < a3->n) ? a1->n : ((a2->n < a1->n && a2->n < a3->n) ? a2->n : a3->n);
-    Byte *a = xcalloc(n, mapped_element_size);
+    Array result = a_alloc(n, mapped_element_size, true);
+    Byte *a = result->a;
     for (int i = 0; i < n; i++) {
         ff((Byte*)a1->a + i * a1->s, 
           (Byte*)a2->a + i * a2->s, 
           (Byte*)a3->a + i * a3->s, 
           i, state, a + i * mapped_element_size);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = mapped_element_size;
-    result->a = a;
     return result;
 }
 #endif
@@ -1213,6 +3863,7 @@ static void a_each_test(void) {
 void a_each(Array array, AnyFn f, Any state) {
     require_not_null(array);
     require_not_null(f);
+    a_unshare(array);
     AnyIntAnyToVoid ff = f;
     for (int i = 0; i < array->n; i++) {
         ff((Byte*)array->a + i * array->s, i, state);
@@ -1385,7 +4036,8 @@ Array a_filter(Array array, AnyFn predicate, Any state) {
         ps[i] = f((Byte*)array->a + i * array->s, i, state);
         if (ps[i]) n++;
     }
-    Byte *a = xcalloc(n, array->s);
+    Array result = a_alloc(n, array->s, true);
+    Byte *a = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             memcpy(a + j * array->s, (Byte*)array->a + i * array->s, array->s);
@@ -1393,10 +4045,6 @@ Array a_filter(Array array, AnyFn predicate, Any state) {
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = array->s;
-    result->a = a;
     return result;
 }
 
@@ -1516,17 +4164,34 @@ bool a_test_equal_file_line(const char *file, const char *function, int line, Ar
 
 void a_test_all(void) {
     a_create_test();
+    a_aligned_test();
+    a_inline_test();
+    a_footprint_test();
     a_of_buffer_test();
     a_fn_test();
     a_copy_test();
+    a_copy_on_write_test();
     a_sub_test();
+    a_view_test();
     a_blit_test();
     a_concat_test();
+    a_push_pop_test();
+    a_reserve_test();
+    a_append_test();
     a_index_fn_test();
     a_last_index_fn_test();
     a_reverse_test();
     a_shuffle_test();
     a_sort_test();
+    a_sort_from_to_test();
+    a_sort_stable_test();
+    a_sort_parallel_test();
+    a_fill_from_to_test();
+    a_sort_define_test();
+    a_radix_sort_test();
+    a_index_simd_test();
+    a_reduce_simd_test();
+    a_builtin_simd_test();
     a_map_test();
 //    a_map2_test();
 //    a_map3_test();
@@ -5,6 +5,8 @@ It stores a fixed number of elements. Each element has a size of s bytes. The nu
 There are more specific arrays for integers, doubles, strings, and pointers. 
 They are more convenient for these types. Some functions are shared between array implementations. For example, \ref a_length works with any kind of array.
 
+An array is a single block of memory: the head (length, element size, capacity) fills the first 64 bytes and the elements follow inline. Creating an array thus needs a single allocation and accessing an element touches the cache line of the head, not a separate block. If an array outgrows its capacity (see @ref a_push, @ref a_reserve), its elements move to a separate block. The elements of arrays of at least 256 bytes start at a multiple of 64 (the size of a cache line), those of smaller arrays at a multiple of 16.
+
 @author Michael Rohs
 @date 15.10.2015
 @copyright Apache License, Version 2.0
@@ -15,9 +17,35 @@ They are more convenient for these types. Some functions are shared between arra
 
 #include "base.h"
 
+/**
+Allocates an array of n elements of size s. The head and the elements are stored in a single block of memory.
+@param[in] file file name of source code
+@param[in] function function name of source code
+@param[in] line line number in source code
+@param[in] n number of elements
+@param[in] s element size in bytes
+@param[in] clear whether to set the elements to 0
+@return the array, the elements are uninitialized unless clear is true
+@pre "non-negative length", n >= 0
+@pre "positive size", s > 0
+@see a_alloc
+@private
+*/
+Array a_alloc_file_line(const char *file, const char *function, int line, int n, int s, bool clear);
+
+/**
+Allocates an array of n elements of size s. The allocation is attributed to the calling function (e.g., in @ref print_memory_footprint).
+@param[in] n number of elements
+@param[in] s element size in bytes
+@param[in] clear whether to set the elements to 0
+@return the array, the elements are uninitialized unless clear is true
+@private
+*/
+#define a_alloc(n, s, clear) a_alloc_file_line(__FILE__, __func__, __LINE__, n, s, clear)
+
 /**
 Creates an array of n elements of size s, all initialized to 0.
-The array occupies a block of n * s bytes of memory.
+The array occupies a single block of 64 + n * s bytes of memory.
 @param[in] n number of elements
 @param[in] s element size in bytes
 @return zero-initialized array
@@ -72,12 +100,47 @@ Array a_fn(int n, int s, AnyFn init, Any state);
 
 /**
 Creates a copy of the given array.
-The bytes of the array elements are copied.
 @param[in] array to be copied
 @return the copy of the array
+@see a_copy_shared
 */
 Array a_copy(Array array);
 
+/**
+Creates a copy of the given array that is made lazily (copy-on-write): At first, the copy shares the elements with the array, which takes constant time. The bytes of the elements are copied when the copy or the array is modified for the first time by a function of this library (e.g., with @ref a_set, @c ia_set, @c ia_fill, @ref a_sort, @ref a_push). 
+
+Memory written through pointers from @ref a_get or through @c array->a is not detected: while the elements are shared, such a write changes both arrays. Call @ref a_unshare_elements on the array before writing through such pointers, or use @ref a_copy. Views are always copied right away, as is an array that has views, since these modify its elements in place. Compile with -DNO_COPY_ON_WRITE to always copy right away.
+@param[in] array to be copied
+@return the copy of the array
+@see a_print_copy_stats
+*/
+Array a_copy_shared(Array array);
+
+/**
+Makes sure that the elements of the array are not shared with other arrays (see @ref a_copy_shared), copying them if necessary. Every function that modifies elements calls this first.
+@param[in,out] array input array
+@private
+*/
+#define a_unshare(array) do { if ((array)->share != NULL) a_unshare_elements(array); } while (0)
+
+/**
+Copies the elements of the array if they are shared with other arrays (see @ref a_copy_shared). Afterwards the elements may be written through pointers.
+@param[in,out] array input array
+@see a_unshare
+*/
+void a_unshare_elements(Array array);
+
+/**
+Returns how many copies @ref a_copy_shared has avoided so far. These are the copies that shared their elements with the original and were never made, because neither the copy nor the original were modified while they shared the elements.
+@return the number of avoided copies
+*/
+long a_copies_avoided(void);
+
+/**
+Prints how many arrays @ref a_copy_shared has shared, how many of them had to be copied on write, and how many copies were avoided.
+*/
+void a_print_copy_stats(void);
+
 /**
 Creates a new subarray consisting of array[i, j).
 Index i is inclusive, index j is exclusive.
@@ -88,6 +151,26 @@ Index i is inclusive, index j is exclusive.
 */
 Array a_sub(Array array, int i, int j);
 
+/**
+Creates a view of array[i, j). Index i is inclusive, index j is exclusive. A view is an array whose elements are the elements of the viewed array, nothing is copied. All functions that take an array accept a view, e.g., @c ia_foldl, @c da_filter, @c sa_contains. Modifying the elements of the view (e.g., with @c ia_set, @c ia_fill, @ref a_sort) modifies the viewed array. This way, a sub-range of an array can be processed in place.
+
+The view remains valid as long as the viewed array is neither freed nor grown (see @ref a_push). Freeing a view (with @ref a_free, @c sa_free, or @c pa_free) does not free the elements. Growing a view copies its elements, after which it is an independent array.
+@param[in] array the array to view
+@param[in] i start index (inclusive)
+@param[in] j end index (exclusive)
+@return the view
+@pre "valid range", 0 <= i <= j <= a_length(array)
+*/
+Array a_view(Array array, int i, int j);
+
+/**
+Returns true iff the array is a view of another array.
+@param[in] array input array
+@return true iff array is a view
+@see a_view
+*/
+bool a_is_view(Array array);
+
 /**
 Creates a new array by copying the elements of the list.
 @param[in] list the elements of the list will be copied
@@ -116,6 +199,14 @@ Frees the memory of the array.
 */
 void a_free(Array array);
 
+/**
+Returns how many bytes the array occupies. The payload are the n * s bytes of the elements. The structure is the array head and the rounding of the allocator. The tracker overhead are the headers of memory tracking. Works for all kinds of arrays. For string arrays and pointer arrays, the referenced strings and objects are not included.
+@param[in] array input array
+@return the footprint of the array
+@see memory_footprint
+*/
+Footprint a_footprint(Array array);
+
 /**
 Returns the memory address of the array element at index.
 @param[in] array input array
@@ -187,6 +278,69 @@ The elements of x come first, followed by the elements of y.
 */
 Array a_concat(Array x, Array y);
 
+/**
+Returns the capacity of the array, i.e., the number of elements that fit into the array before it has to be reallocated. The capacity is at least the length. Arrays are created with a capacity equal to their length.
+@param[in] array input array
+@return the capacity
+*/
+int a_capacity(Array array);
+
+/**
+Makes sure that the array can hold at least capacity elements without reallocation. Does not change the length. Never reduces the capacity. Works for all kinds of arrays.
+@param[in,out] array input array
+@param[in] capacity the minimum capacity
+@pre "non-negative capacity", capacity >= 0
+*/
+void a_reserve(Array array, int capacity);
+
+/**
+Reduces the capacity of the array to its length. Does nothing if the elements are still stored inline with the head. Works for all kinds of arrays.
+@param[in,out] array input array
+*/
+void a_shrink_to_fit(Array array);
+
+/**
+Makes room for n more elements. Grows the capacity geometrically, such that a sequence of pushes takes amortized constant time per element.
+@param[in,out] array input array
+@param[in] n number of elements to make room for
+@private
+*/
+void a_grow(Array array, int n);
+
+/**
+Appends an element at the end of the array. Copies a_element_size(array) bytes from value. The capacity grows geometrically, so pushing n elements takes O(n) time. Pointers to elements (e.g., from @ref a_get) become invalid when the capacity grows.
+@param[in,out] array input array
+@param[in] value address of the element to append
+@see ia_push, da_push, sa_push, pa_push, ba_push
+*/
+void a_push(Array array, Any value);
+
+/**
+Removes the last element of the array. Returns the address of the removed element, which remains valid until the next element is added to the array. Does not reduce the capacity.
+@param[in,out] array input array
+@return the address of the removed element
+@pre "not empty", a_length(array) > 0
+@see ia_pop, da_pop, sa_pop, pa_pop, ba_pop
+*/
+Any a_pop(Array array);
+
+/**
+Appends the elements of x at the end of the array. Modifies the array, does not modify x. x may be the array itself. Works for all kinds of arrays. For string arrays and pointer arrays the strings and objects are not copied.
+@param[in,out] array input array
+@param[in] x the elements to append
+@pre "equal element sizes", array->s == x->s
+*/
+void a_append(Array array, Array x);
+
+/**
+Appends n elements at the end of the array by copying n * a_element_size(array) bytes from buffer. Works for all kinds of arrays.
+@param[in,out] array input array
+@param[in] buffer the elements to append
+@param[in] n number of elements
+@pre "non-negative length", n >= 0
+*/
+void a_append_buffer(Array array, Any buffer, int n);
+
 /**
 Returns index of first element for which the predicate function returns true.
 Returns -1 if predicate does not return true for any element.
@@ -241,6 +395,7 @@ void a_shuffle(Array array);
 
 /**
 Sorts the elements using the given comparator function. Modifies the array.
+The comparator is called through a function pointer. For arrays of a fixed element type, a sort function generated with @ref A_SORT_DEFINE (see array_sort.h) compares inline and is faster.
 
 @param[in,out] array input array
 @param[in] c comparator function to compare two elements
@@ -261,6 +416,362 @@ a_free(a);
 */
 void a_sort(Array array, Comparator c);
 
+/**
+Sorts the elements array[from, to) in place, using comparator c. The other elements are not touched. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array input array
+@param[in] c comparator
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+@see a_view
+*/
+void a_sort_from_to(Array array, Comparator c, int from, int to);
+
+/**
+Sorts the elements in place, using comparator c, such that equal elements keep their relative order (stable sort). @ref a_sort is not stable.
+
+The algorithm is a natural merge sort: ascending and strictly descending runs in the input are detected (descending runs are reversed) and merged. Sorted and strictly decreasing arrays take O(n) time, nearly sorted arrays close to that, and any array O(n log n) time. Short runs are extended with binary insertion sort. The merges use one temporary buffer for up to n / 2 elements.
+
+@param[in,out] array input array
+@param[in] c comparator
+
+<b>Example:</b>
+@code{.c}
+Array a = a_create(3, sizeof(IntPair));
+a_set(a, 0, &(IntPair){ 2, 0 });
+a_set(a, 1, &(IntPair){ 1, 1 });
+a_set(a, 2, &(IntPair){ 2, 2 });
+a_sort_stable(a, compare_by_i); // [(1, 1), (2, 0), (2, 2)]
+a_free(a);
+@endcode
+*/
+void a_sort_stable(Array array, Comparator c);
+
+/**
+Each thread of a parallel sort gets at least this many elements. Shorter arrays are sorted by a single thread.
+@private
+*/
+#define A_SORT_PARALLEL_MIN 32768
+
+/**
+The maximum number of threads of a parallel sort.
+@private
+*/
+#define A_SORT_PARALLEL_MAX_THREADS 64
+
+/**
+The steps of a parallel sort for a specific element type (see @ref a_sort_parallel_with). Each function gets the element size s and the comparator c that were given to the sort.
+@private
+*/
+typedef struct ASortParallel {
+    void (*sort)(Any a, int n, int s, Comparator c); ///< sorts the n elements at a
+    int (*split)(ConstAny a, int na, ConstAny b, int nb, int d, int s, Comparator c); ///< returns how many of the first d merged elements come from a
+    void (*merge)(ConstAny a, int na, ConstAny b, int nb, Any out, int s, Comparator c); ///< merges a and b into out, equal elements of a first
+} ASortParallel;
+
+/**
+Sorts the array with several threads. The array is split into one range per thread, each thread sorts its range with ops->sort, then pairs of sorted ranges are merged in rounds, with the threads sharing the merge of each pair. The result is that of ops->sort on the whole array, as long as ops->sort orders equal elements the same way (e.g., because it is stable or equal elements cannot be told apart).
+@param[in,out] array input array
+@param[in] c comparator, given to the functions of ops (may be NULL if they do not use it)
+@param[in] threads number of threads, 0 for one per processor
+@param[in] ops sort, split, and merge functions
+@see A_MERGE_DEFINE
+@private
+*/
+void a_sort_parallel_with(Array array, Comparator c, int threads, const ASortParallel *ops);
+
+/**
+Sorts the elements in place, using comparator c, with the given number of threads. The result is the same as that of @ref a_sort_stable, i.e., equal elements keep their relative order.
+
+The array is split into one range per thread. The threads sort their ranges and then merge them pairwise in log2(threads) rounds, sharing the work of each merge. The merges need a temporary copy of the array. Each thread gets at least @ref A_SORT_PARALLEL_MIN elements, so short arrays are sorted by the calling thread alone. Compile with -DNO_THREADS to always sort in the calling thread.
+@param[in,out] array input array
+@param[in] c comparator
+@param[in] threads number of threads, 0 for one per processor
+@pre "non-negative thread count", threads >= 0
+*/
+void a_sort_parallel(Array array, Comparator c, int threads);
+
+/**
+Sets the elements array[from, to) to value. Copies a_element_size(array) bytes from value for each element. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array input array
+@param[in] value address of the value to set
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+*/
+void a_fill_from_to(Array array, Any value, int from, int to);
+
+/**
+Minimum number of elements for which @c ia_sort and @c ba_sort (and their variants) use radix sort instead of introsort (see array_sort.h). Below it, the histograms of radix sort cost more than the comparisons of introsort.
+@private
+*/
+#define A_RADIX_SORT_MIN 64
+
+/**
+Minimum number of elements for which @c da_sort (and its variants) use radix sort instead of introsort (see array_sort.h). Doubles need eight passes instead of four, thus the threshold is higher than @ref A_RADIX_SORT_MIN.
+@private
+*/
+#define A_RADIX_SORT_MIN_DOUBLE 128
+
+/**
+Sorts the ints using a least-significant-digit radix sort with four passes over 8-bit digits. Passes in which all elements have the same digit are skipped. Takes O(n) time and n ints of temporary memory.
+@param[in,out] a the ints to sort
+@param[in] n number of ints
+@param[in] descending whether to sort in descending order
+@see ia_sort, ia_sort_dec
+@private
+*/
+void a_radix_sort_int(int *a, int n, bool descending);
+
+/**
+Sorts the doubles using a least-significant-digit radix sort over the IEEE 754 representation. The bits are mapped to keys that compare like the numbers: The sign bit of positive numbers is set, all bits of negative numbers are flipped. Thus -0.0 comes before 0.0 and NaNs come before negative infinity or after positive infinity, depending on their sign bit. Takes O(n) time and n doubles of temporary memory.
+@param[in,out] a the doubles to sort
+@param[in] n number of doubles
+@param[in] descending whether to sort in descending order
+@see da_sort, da_sort_dec
+@private
+*/
+void a_radix_sort_double(double *a, int n, bool descending);
+
+/**
+Sorts the bytes by counting how often each of the 256 values occurs. Takes O(n) time and no temporary memory.
+@param[in,out] a the bytes to sort
+@param[in] n number of bytes
+@param[in] descending whether to sort in descending order
+@see ba_sort, ba_sort_dec
+@private
+*/
+void a_counting_sort_byte(Byte *a, int n, bool descending);
+
+/**
+Returns the index of the first occurrence of value in a[0, n), or -1 if value does not occur. On x86-64, compares 8 ints per instruction with AVX2 or 4 with SSE2, depending on the CPU it runs on. Compile with -DNO_SIMD to use a plain loop.
+@param[in] a the ints to search
+@param[in] n number of ints
+@param[in] value value to search for
+@return index or -1
+@see ia_index, ia_index_from, ia_contains
+@private
+*/
+int a_index_int(const int *a, int n, int value);
+
+/**
+Returns the index of the last occurrence of value in a[0, n), or -1 if value does not occur. Vectorized like @ref a_index_int.
+@param[in] a the ints to search
+@param[in] n number of ints
+@param[in] value value to search for
+@return index or -1
+@see ia_last_index, ia_last_index_from
+@private
+*/
+int a_last_index_int(const int *a, int n, int value);
+
+/**
+Returns the index of the first element x in a[0, n) with |x - value| < epsilon, or -1 if there is none. Vectorized like @ref a_index_int, with 4 (AVX2) or 2 (SSE2) doubles per instruction.
+@param[in] a the doubles to search
+@param[in] n number of doubles
+@param[in] value value to search for
+@param[in] epsilon maximum distance (exclusive)
+@return index or -1
+@see da_index, da_index_from, da_contains
+@private
+*/
+int a_index_double(const double *a, int n, double value, double epsilon);
+
+/**
+Returns the sum of the ints as a long, which does not overflow for less than 2^32 ints. Vectorized like @ref a_index_int.
+@param[in] a the ints
+@param[in] n number of ints
+@return the sum
+@see ia_sum
+@private
+*/
+long a_sum_int(const int *a, int n);
+
+/**
+Returns the dot product of the ints a[0, n) and b[0, n) as a long. The products are computed with 64 bits. Vectorized with AVX2.
+@param[in] a the first ints
+@param[in] b the second ints
+@param[in] n number of ints
+@return the dot product
+@see ia_dot
+@private
+*/
+long a_dot_int(const int *a, const int *b, int n);
+
+/**
+Returns the sum of (a[i] - mean)^2 over a[0, n), in double precision. Summed like @ref a_dot_double.
+@param[in] a the ints
+@param[in] n number of ints
+@param[in] mean value subtracted from each int
+@return the sum of the squared deviations from mean
+@see ia_variance, ia_norm
+@private
+*/
+double a_squares_int(const int *a, int n, double mean);
+
+/**
+Returns the index of the first smallest int in a[0, n), or -1 if n is 0. Vectorized like @ref a_index_int, each lane keeps its smallest element and its index.
+@param[in] a the ints
+@param[in] n number of ints
+@return index or -1
+@see ia_min_index
+@private
+*/
+int a_min_index_int(const int *a, int n);
+
+/**
+Returns the index of the first largest int in a[0, n), or -1 if n is 0. Vectorized like @ref a_min_index_int.
+@param[in] a the ints
+@param[in] n number of ints
+@return index or -1
+@see ia_max_index
+@private
+*/
+int a_max_index_int(const int *a, int n);
+
+/**
+Returns the sum of the doubles with compensated (Kahan) summation in 8 lanes: lane k adds up the elements with index i % 8 == k. The scalar, SSE2, and AVX2 variants perform the same operations in the same order, thus the result is the same on any CPU. The error is independent of n in the first order, while that of a plain sum grows with n.
+@param[in] a the doubles
+@param[in] n number of doubles
+@return the sum
+@see da_sum
+@private
+*/
+double a_sum_double(const double *a, int n);
+
+/**
+Returns the sum of the doubles, with as many partial sums as the vector unit can add at a time (4 scalar, 8 with SSE2, 16 with AVX2). The rounding thus depends on the CPU.
+@param[in] a the doubles
+@param[in] n number of doubles
+@return the sum
+@see da_sum_fast
+@private
+*/
+double a_sum_double_fast(const double *a, int n);
+
+/**
+Returns the dot product of the doubles a[0, n) and b[0, n). Summed in 8 lanes without compensation, but in the same order on any CPU (see @ref a_sum_double).
+@param[in] a the first doubles
+@param[in] b the second doubles
+@param[in] n number of doubles
+@return the dot product
+@see da_dot, da_norm
+@private
+*/
+double a_dot_double(const double *a, const double *b, int n);
+
+/**
+Returns the sum of (a[i] - mean)^2 over a[0, n). Summed like @ref a_dot_double.
+@param[in] a the doubles
+@param[in] n number of doubles
+@param[in] mean value subtracted from each double
+@return the sum of the squared deviations from mean
+@see da_variance
+@private
+*/
+double a_squares_double(const double *a, int n, double mean);
+
+/**
+Returns the index of the first smallest double in a[0, n), or -1 if n is 0 or all doubles are NaN. NaNs are skipped. Vectorized like @ref a_min_index_int.
+@param[in] a the doubles
+@param[in] n number of doubles
+@return index or -1
+@see da_min_index
+@private
+*/
+int a_min_index_double(const double *a, int n);
+
+/**
+Returns the index of the first largest double in a[0, n), or -1 if n is 0 or all doubles are NaN. NaNs are skipped.
+@param[in] a the doubles
+@param[in] n number of doubles
+@return index or -1
+@see da_max_index
+@private
+*/
+int a_max_index_double(const double *a, int n);
+
+/**
+The comparisons of the builtin predicates (@ref ia_gt, @ref ia_ge, @ref ia_lt, @ref ia_le, @ref ia_even, @ref int_odd, and their da_ counterparts). ia_filter, da_filter, etc. recognize these predicates and use the kernels below instead of calling them for each element.
+@private
+*/
+typedef enum {
+    A_GT,   // element > x
+    A_GE,   // element >= x
+    A_LT,   // element < x
+    A_LE,   // element <= x
+    A_EVEN, // element is even, ints only
+    A_ODD   // element is odd, ints only
+} ACompare;
+
+/**
+Returns how many ints of a[0, n) satisfy the comparison with x. Vectorized like @ref a_index_int.
+@param[in] a the ints
+@param[in] n number of ints
+@param[in] op comparison
+@param[in] x value to compare with
+@return number of matching ints
+@see ia_filter
+@private
+*/
+int a_count_int(const int *a, int n, ACompare op, int x);
+
+/**
+Copies the first count ints of a that satisfy the comparison with x to out[0, count). Each int is copied without a branch, the index in out only advances if it matches.
+@param[in] a the ints, contains at least count matching ints
+@param[in] op comparison
+@param[in] x value to compare with
+@param[out] out room for count ints
+@param[in] count number of ints to copy, see @ref a_count_int
+@see ia_filter
+@private
+*/
+void a_select_int(const int *a, ACompare op, int x, int *out, int count);
+
+/**
+Sets out[i] = a[i] * x for i in [0, n). The products wrap around on overflow. Vectorized like @ref a_index_int. Out may be a.
+@param[in] a the ints
+@param[in] n number of ints
+@param[in] x factor
+@param[out] out room for n ints
+@see ia_map, ia_each
+@private
+*/
+void a_times_int(const int *a, int n, int x, int *out);
+
+/**
+Returns how many doubles of a[0, n) satisfy the comparison with x. A NaN satisfies none. Vectorized like @ref a_index_int.
+@param[in] a the doubles
+@param[in] n number of doubles
+@param[in] op comparison, not @c A_EVEN or @c A_ODD
+@param[in] x value to compare with
+@return number of matching doubles
+@see da_filter
+@private
+*/
+int a_count_double(const double *a, int n, ACompare op, double x);
+
+/**
+Copies the first count doubles of a that satisfy the comparison with x to out[0, count), like @ref a_select_int.
+@param[in] a the doubles, contains at least count matching doubles
+@param[in] op comparison, not @c A_EVEN or @c A_ODD
+@param[in] x value to compare with
+@param[out] out room for count doubles
+@param[in] count number of doubles to copy, see @ref a_count_double
+@see da_filter
+@private
+*/
+void a_select_double(const double *a, ACompare op, double x, double *out, int count);
+
+/**
+Sets out[i] = a[i] * x for i in [0, n). Vectorized like @ref a_index_int. Out may be a.
+@param[in] a the doubles
+@param[in] n number of doubles
+@param[in] x factor
+@param[out] out room for n doubles
+@see da_map, da_each
+@private
+*/
+void a_times_double(const double *a, int n, double x, double *out);
+
 /**
 Applies function f to each element of array. The original array is not modified.
 Function f is called once for each element from first to last.
@@ -4,9 +4,19 @@
 @copyright Apache License, Version 2.0
 */
 
+#define _DEFAULT_SOURCE // posix_memalign, madvise
 #include "base.h"
 #include "string.h"
 #include "list.h"
+#include <sched.h> // sched_yield
+#ifdef __linux__
+#include <sys/mman.h> // madvise
+#endif
+#if defined(__GLIBC__) || defined(__linux__) // glibc, musl, bionic
+#include <malloc.h> // malloc_usable_size
+#elif defined(__APPLE__)
+#include <malloc/malloc.h> // malloc_size
+#endif
 #undef free // use the 'real' free here
 #undef exit // use the 'real' exit here
 //#undef xmalloc
@@ -22,57 +32,32 @@
 // Mac OS X solution does not work on other platforms
 // so simply use preprocessor, does not catch things like strdup (stderr, or use macro for that as well)
 
-typedef struct BaseAllocInfo {
-    Any p;
-    size_t size;
-    const char *file;
-    const char *function;
-    int line;
-    struct BaseAllocInfo *next;
-} BaseAllocInfo;
+// Threads: state that belongs to a single thread (sampling countdown, random 
+// numbers, current arena) is thread-local. The index of tracked blocks is 
+// split into shards by address, the node pool into shards per thread, with a 
+// lock each. The map of regions is read without a lock. Counters are updated 
+// atomically. Settings like report_memory_leaks should be made before 
+// starting threads.
 
-BaseAllocInfo *base_alloc_info = NULL;
+typedef bool BaseLock;
 
-void base_free(Any p) {
-#if 0
-    // debug output
-    printf("base_free: Calling free on %p\n", p);
-    for (BaseAllocInfo *dp = base_alloc_info; dp != NULL; dp = dp->next) {
-        printf("%p\n", dp->p);
-    }
-#endif
-    bool removed = false;
-    BaseAllocInfo *ai = base_alloc_info;
-    if (ai != NULL) {
-        if (ai->p == p) { // remove first
-            BaseAllocInfo *del = ai;
-            base_alloc_info = ai->next;
-            free(del);
-            removed = true;
-        } else { // remove other than first
-            for (; ai != NULL; ai = ai->next) {
-                if (ai->next != NULL && ai->next->p == p) {
-                    BaseAllocInfo *del = ai->next;
-                    ai->next = ai->next->next;
-                    free(del);
-                    removed = true;
-                    break;
-                }
-            }
-        }
-    }
-    if (!removed) {
-        fprintf(stderr, "base_free: trying to free unknown pointer %p\n", p);
+static inline void base_lock(BaseLock *lock) {
+    while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+        sched_yield();
     }
+}
 
-    free(p);
+static inline void base_unlock(BaseLock *lock) {
+    __atomic_clear(lock, __ATOMIC_RELEASE);
 }
 
+#define BASE_INCREMENT(counter) __atomic_add_fetch(&(counter), 1, __ATOMIC_RELAXED)
+
 static int exit_status = EXIT_SUCCESS;
 
 void base_exit(int status) {
     // printsln("base_exit called");
-    exit_status = status;
+    __atomic_store_n(&exit_status, status, __ATOMIC_RELAXED);
     exit(status);
 }
 
@@ -82,9 +67,9 @@ void base_atexit(void);
 static bool do_memory_check = false;
 
 void base_init(void) {
-    if (!base_atexit_registered) {
+    if (!__atomic_load_n(&base_atexit_registered, __ATOMIC_ACQUIRE) 
+            && !__atomic_exchange_n(&base_atexit_registered, true, __ATOMIC_ACQ_REL)) {
         atexit(base_atexit);
-        base_atexit_registered = true;
     }
 }
 
@@ -93,85 +78,1357 @@ void report_memory_leaks(bool do_check) {
     do_memory_check = do_check;
 }
 
+static bool do_profile_allocations = false;
+static String profile_csv_file = NULL;
+
+void profile_allocations(bool do_profile, String csv_file) {
+    base_init();
+    do_profile_allocations = do_profile;
+    profile_csv_file = csv_file;
+}
+
+static long sample_interval = 0; // mean number of bytes between samples, 0 if not sampling
+static unsigned int base_sample_epoch = 0; // threads restart their countdown when this changes
+
+void sample_allocations(int mean_bytes) {
+    require("non-negative interval", mean_bytes >= 0);
+    base_init();
+    sample_interval = mean_bytes;
+    BASE_INCREMENT(base_sample_epoch);
+}
+
+// Aligned blocks (xmalloc_aligned, xcalloc_aligned) start at a cache line 
+// boundary. If huge pages are switched on, large aligned blocks from the 
+// system allocator start at a huge page boundary and the kernel is asked to 
+// back them with transparent huge pages.
+#define BASE_ALIGNMENT 64
+#define BASE_HUGE_PAGE_SIZE (2 << 20)
+#define BASE_HUGE_PAGE_MIN (4 << 20) // minimum block size for huge pages
+
+static bool base_use_huge_pages = false;
+
+void use_huge_pages(bool do_use) {
+    base_use_huge_pages = do_use;
+}
+
+static bool base_is_aligned(Any p) {
+    return ((size_t)p & (BASE_ALIGNMENT - 1)) == 0;
+}
+
+static void base_advise_huge_pages(Any p, size_t size) {
+#ifdef MADV_HUGEPAGE
+    if (base_use_huge_pages && size >= BASE_HUGE_PAGE_MIN) {
+        size_t page = 4096;
+        size_t start = ((size_t)p + page - 1) & ~(page - 1);
+        size_t end = ((size_t)p + size) & ~(page - 1);
+        if (start < end) madvise((void*)start, end - start, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+// Returns an aligned block from the system allocator or NULL.
+static Any base_system_malloc_aligned(size_t size) {
+    size_t alignment = base_use_huge_pages && size >= BASE_HUGE_PAGE_MIN ? BASE_HUGE_PAGE_SIZE : BASE_ALIGNMENT;
+    Any p = NULL;
+    if (posix_memalign(&p, alignment, size > 0 ? size : 1) != 0) return NULL;
+    base_advise_huge_pages(p, size);
+    return p;
+}
+
+// Returns the next number of a xorshift64* generator. Used for sampling and 
+// by i_rnd, d_rnd, and b_rnd. Each thread has its own state, which is seeded 
+// on first use.
+static unsigned long long base_random_next(unsigned long long *state) {
+    unsigned long long x = *state;
+    if (x == 0) {
+        x = ((unsigned long long)time(NULL) << 20) ^ (unsigned long long)(size_t)state;
+        if (x == 0) x = 1;
+    }
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Regions
+
+// A region is a range of memory from which the library cuts blocks itself, 
+// i.e., a chunk of an arena or a slab of the node pool. A region starts at a 
+// granule boundary and covers whole granules of 64 KB, which hold nothing 
+// else. A map from granules to the kind of region that covers them tells 
+// free and realloc whether a pointer lies in a region, without a lock and 
+// without reading the memory in front of the pointer. The map has two 
+// levels: one entry per 4 GB of address space, which points to a leaf with 
+// one entry per granule. Leaves are created on first use and never freed.
+// 
+// Regions of one granule, e.g., slabs, are cut from batches of 
+// BASE_REGION_BATCH granules, such that the system allocator is called once 
+// per batch. A batch is returned to the system once all its granules are 
+// free, unless it is the only batch with free granules. Larger regions come 
+// directly from the system allocator. The entry of a granule holds the kind 
+// of its region and, for a region of one granule, its batch. Allocating and 
+// freeing regions is guarded by a single lock, as it happens rarely.
+
+#define BASE_REGION_GRANULE_BITS 16
+#define BASE_REGION_GRANULE ((size_t)1 << BASE_REGION_GRANULE_BITS)
+#define BASE_REGION_LEAF_BITS 16 // granules per leaf
+#define BASE_REGION_LEAF_MASK (((size_t)1 << BASE_REGION_LEAF_BITS) - 1)
+#define BASE_REGION_ADDRESS_BITS 48
+#define BASE_REGION_LEAVES ((size_t)1 << (BASE_REGION_ADDRESS_BITS - BASE_REGION_GRANULE_BITS - BASE_REGION_LEAF_BITS))
+#define BASE_REGION_KIND_MASK ((size_t)3) // low bits of an entry, the others are the batch
+#define BASE_REGION_BATCH 16
+
+typedef enum { BASE_REGION_NONE, BASE_REGION_ARENA, BASE_REGION_SLAB } BaseRegionKind;
+
+typedef struct BaseRegionBatch BaseRegionBatch;
+struct BaseRegionBatch {
+    BaseRegionBatch *prev; // in the list of batches with free granules
+    BaseRegionBatch *next;
+    Byte *start; // first granule
+    Any free; // freed granules, linked through their first bytes
+    int fresh; // number of granules that have ever been handed out
+    int used; // number of granules in use
+};
+
+static size_t *base_region_map[BASE_REGION_LEAVES];
+static BaseRegionBatch *base_region_batches = NULL; // batches with free granules
+static BaseLock base_region_lock = false;
+
+// Returns true iff granules of [p, p + size) are covered by the map.
+static bool base_region_in_map(Any p, size_t size) {
+    return (((size_t)p + size - 1) >> BASE_REGION_GRANULE_BITS >> BASE_REGION_LEAF_BITS) < BASE_REGION_LEAVES;
+}
+
+// Sets the entries of the granules of [p, p + size). The caller holds base_region_lock.
+static void base_region_mark(Any p, size_t size, size_t entry) {
+    size_t first = (size_t)p >> BASE_REGION_GRANULE_BITS;
+    size_t last = ((size_t)p + size - 1) >> BASE_REGION_GRANULE_BITS;
+    for (size_t g = first; g <= last; g++) {
+        size_t *leaf = base_region_map[g >> BASE_REGION_LEAF_BITS];
+        if (leaf == NULL) {
+            leaf = calloc(BASE_REGION_LEAF_MASK + 1, sizeof(size_t));
+            if (leaf == NULL) {
+                fprintf(stderr, "base_region_mark: calloc returned NULL!\n");
+                base_exit(EXIT_FAILURE);
+            }
+            __atomic_store_n(&base_region_map[g >> BASE_REGION_LEAF_BITS], leaf, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&leaf[g & BASE_REGION_LEAF_MASK], entry, __ATOMIC_RELEASE);
+    }
+}
+
+// Returns the entry of the granule that contains p.
+static size_t base_region_entry(Any p) {
+    size_t g = (size_t)p >> BASE_REGION_GRANULE_BITS;
+    if ((g >> BASE_REGION_LEAF_BITS) >= BASE_REGION_LEAVES) return 0;
+    size_t *leaf = __atomic_load_n(&base_region_map[g >> BASE_REGION_LEAF_BITS], __ATOMIC_ACQUIRE);
+    return leaf == NULL ? 0 : __atomic_load_n(&leaf[g & BASE_REGION_LEAF_MASK], __ATOMIC_RELAXED);
+}
+
+// Returns the kind of region that contains p, BASE_REGION_NONE if p is not in a region.
+static BaseRegionKind base_region_kind(Any p) {
+    return (BaseRegionKind)(base_region_entry(p) & BASE_REGION_KIND_MASK);
+}
+
+static bool base_region_batch_has_free(BaseRegionBatch *b) {
+    return b->free != NULL || b->fresh < BASE_REGION_BATCH;
+}
+
+// Adds b to the list of batches with free granules. The caller holds base_region_lock.
+static void base_region_batch_link(BaseRegionBatch *b) {
+    b->prev = NULL;
+    b->next = base_region_batches;
+    if (base_region_batches != NULL) base_region_batches->prev = b;
+    base_region_batches = b;
+}
+
+// Removes b from the list of batches with free granules. The caller holds base_region_lock.
+static void base_region_batch_unlink(BaseRegionBatch *b) {
+    if (b->prev != NULL) b->prev->next = b->next; else base_region_batches = b->next;
+    if (b->next != NULL) b->next->prev = b->prev;
+    b->prev = NULL;
+    b->next = NULL;
+}
+
+// Returns a new batch or NULL.
+static BaseRegionBatch *base_region_batch_new(void) {
+    BaseRegionBatch *b = malloc(sizeof(BaseRegionBatch));
+    if (b == NULL) return NULL;
+    Any start = NULL;
+    if (posix_memalign(&start, BASE_REGION_GRANULE, BASE_REGION_BATCH * BASE_REGION_GRANULE) != 0) {
+        free(b);
+        return NULL;
+    }
+    b->start = start;
+    b->free = NULL;
+    b->fresh = 0;
+    b->used = 0;
+    return b;
+}
+
+// Allocates a region of size bytes, a multiple of BASE_REGION_GRANULE.
+static Any base_region_alloc(size_t size, BaseRegionKind kind) {
+    Any p = NULL;
+    BaseRegionBatch *b = NULL;
+    base_lock(&base_region_lock);
+    if (size == BASE_REGION_GRANULE) {
+        b = base_region_batches;
+        if (b == NULL && (b = base_region_batch_new()) != NULL) base_region_batch_link(b);
+        if (b != NULL) {
+            p = b->free;
+            if (p != NULL) {
+                b->free = *(Any*)p;
+            } else {
+                p = b->start + b->fresh++ * BASE_REGION_GRANULE;
+            }
+            b->used++;
+            if (!base_region_batch_has_free(b)) base_region_batch_unlink(b);
+        }
+    } else if (posix_memalign(&p, BASE_REGION_GRANULE, size) != 0) {
+        p = NULL;
+    }
+    if (p == NULL || !base_region_in_map(p, size)) {
+        fprintf(stderr, "base_region_alloc: posix_memalign(%lu) failed!\n", (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    base_region_mark(p, size, (size_t)b | kind);
+    base_unlock(&base_region_lock);
+    return p;
+}
+
+// Frees a region of size bytes.
+static void base_region_free(Any p, size_t size) {
+    BaseRegionBatch *release = NULL;
+    base_lock(&base_region_lock);
+    BaseRegionBatch *b = (BaseRegionBatch*)(base_region_entry(p) & ~BASE_REGION_KIND_MASK);
+    base_region_mark(p, size, 0);
+    if (b != NULL) {
+        bool had_free = base_region_batch_has_free(b);
+        *(Any*)p = b->free;
+        b->free = p;
+        b->used--;
+        if (!had_free) base_region_batch_link(b);
+        if (b->used == 0 && (b->prev != NULL || b->next != NULL)) {
+            base_region_batch_unlink(b);
+            release = b;
+        }
+    }
+    base_unlock(&base_region_lock);
+    if (b == NULL) free(p);
+    if (release != NULL) {
+        free(release->start);
+        free(release);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Arenas
+
+// An arena is a list of chunks. New blocks are cut from the first chunk, 
+// blocks larger than a quarter chunk get a chunk of their own. Each chunk is 
+// a region (see above), such that free can ignore the blocks of an arena, 
+// thus chunks are rounded up to whole granules. The last 16 bytes of a chunk 
+// are never handed out, such that even a block of 0 bytes lies within the 
+// chunk. Each block starts with a BaseArenaBlock header, from which realloc 
+// finds its arena.
+
+typedef struct BaseArenaChunk BaseArenaChunk;
+struct BaseArenaChunk {
+    BaseArenaChunk *next;
+    size_t size; // number of data bytes
+    size_t used; // number of data bytes in use
+};
+
+#define BASE_ARENA_CHUNK_HEADER_SIZE ((sizeof(BaseArenaChunk) + 15) & ~(size_t)15)
+#define BASE_ARENA_CHUNK_DATA(c) ((Byte*)(c) + BASE_ARENA_CHUNK_HEADER_SIZE)
+#define BASE_ARENA_CHUNK_BYTES(size) ((BASE_ARENA_CHUNK_HEADER_SIZE + (size) + 16 + BASE_REGION_GRANULE - 1) & ~(BASE_REGION_GRANULE - 1))
+
+struct ArenaHead {
+    BaseArenaChunk *chunks; // the first chunk is the current one
+    size_t chunk_size; // data bytes of a new chunk
+    size_t bytes; // bytes handed out since the last reset, including headers
+    struct ArenaHead *outer; // arena that was current before arena_enter
+    bool entered;
+};
+
+typedef struct {
+    Arena arena;
+    unsigned int size;
+} BaseArenaBlock;
+
+#define BASE_ARENA_HEADER_SIZE ((sizeof(BaseArenaBlock) + 15) & ~(size_t)15)
+#define BASE_ARENA_BLOCK(p) ((BaseArenaBlock*)((Byte*)(p) - BASE_ARENA_HEADER_SIZE))
+#define BASE_ARENA_ROUND(size) ((BASE_ARENA_HEADER_SIZE + (size) + 15) & ~(size_t)15)
+
+static __thread Arena base_current_arena = NULL; // each thread has its own current arena
+
+// Returns a chunk with at least size data bytes.
+static BaseArenaChunk *base_arena_chunk_new(size_t size, BaseArenaChunk *next) {
+    size_t bytes = BASE_ARENA_CHUNK_BYTES(size);
+    BaseArenaChunk *c = base_region_alloc(bytes, BASE_REGION_ARENA);
+    c->next = next;
+    c->size = bytes - BASE_ARENA_CHUNK_HEADER_SIZE - 16;
+    c->used = 0;
+    return c;
+}
+
+static void base_arena_chunk_free(BaseArenaChunk *c) {
+    base_region_free(c, BASE_ARENA_CHUNK_BYTES(c->size));
+}
+
+// Cuts a block from the arena. The data is aligned to alignment bytes (16 or BASE_ALIGNMENT).
+static Any base_arena_alloc(Arena arena, size_t size, size_t alignment) {
+    require("block smaller than 4 GB", size <= (unsigned int)-1);
+    size_t n = BASE_ARENA_ROUND(size) + alignment - 16; // including padding for alignment
+    BaseArenaChunk *c = arena->chunks;
+    if (c->used + n > c->size) {
+        if (n > arena->chunk_size / 4) {
+            // large block: own chunk behind the current one
+            c->next = base_arena_chunk_new(n, c->next);
+            c = c->next;
+        } else {
+            c = base_arena_chunk_new(arena->chunk_size, c);
+            arena->chunks = c;
+        }
+    }
+    Byte *start = BASE_ARENA_CHUNK_DATA(c) + c->used;
+    Byte *data = (Byte*)(((size_t)start + BASE_ARENA_HEADER_SIZE + alignment - 1) & ~(alignment - 1));
+    BaseArenaBlock *b = BASE_ARENA_BLOCK(data);
+    n = (Byte*)b - start + BASE_ARENA_ROUND(size);
+    c->used += n;
+    arena->bytes += n;
+    b->arena = arena;
+    b->size = size;
+    return (Byte*)b + BASE_ARENA_HEADER_SIZE;
+}
+
+// Resizes a block of the arena it was allocated in, which need not be the current one.
+static Any base_arena_realloc(Any p, size_t size) {
+    require("block smaller than 4 GB", size <= (unsigned int)-1);
+    BaseArenaBlock *b = BASE_ARENA_BLOCK(p);
+    Arena arena = b->arena;
+    BaseArenaChunk *c = arena->chunks;
+    size_t n_old = BASE_ARENA_ROUND(b->size);
+    size_t n_new = BASE_ARENA_ROUND(size);
+    if ((Byte*)b + n_old == BASE_ARENA_CHUNK_DATA(c) + c->used && c->used - n_old + n_new <= c->size) {
+        // last block of the current chunk: grow or shrink in place
+        c->used = c->used - n_old + n_new;
+        arena->bytes = arena->bytes - n_old + n_new;
+        b->size = size;
+        return p;
+    }
+    if (size <= b->size) {
+        b->size = size;
+        return p;
+    }
+    Any q = base_arena_alloc(arena, size, base_is_aligned(p) ? BASE_ALIGNMENT : 16);
+    memcpy(q, p, b->size);
+    return q;
+}
+
+Arena arena_create(int chunk_size) {
+    require("positive chunk size", chunk_size > 0);
+    // the arena itself lives on the heap, even if created inside another arena
+    Arena outer = base_current_arena;
+    base_current_arena = NULL;
+    Arena arena = xmalloc(sizeof(struct ArenaHead));
+    base_current_arena = outer;
+    arena->chunk_size = chunk_size;
+    arena->chunks = base_arena_chunk_new(arena->chunk_size, NULL);
+    arena->bytes = 0;
+    arena->outer = NULL;
+    arena->entered = false;
+    return arena;
+}
+
+void arena_reset(Arena arena) {
+    require_not_null(arena);
+    BaseArenaChunk *first = arena->chunks;
+    if (first->next == NULL) {
+        first->used = 0;
+    } else {
+        // replace all chunks by one that holds what was allocated since the last reset
+        size_t size = arena->bytes > first->size ? arena->bytes : first->size;
+        for (BaseArenaChunk *c = first, *next; c != NULL; c = next) {
+            next = c->next;
+            base_arena_chunk_free(c);
+        }
+        arena->chunks = base_arena_chunk_new(size, NULL);
+    }
+    arena->bytes = 0;
+}
+
+void arena_free(Arena arena) {
+    if (arena == NULL) return;
+    require("arena not entered", !arena->entered);
+    for (BaseArenaChunk *c = arena->chunks, *next; c != NULL; c = next) {
+        next = c->next;
+        base_arena_chunk_free(c);
+    }
+    base_free(arena);
+}
+
+void arena_enter(Arena arena) {
+    require_not_null(arena);
+    require("arena not entered", !arena->entered);
+    arena->outer = base_current_arena;
+    arena->entered = true;
+    base_current_arena = arena;
+}
+
+void arena_leave(void) {
+    require("inside an arena", base_current_arena != NULL);
+    Arena arena = base_current_arena;
+    base_current_arena = arena->outer;
+    arena->outer = NULL;
+    arena->entered = false;
+}
+
+Arena arena_current(void) {
+    return base_current_arena;
+}
+
+size_t arena_bytes(Arena arena) {
+    require_not_null(arena);
+    return arena->bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Footprint
+
+// Returns the number of bytes the system allocator uses for block p, 
+// including its own chunk header. If the allocator cannot tell, returns 
+// size, the number of bytes requested for p (0 if unknown).
+static size_t base_system_bytes(Any p, size_t size) {
+#if defined(__GLIBC__) || defined(__linux__)
+    (void)size;
+    return malloc_usable_size(p) + sizeof(size_t);
+#elif defined(__APPLE__)
+    (void)size;
+    return malloc_size(p);
+#else
+    (void)p;
+    return size;
+#endif
+}
+
+// Splits the total number of bytes of a block into its parts.
+static Footprint base_footprint(size_t total, size_t tracker, size_t payload) {
+    Footprint f = { payload, 0, tracker };
+    if (total > tracker + payload) f.structure = total - tracker - payload;
+    return f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Node pool
+
+// Blocks of up to BASE_POOL_MAX bytes for list nodes are cut from slabs of 
+// BASE_POOL_SLAB bytes, with one size class per multiple of 8 bytes. With 
+// memory tracking, a block holds the allocation header in front of the node. 
+// Each slab is a region of one granule, so free recognises pooled blocks by 
+// their address and finds their slab at the start of the granule. The slabs with free blocks of a size class 
+// are kept in shards with a lock each. A thread allocates from the shard it 
+// was assigned at its first allocation, so threads rarely contend for a lock. 
+// A slab whose blocks are all free is returned to the system, unless it is 
+// the only slab of its shard with free blocks.
+
+#define BASE_POOL_MAX 128
+#define BASE_POOL_CLASSES (BASE_POOL_MAX / 8)
+#define BASE_POOL_SLAB BASE_REGION_GRANULE
+#define BASE_POOL_SHARDS 16
+
+typedef struct BasePoolShard BasePoolShard;
+typedef struct BasePoolSlab BasePoolSlab;
+
+struct BasePoolSlab {
+    BasePoolShard *shard;
+    BasePoolSlab *prev; // in the list of slabs with free blocks of the shard
+    BasePoolSlab *next;
+    Any free; // freed blocks, linked through their first bytes
+    Byte *fresh; // first block that has never been handed out
+    Byte *end;
+    int block_size;
+    int live; // number of blocks handed out and not freed
+};
+
+#define BASE_POOL_SLAB_HEADER_SIZE ((sizeof(BasePoolSlab) + 15) & ~(size_t)15)
+#define BASE_POOL_SLAB_OF(p) ((BasePoolSlab*)((size_t)(p) & ~(BASE_POOL_SLAB - 1)))
+
+struct BasePoolShard {
+    BasePoolSlab *slabs; // slabs with free blocks
+    BaseLock lock;
+    Byte padding[64 - sizeof(BasePoolSlab*) - sizeof(BaseLock)];
+};
+
+static BasePoolShard base_pool_shards[BASE_POOL_CLASSES][BASE_POOL_SHARDS] __attribute__((aligned(64)));
+static int base_pool_threads = 0; // number of threads that have been assigned a shard
+static __thread int base_pool_shard = -1; // shard of this thread
+static size_t base_pool_slab_bytes = 0; // bytes in slabs
+
+static bool base_pool_slab_has_free(BasePoolSlab *s) {
+    return s->free != NULL || s->fresh + s->block_size <= s->end;
+}
+
+// Adds s to the list of slabs with free blocks. The caller holds the lock of the shard.
+static void base_pool_slab_link(BasePoolSlab *s) {
+    BasePoolShard *shard = s->shard;
+    s->prev = NULL;
+    s->next = shard->slabs;
+    if (shard->slabs != NULL) shard->slabs->prev = s;
+    shard->slabs = s;
+}
+
+// Removes s from the list of slabs with free blocks. The caller holds the lock of the shard.
+static void base_pool_slab_unlink(BasePoolSlab *s) {
+    if (s->prev != NULL) s->prev->next = s->next; else s->shard->slabs = s->next;
+    if (s->next != NULL) s->next->prev = s->prev;
+    s->prev = NULL;
+    s->next = NULL;
+}
+
+static BasePoolSlab *base_pool_slab_new(BasePoolShard *shard, int block_size) {
+    BasePoolSlab *s = base_region_alloc(BASE_POOL_SLAB, BASE_REGION_SLAB);
+    s->shard = shard;
+    s->free = NULL;
+    s->fresh = (Byte*)s + BASE_POOL_SLAB_HEADER_SIZE;
+    s->end = (Byte*)s + BASE_POOL_SLAB;
+    s->block_size = block_size;
+    s->live = 0;
+    __atomic_add_fetch(&base_pool_slab_bytes, BASE_POOL_SLAB, __ATOMIC_RELAXED);
+    return s;
+}
+
+static void base_pool_slab_free(BasePoolSlab *s) {
+    __atomic_sub_fetch(&base_pool_slab_bytes, BASE_POOL_SLAB, __ATOMIC_RELAXED);
+    base_region_free(s, BASE_POOL_SLAB);
+}
+
+// Allocates a zero-initialized block of 1 to BASE_POOL_MAX bytes.
+static Any base_pool_alloc(size_t size) {
+    if (base_pool_shard < 0) {
+        base_pool_shard = __atomic_fetch_add(&base_pool_threads, 1, __ATOMIC_RELAXED) % BASE_POOL_SHARDS;
+    }
+    int c = (int)(size + 7) / 8 - 1;
+    BasePoolShard *shard = &base_pool_shards[c][base_pool_shard];
+    base_lock(&shard->lock);
+    BasePoolSlab *s = shard->slabs;
+    if (s == NULL) {
+        s = base_pool_slab_new(shard, 8 * (c + 1));
+        base_pool_slab_link(s);
+    }
+    Any p = s->free;
+    if (p != NULL) {
+        s->free = *(Any*)p;
+    } else {
+        p = s->fresh;
+        s->fresh += s->block_size;
+    }
+    s->live++;
+    if (!base_pool_slab_has_free(s)) base_pool_slab_unlink(s);
+    base_unlock(&shard->lock);
+    memset(p, 0, size);
+    return p;
+}
+
+// Returns the n blocks from first to last, which are linked through their 
+// first bytes, to their slab s.
+static void base_pool_free_blocks(BasePoolSlab *s, Any first, Any last, int n) {
+    BasePoolShard *shard = s->shard;
+    bool release = false;
+    base_lock(&shard->lock);
+    bool had_free = base_pool_slab_has_free(s);
+    *(Any*)last = s->free;
+    s->free = first;
+    s->live -= n;
+    if (!had_free) base_pool_slab_link(s);
+    if (s->live == 0 && (s->prev != NULL || s->next != NULL)) {
+        base_pool_slab_unlink(s);
+        release = true;
+    }
+    base_unlock(&shard->lock);
+    if (release) base_pool_slab_free(s);
+}
+
+#ifdef NO_MEMORY_TRACKING
+
+// Release variant (libprog1_release.a): no fill, no allocation info, 
+// blocks come straight from the system allocator, except for list nodes.
+
+// Reallocates a block of the system allocator. Keeps aligned blocks aligned. 
+// Returns NULL on failure. Never frees the block, even if size is 0.
+static Any base_system_realloc(Any ptr, size_t size) {
+    bool aligned = ptr != NULL && base_is_aligned(ptr);
+    if (size == 0) size = 1;
+    Any p = realloc(ptr, size);
+    if (p != NULL && aligned && !base_is_aligned(p)) {
+        Any q = base_system_malloc_aligned(size);
+        if (q != NULL) memcpy(q, p, size);
+        free(p);
+        p = q;
+    }
+    return p;
+}
+
+// Returns the slot of p if p is a block of the node pool, else NULL.
+static Any base_pool_slot(Any p) {
+    return base_region_kind(p) == BASE_REGION_SLAB ? p : NULL;
+}
+
+Any base_node_calloc(const char *file, const char *function, int line, size_t size) {
+    if (size == 0 || size > BASE_POOL_MAX || base_current_arena != NULL) {
+        return base_calloc(file, function, line, 1, size);
+    }
+    return base_pool_alloc(size);
+}
+
 Any base_malloc(const char *file, const char *function, int line, size_t size) {
-    // allocate four bytes more than requested and fill with garbage, 
-    // such that non-terminated strings will produce an unexpected result
-    Any p = malloc(size + 4);
+    if (base_current_arena != NULL) return base_arena_alloc(base_current_arena, size, 16);
+    Any p = malloc(size);
     if (p == NULL) {
         fprintf(stderr, "%s, line %d: malloc(%lu) called in base_malloc returned NULL!\n", 
                 file, line, (unsigned long)size);
         base_exit(EXIT_FAILURE);
     }
-    // printf("%s, line %d: malloc(%lu) returned %lx\n", file, line, (unsigned long)size, (unsigned long)p);
+    return p;
+}
 
-    // fill with garbage
-    memset(p, '?', size + 3);
-    ((char*)p)[size + 3] = '\0';
+Any base_realloc(const char *file, const char *function, int line, Any ptr, size_t size) {
+    if (ptr == NULL && base_current_arena != NULL) return base_arena_alloc(base_current_arena, size, 16);
+    BaseRegionKind kind = ptr != NULL ? base_region_kind(ptr) : BASE_REGION_NONE;
+    if (kind == BASE_REGION_ARENA) return base_arena_realloc(ptr, size);
+    if (kind == BASE_REGION_SLAB) {
+        // move out of the pool
+        BasePoolSlab *s = BASE_POOL_SLAB_OF(ptr);
+        Any p = base_malloc(file, function, line, size);
+        memcpy(p, ptr, (size_t)s->block_size < size ? (size_t)s->block_size : size);
+        base_pool_free_blocks(s, ptr, ptr, 1);
+        return p;
+    }
+    Any p = base_system_realloc(ptr, size);
+    if (p == NULL) {
+        fprintf(stderr, "%s, line %d: malloc(%lu) called in base_realloc returned NULL!\n",
+                file, line, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    return p;
+}
 
-    BaseAllocInfo *ai = malloc(sizeof(BaseAllocInfo));
-    if (ai == NULL) {
-        fprintf(stderr, "%s, line %d: malloc(sizeof(BaseAllocInfo)) called in base_malloc returned NULL!\n", 
+Any base_calloc(const char *file, const char *function, int line, size_t num, size_t size) {
+    if (base_current_arena != NULL && (size == 0 || num <= (size_t)-1 / size)) {
+        Any p = base_arena_alloc(base_current_arena, num * size, 16);
+        memset(p, 0, num * size);
+        return p;
+    }
+    Any p = calloc(num, size);
+    if (p == NULL) {
+        fprintf(stderr, "%s, line %d: calloc(%lu, %lu) called in base_calloc returned NULL!\n", 
+                file, line, (unsigned long)num, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+Any base_malloc_aligned(const char *file, const char *function, int line, size_t size) {
+    if (base_current_arena != NULL) return base_arena_alloc(base_current_arena, size, BASE_ALIGNMENT);
+    Any p = base_system_malloc_aligned(size);
+    if (p == NULL) {
+        fprintf(stderr, "%s, line %d: posix_memalign(%lu) called in base_malloc_aligned failed!\n", 
+                file, line, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+Any base_calloc_aligned(const char *file, const char *function, int line, size_t num, size_t size) {
+    if (size != 0 && num > (size_t)-1 / size) {
+        fprintf(stderr, "%s, line %d: base_calloc_aligned(%lu, %lu) is too large!\n", 
+                file, line, (unsigned long)num, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    Any p = base_malloc_aligned(file, function, line, num * size);
+    memset(p, 0, num * size);
+    return p;
+}
+
+void base_free(Any p) {
+    if (p == NULL) return;
+    BaseRegionKind kind = base_region_kind(p);
+    if (kind == BASE_REGION_NONE) {
+        free(p);
+    } else if (kind == BASE_REGION_SLAB) {
+        base_pool_free_blocks(BASE_POOL_SLAB_OF(p), p, p, 1);
+    } // blocks of an arena are released with their arena
+}
+
+static void base_check_memory(void) {
+    // no allocation info in the release variant
+}
+
+void print_allocation_profile(void) {
+    fprintf(stderr, "print_allocation_profile: no allocation profile in release variant\n");
+}
+
+void print_heap_sample(void) {
+    fprintf(stderr, "print_heap_sample: no heap sample in release variant\n");
+}
+
+Footprint memory_footprint(Any p, size_t payload) {
+    if (p == NULL) return base_footprint(0, 0, 0);
+    BaseRegionKind kind = base_region_kind(p);
+    if (kind == BASE_REGION_ARENA) {
+        return base_footprint(BASE_ARENA_ROUND(BASE_ARENA_BLOCK(p)->size), 0, payload);
+    }
+    if (kind == BASE_REGION_SLAB) {
+        return base_footprint(BASE_POOL_SLAB_OF(p)->block_size, 0, payload);
+    }
+    return base_footprint(base_system_bytes(p, 0), 0, payload);
+}
+
+void print_memory_footprint(void) {
+    fprintf(stderr, "print_memory_footprint: no allocation info in release variant\n");
+    fprintf(stderr, "List node pool: %zu bytes in slabs\n", base_node_pool_bytes());
+}
+
+static void base_report_heap_sample(void) {
+    // no sampling in the release variant
+}
+
+static void base_write_allocation_profile_csv(String name) {
+    // no allocation profile in the release variant
+}
+
+#else
+
+static bool base_is_arena_block(Any p) {
+    return base_region_kind(p) == BASE_REGION_ARENA;
+}
+
+/*
+Allocation call sites. Every xmalloc, xcalloc, and xrealloc call site 
+(file, function, line) is represented by a single BaseAllocSite record. 
+The records live in an open-addressing hash table and are never freed. 
+The table is shared by all threads and guarded by base_alloc_sites_lock, 
+each thread caches the records it has looked up. The statistics are only 
+updated if allocation profiling is switched on, atomically.
+*/
+
+// lifetime histogram buckets: < 10, < 100, ..., < 1000000, >= 1000000 allocations
+#define BASE_LIFETIME_BUCKETS 7
+
+typedef struct BaseAllocSite {
+    const char *file;
+    const char *function;
+    int line;
+    unsigned long count; // number of allocations
+    unsigned long bytes; // total number of bytes allocated
+    size_t live_bytes; // number of bytes currently allocated
+    size_t peak_live_bytes; // maximum of live_bytes
+    unsigned long lifetimes[BASE_LIFETIME_BUCKETS]; // histogram of block lifetimes
+    long sample_blocks; // number of live sampled blocks, computed by base_print_heap_sample
+    double sample_bytes; // estimated number of live bytes, computed by base_print_heap_sample
+} BaseAllocSite;
+
+static BaseAllocSite **base_alloc_sites = NULL;
+static size_t base_alloc_sites_capacity = 0; // always a power of two
+static size_t base_alloc_sites_count = 0;
+static BaseLock base_alloc_sites_lock = false;
+
+// per-thread cache of call site records, direct-mapped
+#define BASE_SITE_CACHE_SIZE 64
+typedef struct {
+    const char *file;
+    const char *function;
+    int line;
+    BaseAllocSite *site;
+} BaseSiteCacheEntry;
+static __thread BaseSiteCacheEntry base_site_cache[BASE_SITE_CACHE_SIZE];
+
+// allocation clock, lifetimes are measured in number of allocations (modulo 2^32)
+static unsigned int base_alloc_tick = 0;
+
+static size_t base_alloc_site_hash(const char *file, int line) {
+    size_t h = ((size_t)file >> 3) ^ ((size_t)line * 0x9E3779B1u);
+    h *= (size_t)0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+static void base_alloc_sites_grow(void) {
+    BaseAllocSite **old = base_alloc_sites;
+    size_t old_capacity = base_alloc_sites_capacity;
+    size_t capacity = old_capacity == 0 ? 256 : 2 * old_capacity;
+    BaseAllocSite **sites = calloc(capacity, sizeof(BaseAllocSite*));
+    if (sites == NULL) {
+        fprintf(stderr, "calloc(%lu, sizeof(BaseAllocSite*)) called in base_alloc_sites_grow returned NULL!\n", 
+                (unsigned long)capacity);
+        base_exit(EXIT_FAILURE);
+    }
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < old_capacity; i++) {
+        BaseAllocSite *site = old[i];
+        if (site != NULL) {
+            size_t j = base_alloc_site_hash(site->file, site->line) & mask;
+            while (sites[j] != NULL) j = (j + 1) & mask;
+            sites[j] = site;
+        }
+    }
+    base_alloc_sites = sites;
+    base_alloc_sites_capacity = capacity;
+    free(old);
+}
+
+// Returns the record for the given call site. Creates it if necessary. 
+// The caller holds base_alloc_sites_lock.
+static BaseAllocSite *base_alloc_site_locked(const char *file, const char *function, int line) {
+    if (2 * (base_alloc_sites_count + 1) > base_alloc_sites_capacity) { // load factor <= 0.5
+        base_alloc_sites_grow();
+    }
+    size_t mask = base_alloc_sites_capacity - 1;
+    size_t i = base_alloc_site_hash(file, line) & mask;
+    for (BaseAllocSite *site; (site = base_alloc_sites[i]) != NULL; i = (i + 1) & mask) {
+        if (site->file == file && site->line == line && site->function == function) {
+            return site;
+        }
+    }
+    BaseAllocSite *site = calloc(1, sizeof(BaseAllocSite));
+    if (site == NULL) {
+        fprintf(stderr, "%s, line %d: calloc(1, sizeof(BaseAllocSite)) called in base_alloc_site returned NULL!\n", 
                 file, line);
         base_exit(EXIT_FAILURE);
     }
-    ai->p = p;
+    site->file = file;
+    site->function = function;
+    site->line = line;
+    base_alloc_sites[i] = site;
+    base_alloc_sites_count++;
+    return site;
+}
+
+// Returns the record for the given call site. Creates it if necessary.
+static BaseAllocSite *base_alloc_site(const char *file, const char *function, int line) {
+    BaseSiteCacheEntry *e = &base_site_cache[base_alloc_site_hash(file, line) & (BASE_SITE_CACHE_SIZE - 1)];
+    if (e->file != file || e->line != line || e->function != function) {
+        base_lock(&base_alloc_sites_lock);
+        e->site = base_alloc_site_locked(file, function, line);
+        base_unlock(&base_alloc_sites_lock);
+        e->file = file;
+        e->function = function;
+        e->line = line;
+    }
+    return e->site;
+}
+
+// Each block is preceded by a BaseAllocInfo header in the same 
+// malloc'd block, so allocation info costs no extra malloc call:
+// [BaseAllocInfo ... padding][user data ...]
+// ^ malloc'd                 ^ returned by base_malloc
+// The last word of the header is a key derived from the address of the 
+// data, from which free, realloc, and memory_footprint tell without a lock 
+// whether a pointer is a tracked block. Only the word directly in front of 
+// the pointer is read, as the system allocator does when it frees a block. 
+// The key is cleared when the block is freed or moved, such that a double 
+// free is detected and a stale copy does not match. All tracked blocks are 
+// also entered into an index (see below), from which leaks are reported. In 
+// sampling mode only sampled blocks are tracked, the others are plain 
+// blocks with a plain header (see below).
+typedef struct BaseAllocInfo {
+    struct BaseAllocInfo *next; // next block in the same bucket of the index
+    size_t size;
+    BaseAllocSite *site; // call site of xmalloc, xcalloc, or xrealloc
+    unsigned int birth; // allocation clock at allocation time, 0 if not profiled
+    unsigned char offset; // number of bytes between the malloc'd address and the header
+    bool aligned; // data is aligned to BASE_ALIGNMENT (xmalloc_aligned, xcalloc_aligned)
+    bool pooled; // block of the node pool (base_node_calloc)
+    unsigned int samples; // number of sample points within the block (sampling mode)
+} BaseAllocInfo;
+
+// header size including the key, rounded up, such that user data stays 16-byte aligned
+#define BASE_ALLOC_HEADER_SIZE ((sizeof(BaseAllocInfo) + sizeof(size_t) + 15) & ~(size_t)15)
+
+#define BASE_ALLOC_INFO(p) ((BaseAllocInfo*)((Byte*)(p) - BASE_ALLOC_HEADER_SIZE))
+#define BASE_ALLOC_DATA(ai) ((Any)((Byte*)(ai) + BASE_ALLOC_HEADER_SIZE))
+#define BASE_KEY(p) (((size_t*)(p))[-1])
+#define BASE_TRACKED_KEY ((size_t)0x7a3c9e17b2d4f681ULL)
+
+// For a block of another allocator, the key is part of the chunk header of 
+// that allocator, which address sanitizers would report.
+#ifdef __GNUC__
+#define BASE_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define BASE_NO_SANITIZE_ADDRESS
+#endif
+
+// The index of tracked blocks is a hash table from the address of the user 
+// data to the header, split into shards with a lock each. It is only used to 
+// enumerate the blocks and to remove a block when it is freed. The shard and the 
+// bucket are chosen by the address: the shard by bits 16 to 19, such that 
+// threads that allocate and free different blocks rarely contend for a lock, 
+// the bucket by the other bits above bit 6, such that blocks that are close 
+// in memory are close in the index. A tracked block with its header takes at 
+// least 56 bytes, so the bits below bit 6 would leave buckets unused when the 
+// blocks are pooled at a stride of 64 bytes. One shard per cache line.
+#define BASE_SHARDS 16
+#define BASE_SHARD_MIN_BUCKETS 1024
+
+typedef struct {
+    BaseAllocInfo **buckets; // chains of blocks, linked through next
+    size_t capacity; // number of buckets, 0 or a power of 2
+    size_t count; // number of blocks
+    BaseLock lock;
+    Byte padding[64 - sizeof(BaseAllocInfo**) - 2 * sizeof(size_t) - sizeof(BaseLock)];
+} BaseAllocShard;
+
+static BaseAllocShard base_alloc_shards[BASE_SHARDS] __attribute__((aligned(64)));
+
+static BaseAllocShard *base_alloc_shard(Any p) {
+    return &base_alloc_shards[((size_t)p >> 16) % BASE_SHARDS];
+}
+
+static size_t base_alloc_bucket(Any p, size_t capacity) {
+    size_t key = (size_t)p >> 6;
+    return ((key & 0x3ff) | ((key >> 4) & ~(size_t)0x3ff)) & (capacity - 1);
+}
+
+// Doubles the number of buckets of the shard. The caller holds its lock.
+static void base_alloc_shard_grow(BaseAllocShard *shard) {
+    size_t capacity = shard->capacity == 0 ? BASE_SHARD_MIN_BUCKETS : 2 * shard->capacity;
+    BaseAllocInfo **buckets = calloc(capacity, sizeof(BaseAllocInfo*));
+    if (buckets == NULL) {
+        fprintf(stderr, "base_alloc_shard_grow: calloc(%lu) returned NULL!\n", (unsigned long)capacity);
+        base_exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < shard->capacity; i++) {
+        for (BaseAllocInfo *ai = shard->buckets[i], *next; ai != NULL; ai = next) {
+            next = ai->next;
+            size_t b = base_alloc_bucket(BASE_ALLOC_DATA(ai), capacity);
+            ai->next = buckets[b];
+            buckets[b] = ai;
+        }
+    }
+    free(shard->buckets);
+    shard->buckets = buckets;
+    shard->capacity = capacity;
+}
+
+// Enters the block into the index and sets its key.
+static void base_alloc_info_link(BaseAllocInfo *ai) {
+    Any p = BASE_ALLOC_DATA(ai);
+    BaseAllocShard *shard = base_alloc_shard(p);
+    base_lock(&shard->lock);
+    if (shard->count >= shard->capacity) base_alloc_shard_grow(shard);
+    size_t b = base_alloc_bucket(p, shard->capacity);
+    ai->next = shard->buckets[b];
+    shard->buckets[b] = ai;
+    shard->count++;
+    base_unlock(&shard->lock);
+    BASE_KEY(p) = (size_t)p ^ BASE_TRACKED_KEY;
+}
+
+// Clears the key of the block and removes it from the index.
+static void base_alloc_info_unlink(BaseAllocInfo *ai) {
+    Any p = BASE_ALLOC_DATA(ai);
+    BaseAllocShard *shard = base_alloc_shard(p);
+    BASE_KEY(p) = 0;
+    base_lock(&shard->lock);
+    BaseAllocInfo **link = &shard->buckets[base_alloc_bucket(p, shard->capacity)];
+    while (*link != ai) {
+        link = &(*link)->next;
+    }
+    *link = ai->next;
+    shard->count--;
+    base_unlock(&shard->lock);
+}
+
+// Returns the header of p if p is a tracked block, else NULL.
+BASE_NO_SANITIZE_ADDRESS
+static BaseAllocInfo *base_alloc_info_of(Any p) {
+    return BASE_KEY(p) == ((size_t)p ^ BASE_TRACKED_KEY) ? BASE_ALLOC_INFO(p) : NULL;
+}
+
+static void base_alloc_info_init(BaseAllocInfo *ai, size_t size, 
+        const char *file, const char *function, int line) 
+{
+    BaseAllocSite *site = base_alloc_site(file, function, line);
     ai->size = size;
-    ai->file = file;
-    ai->function = function;
-    ai->line = line;
-    ai->next = base_alloc_info;
-    base_alloc_info = ai;
+    ai->site = site;
+    ai->birth = 0;
+    ai->samples = 0;
+    if (do_profile_allocations) {
+        unsigned int tick = BASE_INCREMENT(base_alloc_tick);
+        ai->birth = tick != 0 ? tick : 1;
+        BASE_INCREMENT(site->count);
+        __atomic_add_fetch(&site->bytes, size, __ATOMIC_RELAXED);
+        size_t live = __atomic_add_fetch(&site->live_bytes, size, __ATOMIC_RELAXED);
+        size_t peak = __atomic_load_n(&site->peak_live_bytes, __ATOMIC_RELAXED);
+        while (live > peak && !__atomic_compare_exchange_n(&site->peak_live_bytes, &peak, live, 
+                true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            // peak has been reloaded, retry
+        }
+    }
+}
+
+// Records the end of the lifetime of a block.
+static void base_alloc_info_release(BaseAllocInfo *ai) {
+    if (ai->birth != 0) {
+        BaseAllocSite *site = ai->site;
+        unsigned int lifetime = __atomic_load_n(&base_alloc_tick, __ATOMIC_RELAXED) - ai->birth;
+        int bucket = 0;
+        for (unsigned long limit = 10; bucket < BASE_LIFETIME_BUCKETS - 1 && lifetime >= limit; limit *= 10) {
+            bucket++;
+        }
+        BASE_INCREMENT(site->lifetimes[bucket]);
+        __atomic_sub_fetch(&site->live_bytes, ai->size, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+Sampling mode. The sample points form a Poisson process over the stream of 
+allocated bytes with a mean distance of sample_interval bytes. A block that 
+contains k sample points stands for k * sample_interval bytes, which is an 
+unbiased estimate of its size. Only blocks with at least one sample point are 
+tracked, so the cost of tracking is bounded by the sampling rate.
+*/
+
+// per-thread sampling state
+static __thread long long base_sample_countdown = 0; // number of bytes until the next sample point
+static __thread unsigned long long base_sample_state = 0; // random number generator state
+static __thread unsigned int base_sample_thread_epoch = 0; // base_sample_epoch at the last reset
+
+// Returns a uniformly distributed random number in (0, 1].
+static double base_sample_uniform(void) {
+    return ((base_random_next(&base_sample_state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// Natural logarithm for x in (0, 1]. Avoids a dependency on the math library.
+static double base_sample_log(double x) {
+    union { double d; unsigned long long u; } v = { x };
+    int e = (int)((v.u >> 52) & 0x7ff) - 1023;
+    v.u = (v.u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL; // mantissa m in [1, 2)
+    double t = (v.d - 1) / (v.d + 1); // ln(m) = 2 * atanh(t), |t| < 1/3
+    double t2 = t * t;
+    return e * 0.6931471805599453 + 2 * t * (1 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 / 9))));
+}
+
+// Returns an exponentially distributed distance to the next sample point.
+static long long base_sample_distance(void) {
+    return (long long)(-base_sample_log(base_sample_uniform()) * sample_interval) + 1;
+}
+
+// Restarts the countdown of this thread after sample_allocations was called.
+static void base_sample_reset(void) {
+    base_sample_thread_epoch = __atomic_load_n(&base_sample_epoch, __ATOMIC_RELAXED);
+    base_sample_countdown = base_sample_distance();
+}
+
+// Returns the number of sample points that fall into a new block. The caller 
+// has already subtracted the block size from base_sample_countdown.
+static unsigned int base_sample_points(void) {
+    unsigned int k = 0;
+    while (base_sample_countdown <= 0) {
+        k++;
+        base_sample_countdown += base_sample_distance();
+    }
+    return k;
+}
+
+/*
+In sampling mode, blocks without sample point are not tracked. They get a 
+plain header of two words, the size and a key, which tells free and realloc 
+that the block came from here: 
+[size key][user data ...]
+Aligned blocks have BASE_ALIGNMENT bytes in front of the data, the others 16 
+bytes.
+*/
+#define BASE_PLAIN_SIZE(p) (((size_t*)(p))[-2])
+#define BASE_PLAIN_KEY ((size_t)0x2f5b8d61c94e7a13ULL)
+#define BASE_PLAIN_ALIGNED_KEY ((size_t)0xc94e7a132f5b8d61ULL)
+
+// Allocates a block with a plain header. Returns NULL if the system allocator fails.
+static Any base_plain_alloc(size_t size, bool clear, bool aligned) {
+    size_t offset = aligned ? BASE_ALIGNMENT : 16;
+    Byte *raw;
+    if (aligned) {
+        raw = base_system_malloc_aligned(offset + size);
+        if (raw != NULL && clear) memset(raw + offset, 0, size);
+    } else {
+        raw = clear ? calloc(1, offset + size) : malloc(offset + size);
+    }
+    if (raw == NULL) return NULL;
+    Byte *p = raw + offset;
+    BASE_PLAIN_SIZE(p) = size;
+    BASE_KEY(p) = (size_t)p ^ (aligned ? BASE_PLAIN_ALIGNED_KEY : BASE_PLAIN_KEY);
+    return p;
+}
+
+// Returns the number of bytes in front of p if p is a block with a plain header, else 0.
+BASE_NO_SANITIZE_ADDRESS
+static size_t base_plain_offset(Any p) {
+    size_t key = BASE_KEY(p) ^ (size_t)p;
+    return key == BASE_PLAIN_KEY ? 16 : key == BASE_PLAIN_ALIGNED_KEY ? BASE_ALIGNMENT : 0;
+}
 
+// Resizes a block with a plain header, which keeps a plain header. Returns 
+// NULL if the system allocator fails.
+static Any base_plain_realloc(Any ptr, size_t size) {
+    size_t offset = base_plain_offset(ptr);
+    size_t old_size = BASE_PLAIN_SIZE(ptr);
+    if (offset == BASE_ALIGNMENT) {
+        // realloc would not keep the alignment: move into a new aligned block
+        Any p = base_plain_alloc(size, false, true);
+        if (p == NULL) return NULL;
+        memcpy(p, ptr, old_size < size ? old_size : size);
+        BASE_KEY(ptr) = 0;
+        free((Byte*)ptr - offset);
+        return p;
+    }
+    BASE_KEY(ptr) = 0;
+    Byte *raw = realloc((Byte*)ptr - offset, offset + size);
+    if (raw == NULL) return NULL;
+    Byte *p = raw + offset;
+    BASE_PLAIN_SIZE(p) = size;
+    BASE_KEY(p) = (size_t)p ^ BASE_PLAIN_KEY;
     return p;
 }
 
-Any base_realloc(const char *file, const char *function, int line, Any ptr, size_t size) {
-    Any p = realloc(ptr, size);
+// Allocates a header in front of size bytes of data. The data is aligned to 
+// BASE_ALIGNMENT if aligned is true, else to 16 bytes. If pooled is true, the 
+// header and the data are a zero-initialized block of the node pool. Returns 
+// NULL if the system allocator fails.
+static BaseAllocInfo *base_alloc_header(size_t size, bool clear, bool aligned, bool pooled) {
+    size_t padding = aligned ? BASE_ALIGNMENT - 16 : 0;
+    Byte *raw;
+    if (pooled) {
+        raw = base_pool_alloc(BASE_ALLOC_HEADER_SIZE + size);
+    } else {
+        raw = clear ? calloc(1, BASE_ALLOC_HEADER_SIZE + padding + size) : malloc(BASE_ALLOC_HEADER_SIZE + padding + size);
+    }
+    if (raw == NULL) return NULL;
+    Byte *data = raw + BASE_ALLOC_HEADER_SIZE;
+    if (aligned) {
+        data = (Byte*)(((size_t)data + BASE_ALIGNMENT - 1) & ~(size_t)(BASE_ALIGNMENT - 1));
+    }
+    BaseAllocInfo *ai = BASE_ALLOC_INFO(data);
+    ai->offset = (Byte*)ai - raw;
+    ai->aligned = aligned;
+    ai->pooled = pooled;
+    return ai;
+}
+
+// Allocates a block, from the node pool if pooled is true. Returns NULL if 
+// the system allocator fails. In sampling mode, most blocks contain no 
+// sample point. These get a plain header (or none in the pool) and no 
+// garbage, so they cost about as much as a plain malloc.
+static Any base_alloc(const char *file, const char *function, int line, size_t size, bool clear, bool aligned, bool pooled) {
+    if (base_current_arena != NULL) {
+        Any p = base_arena_alloc(base_current_arena, size, aligned ? BASE_ALIGNMENT : 16);
+        if (clear) memset(p, 0, size);
+        return p;
+    }
+    unsigned int samples = 0;
+    if (sample_interval > 0) {
+        if (base_sample_thread_epoch != __atomic_load_n(&base_sample_epoch, __ATOMIC_RELAXED)) {
+            base_sample_reset();
+        }
+        base_sample_countdown -= (long long)size;
+        if (base_sample_countdown > 0) return pooled ? base_pool_alloc(size) : base_plain_alloc(size, clear, aligned);
+        samples = base_sample_points();
+    }
+
+    // outside of sampling mode, allocate four bytes more than requested and 
+    // fill with garbage, such that non-terminated strings will produce an 
+    // unexpected result
+    bool fill = !clear && samples == 0;
+    BaseAllocInfo *ai = base_alloc_header(fill ? size + 4 : size, clear, aligned, pooled);
+    if (ai == NULL) return NULL;
+    Any p = BASE_ALLOC_DATA(ai);
+    // printf("%s, line %d: malloc(%lu) returned %lx\n", file, line, (unsigned long)size, (unsigned long)p);
+
+    if (fill) {
+        memset(p, '?', size + 3);
+        ((char*)p)[size + 3] = '\0';
+    }
+
+    base_alloc_info_init(ai, size, file, function, line);
+    ai->samples = samples;
+    base_alloc_info_link(ai);
+    if (aligned) base_advise_huge_pages(p, size);
+    return p;
+}
+
+Any base_malloc(const char *file, const char *function, int line, size_t size) {
+    Any p = base_alloc(file, function, line, size, false, false, false);
     if (p == NULL) {
-        fprintf(stderr, "%s, line %d: malloc(%lu) called in base_realloc returned NULL!\n",
+        fprintf(stderr, "%s, line %d: malloc(%lu) called in base_malloc returned NULL!\n", 
                 file, line, (unsigned long)size);
         base_exit(EXIT_FAILURE);
     }
-    BaseAllocInfo *ai = base_alloc_info;
-    while(ai && ai->p != ptr) ai = ai->next;
-    if (ai == NULL) {
-        ai = malloc(sizeof(BaseAllocInfo));
-        ai->next = base_alloc_info;
-        base_alloc_info = ai;
+    return p;
+}
+
+Any base_malloc_aligned(const char *file, const char *function, int line, size_t size) {
+    Any p = base_alloc(file, function, line, size, false, true, false);
+    if (p == NULL) {
+        fprintf(stderr, "%s, line %d: malloc(%lu) called in base_malloc_aligned returned NULL!\n", 
+                file, line, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
     }
-    ai->p = p;
-    ai->size = size;
-    ai->file = file;
-    ai->function = function;
-    ai->line = line;
     return p;
 }
+
+Any base_realloc(const char *file, const char *function, int line, Any ptr, size_t size) {
+    if (ptr == NULL) {
+        return base_malloc(file, function, line, size);
+    }
+    BaseAllocInfo *ai = base_alloc_info_of(ptr);
+    if (ai == NULL && base_is_arena_block(ptr)) {
+        return base_arena_realloc(ptr, size);
+    }
+    if (ai == NULL && base_plain_offset(ptr) > 0) {
+        // a block without sample point from sampling mode: keep it that way
+        Any p = base_plain_realloc(ptr, size);
+        if (p == NULL) {
+            fprintf(stderr, "%s, line %d: malloc(%lu) called in base_realloc returned NULL!\n",
+                    file, line, (unsigned long)size);
+            base_exit(EXIT_FAILURE);
+        }
+        return p;
+    }
+    if ((ai == NULL && base_region_kind(ptr) == BASE_REGION_SLAB) || (ai != NULL && ai->pooled)) {
+        // a list node: move out of the pool
+        size_t old_size = ai != NULL ? ai->size : (size_t)BASE_POOL_SLAB_OF(ptr)->block_size;
+        Any p = base_malloc(file, function, line, size);
+        memcpy(p, ptr, old_size < size ? old_size : size);
+        base_free(ptr);
+        return p;
+    }
+    if (ai == NULL) {
+        // not allocated by base_malloc, e.g., by strdup: move into a tracked block
+        Any q = realloc(ptr, size);
+        if (q == NULL) {
+            fprintf(stderr, "%s, line %d: malloc(%lu) called in base_realloc returned NULL!\n",
+                    file, line, (unsigned long)size);
+            base_exit(EXIT_FAILURE);
+        }
+        Any p = base_malloc(file, function, line, size);
+        memcpy(p, q, size);
+        free(q);
+        return p;
+    }
+    base_alloc_info_unlink(ai);
+    base_alloc_info_release(ai);
+    if (ai->aligned) {
+        // realloc would not keep the alignment: move into a new aligned block
+        BaseAllocInfo *bi = base_alloc_header(size, false, true, false);
+        if (bi != NULL) {
+            memcpy(BASE_ALLOC_DATA(bi), ptr, ai->size < size ? ai->size : size);
+            bi->samples = ai->samples;
+            free((Byte*)ai - ai->offset);
+            base_advise_huge_pages(BASE_ALLOC_DATA(bi), size);
+        }
+        ai = bi;
+    } else {
+        ai = realloc(ai, BASE_ALLOC_HEADER_SIZE + size);
+    }
+    if (ai == NULL) {
+        fprintf(stderr, "%s, line %d: malloc(%lu) called in base_realloc returned NULL!\n",
+                file, line, (unsigned long)size);
+        base_exit(EXIT_FAILURE);
+    }
+    unsigned int samples = ai->samples;
+    base_alloc_info_init(ai, size, file, function, line);
+    ai->samples = samples;
+    base_alloc_info_link(ai);
+    return BASE_ALLOC_DATA(ai);
+}
+
 Any base_calloc(const char *file, const char *function, int line, size_t num, size_t size) {
     // printf("%s, line %d: xcalloc(%lu, %lu)\n", file, line, (unsigned long)num, (unsigned long)size);
-    Any p = calloc(num, size);
+    Any p = NULL;
+    if (size == 0 || num <= ((size_t)-1 - BASE_ALLOC_HEADER_SIZE - BASE_ALIGNMENT) / size) {
+        p = base_alloc(file, function, line, num * size, true, false, false);
+    }
     if (p == NULL) {
         fprintf(stderr, "%s, line %d: calloc(%lu, %lu) called in base_calloc returned NULL!\n", 
                 file, line, (unsigned long)num, (unsigned long)size);
         base_exit(EXIT_FAILURE);
     }
     // printf("%s, line %d: xcalloc(%lu, %lu) returned %lx\n", file, line, (unsigned long)num, (unsigned long)size, (unsigned long)p);
+    return p;   
+}
 
-    BaseAllocInfo *ai = malloc(sizeof(BaseAllocInfo));
-    if (ai == NULL) {
-        fprintf(stderr, "%s, line %d: malloc(sizeof(BaseAllocInfo)) called in base_calloc returned NULL!\n", 
-                file, line);
+Any base_calloc_aligned(const char *file, const char *function, int line, size_t num, size_t size) {
+    Any p = NULL;
+    if (size == 0 || num <= ((size_t)-1 - BASE_ALLOC_HEADER_SIZE - BASE_ALIGNMENT) / size) {
+        p = base_alloc(file, function, line, num * size, true, true, false);
+    }
+    if (p == NULL) {
+        fprintf(stderr, "%s, line %d: calloc(%lu, %lu) called in base_calloc_aligned returned NULL!\n", 
+                file, line, (unsigned long)num, (unsigned long)size);
         base_exit(EXIT_FAILURE);
     }
-    ai->p = p;
-    ai->size = num * size;
-    ai->file = file;
-    ai->function = function;
-    ai->line = line;
-    ai->next = base_alloc_info;
-    base_alloc_info = ai;
-    // printf("base_calloc entered %p\n", base_alloc_info->p);
+    return p;
+}
 
-    return p;   
+void base_free(Any p) {
+#if 0
+    // debug output
+    printf("base_free: Calling free on %p\n", p);
+    for (int i = 0; i < BASE_SHARDS; i++) {
+        for (size_t b = 0; b < base_alloc_shards[i].capacity; b++) {
+            for (BaseAllocInfo *dp = base_alloc_shards[i].buckets[b]; dp != NULL; dp = dp->next) {
+                printf("%p\n", BASE_ALLOC_DATA(dp));
+            }
+        }
+    }
+#endif
+    if (p == NULL) return;
+    BaseAllocInfo *ai = base_alloc_info_of(p);
+    if (ai == NULL) {
+        size_t offset = base_plain_offset(p);
+        if (offset > 0) { // a block without sample point from sampling mode
+            BASE_KEY(p) = 0;
+            free((Byte*)p - offset);
+            return;
+        }
+        BaseRegionKind kind = base_region_kind(p);
+        if (kind == BASE_REGION_SLAB) { // a list node without sample point from sampling mode
+            base_pool_free_blocks(BASE_POOL_SLAB_OF(p), p, p, 1);
+            return;
+        }
+        if (kind == BASE_REGION_ARENA) return; // released with its arena
+        fprintf(stderr, "base_free: trying to free unknown pointer %p\n", p);
+        free(p);
+        return;
+    }
+    base_alloc_info_unlink(ai);
+    base_alloc_info_release(ai);
+    if (ai->pooled) {
+        base_pool_free_blocks(BASE_POOL_SLAB_OF(ai), ai, ai, 1);
+    } else {
+        free((Byte*)ai - ai->offset);
+    }
+}
+
+// Returns the slot of p if p is a block of the node pool, else NULL. A 
+// tracked block is removed from the index, its slot is the header.
+static Any base_pool_slot(Any p) {
+    BaseAllocInfo *ai = base_alloc_info_of(p);
+    if (ai == NULL) return base_region_kind(p) == BASE_REGION_SLAB ? p : NULL;
+    if (!ai->pooled) return NULL;
+    base_alloc_info_unlink(ai);
+    base_alloc_info_release(ai);
+    return ai;
+}
+
+// With memory tracking, pooled list nodes are tracked like other blocks, 
+// such that leaked nodes are reported. In sampling mode, nodes without 
+// sample point are plain blocks of the pool.
+Any base_node_calloc(const char *file, const char *function, int line, size_t size) {
+    if (size == 0 || BASE_ALLOC_HEADER_SIZE + size > BASE_POOL_MAX || base_current_arena != NULL) {
+        return base_calloc(file, function, line, 1, size);
+    }
+    return base_alloc(file, function, line, size, true, false, true);
 }
 
 static void base_check_memory(void) {
@@ -179,13 +1436,20 @@ static void base_check_memory(void) {
     int n = 0; // number of memory leaks
     size_t s = 0; // total number of leaked bytes
 
-    for (BaseAllocInfo *ai = base_alloc_info; ai != NULL; ai = ai->next) {
-        if (n < 5) { // only show the first ones explicitly
-            fprintf(stderr, "%5lu bytes allocated in %s (%s, line %d) not freed\n", 
-                    (unsigned long)ai->size, ai->function, ai->file, ai->line);
+    for (int i = 0; i < BASE_SHARDS; i++) {
+        BaseAllocShard *shard = &base_alloc_shards[i];
+        base_lock(&shard->lock);
+        for (size_t b = 0; b < shard->capacity; b++) {
+            for (BaseAllocInfo *ai = shard->buckets[b]; ai != NULL; ai = ai->next) {
+                if (n < 5) { // only show the first ones explicitly
+                    fprintf(stderr, "%5lu bytes allocated in %s (%s, line %d) not freed\n", 
+                            (unsigned long)ai->size, ai->site->function, ai->site->file, ai->site->line);
+                }
+                n++;
+                s += ai->size;
+            }
         }
-        n++;
-        s += ai->size;
+        base_unlock(&shard->lock);
     }
 
     if (n > 0) {
@@ -195,6 +1459,299 @@ static void base_check_memory(void) {
     }
 }
 
+// Sorts call sites by number of allocations, then by number of bytes (both decreasing).
+static int base_alloc_site_compare(const void *a, const void *b) {
+    const BaseAllocSite *x = *(BaseAllocSite* const*)a;
+    const BaseAllocSite *y = *(BaseAllocSite* const*)b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+    return 0;
+}
+
+// Returns the profiled call sites, sorted. The caller frees the result with free.
+static BaseAllocSite **base_alloc_sites_sorted(int *n) {
+    BaseAllocSite **sites = malloc((base_alloc_sites_count + 1) * sizeof(BaseAllocSite*));
+    if (sites == NULL) {
+        fprintf(stderr, "malloc called in base_alloc_sites_sorted returned NULL!\n");
+        base_exit(EXIT_FAILURE);
+    }
+    *n = 0;
+    for (size_t i = 0; i < base_alloc_sites_capacity; i++) {
+        BaseAllocSite *site = base_alloc_sites[i];
+        if (site != NULL && site->count > 0) {
+            sites[(*n)++] = site;
+        }
+    }
+    qsort(sites, *n, sizeof(BaseAllocSite*), base_alloc_site_compare);
+    return sites;
+}
+
+void print_allocation_profile(void) {
+    int n = 0;
+    base_lock(&base_alloc_sites_lock);
+    BaseAllocSite **sites = base_alloc_sites_sorted(&n);
+    base_unlock(&base_alloc_sites_lock);
+    fprintf(stderr, "Allocation profile (%d call site%s, lifetimes in number of allocations):\n", 
+            n, n == 1 ? "" : "s");
+    fprintf(stderr, "%10s %12s %12s %8s %8s %8s %8s %8s %8s %8s  %s\n", 
+            "count", "bytes", "peak bytes", "<10", "<100", "<1K", "<10K", "<100K", "<1M", ">=1M", "call site");
+    for (int i = 0; i < n && i < 20; i++) { // only show the top call sites
+        BaseAllocSite *site = sites[i];
+        fprintf(stderr, "%10lu %12lu %12lu", 
+                site->count, site->bytes, (unsigned long)site->peak_live_bytes);
+        for (int b = 0; b < BASE_LIFETIME_BUCKETS; b++) {
+            fprintf(stderr, " %8lu", site->lifetimes[b]);
+        }
+        fprintf(stderr, "  %s (%s, line %d)\n", site->function, site->file, site->line);
+    }
+    if (n > 20) {
+        fprintf(stderr, "... %d more call sites\n", n - 20);
+    }
+    free(sites);
+}
+
+static void base_write_allocation_profile_csv(String name) {
+    FILE *f = fopen(name, "w");
+    if (f == NULL) {
+        fprintf(stderr, "%s: Cannot open %s\n", (String)__func__, name); 
+        return;
+    }
+    int n = 0;
+    base_lock(&base_alloc_sites_lock);
+    BaseAllocSite **sites = base_alloc_sites_sorted(&n);
+    base_unlock(&base_alloc_sites_lock);
+    fprintf(f, "file,function,line,count,bytes,peak_live_bytes,live_bytes,"
+            "lifetime_lt_10,lifetime_lt_100,lifetime_lt_1K,lifetime_lt_10K,lifetime_lt_100K,lifetime_lt_1M,lifetime_ge_1M\n");
+    for (int i = 0; i < n; i++) {
+        BaseAllocSite *site = sites[i];
+        fprintf(f, "\"%s\",\"%s\",%d,%lu,%lu,%lu,%lu", site->file, site->function, site->line, 
+                site->count, site->bytes, (unsigned long)site->peak_live_bytes, (unsigned long)site->live_bytes);
+        for (int b = 0; b < BASE_LIFETIME_BUCKETS; b++) {
+            fprintf(f, ",%lu", site->lifetimes[b]);
+        }
+        fprintf(f, "\n");
+    }
+    free(sites);
+    fclose(f);
+}
+
+// Sorts call sites by estimated number of live bytes (decreasing).
+static int base_alloc_site_compare_sample(const void *a, const void *b) {
+    const BaseAllocSite *x = *(BaseAllocSite* const*)a;
+    const BaseAllocSite *y = *(BaseAllocSite* const*)b;
+    if (x->sample_bytes != y->sample_bytes) return x->sample_bytes < y->sample_bytes ? 1 : -1;
+    return 0;
+}
+
+// Estimates the live bytes per call site from the live sampled blocks.
+// Returns the number of call sites with live sampled blocks. The caller 
+// holds base_alloc_sites_lock.
+static int base_print_heap_sample_locked(const char *title) {
+    for (size_t i = 0; i < base_alloc_sites_capacity; i++) {
+        BaseAllocSite *site = base_alloc_sites[i];
+        if (site != NULL) {
+            site->sample_blocks = 0;
+            site->sample_bytes = 0;
+        }
+    }
+    int n = 0;
+    double total = 0;
+    for (int i = 0; i < BASE_SHARDS; i++) {
+        BaseAllocShard *shard = &base_alloc_shards[i];
+        base_lock(&shard->lock);
+        for (size_t b = 0; b < shard->capacity; b++) {
+            for (BaseAllocInfo *ai = shard->buckets[b]; ai != NULL; ai = ai->next) {
+                if (ai->samples > 0) {
+                    BaseAllocSite *site = ai->site;
+                    if (site->sample_blocks == 0) n++;
+                    site->sample_blocks++;
+                    site->sample_bytes += (double)ai->samples * sample_interval;
+                    total += (double)ai->samples * sample_interval;
+                }
+            }
+        }
+        base_unlock(&shard->lock);
+    }
+    if (n == 0) return 0;
+    BaseAllocSite **sites = malloc(n * sizeof(BaseAllocSite*));
+    if (sites == NULL) {
+        fprintf(stderr, "malloc called in base_print_heap_sample returned NULL!\n");
+        base_exit(EXIT_FAILURE);
+    }
+    int k = 0;
+    for (size_t i = 0; i < base_alloc_sites_capacity; i++) {
+        BaseAllocSite *site = base_alloc_sites[i];
+        if (site != NULL && site->sample_blocks > 0) {
+            sites[k++] = site;
+        }
+    }
+    qsort(sites, n, sizeof(BaseAllocSite*), base_alloc_site_compare_sample);
+    fprintf(stderr, "%s (about %.0f bytes, one sample per %ld bytes allocated):\n", title, total, sample_interval);
+    fprintf(stderr, "%14s %8s  %s\n", "est. bytes", "samples", "call site");
+    for (int i = 0; i < n && i < 20; i++) { // only show the top call sites
+        BaseAllocSite *site = sites[i];
+        fprintf(stderr, "%14.0f %8ld  %s (%s, line %d)\n", 
+                site->sample_bytes, site->sample_blocks, site->function, site->file, site->line);
+    }
+    if (n > 20) {
+        fprintf(stderr, "... %d more call sites\n", n - 20);
+    }
+    free(sites);
+    return n;
+}
+
+static int base_print_heap_sample(const char *title) {
+    base_lock(&base_alloc_sites_lock);
+    int n = base_print_heap_sample_locked(title);
+    base_unlock(&base_alloc_sites_lock);
+    return n;
+}
+
+void print_heap_sample(void) {
+    if (sample_interval <= 0) {
+        fprintf(stderr, "print_heap_sample: sampling is off, see sample_allocations\n");
+    } else if (base_print_heap_sample("Live heap sample") == 0) {
+        fprintf(stderr, "Live heap sample: no sampled blocks\n");
+    }
+}
+
+// Returns the footprint of a tracked block.
+static Footprint base_alloc_footprint(BaseAllocInfo *ai, size_t payload) {
+    if (ai->pooled) {
+        return base_footprint(BASE_POOL_SLAB_OF(ai)->block_size, BASE_ALLOC_HEADER_SIZE, payload);
+    }
+    Byte *raw = (Byte*)ai - ai->offset;
+    return base_footprint(base_system_bytes(raw, ai->offset + BASE_ALLOC_HEADER_SIZE + ai->size), 
+            BASE_ALLOC_HEADER_SIZE + ai->offset, payload);
+}
+
+Footprint memory_footprint(Any p, size_t payload) {
+    if (p == NULL) return base_footprint(0, 0, 0);
+    BaseAllocInfo *ai = base_alloc_info_of(p);
+    if (ai != NULL) return base_alloc_footprint(ai, payload);
+    size_t offset = base_plain_offset(p);
+    if (offset > 0) { // a block without sample point from sampling mode
+        Byte *raw = (Byte*)p - offset;
+        return base_footprint(base_system_bytes(raw, offset + BASE_PLAIN_SIZE(p)), offset, payload);
+    }
+    if (base_region_kind(p) == BASE_REGION_SLAB) { // a list node without sample point from sampling mode
+        return base_footprint(BASE_POOL_SLAB_OF(p)->block_size, 0, payload);
+    }
+    if (base_is_arena_block(p)) {
+        return base_footprint(BASE_ARENA_ROUND(BASE_ARENA_BLOCK(p)->size), 0, payload);
+    }
+    return base_footprint(base_system_bytes(p, 0), 0, payload);
+}
+
+// The container type of a tracked block is derived from the prefix of the 
+// function that allocated it, e.g., ia_create allocates for an int array.
+static const char *base_footprint_prefixes[] = { 
+    "a", "ia", "da", "sa", "pa", "ba", "l", "il", "dl", "sl", "pl", "s" 
+};
+static const char *base_footprint_types[] = { 
+    "arrays (a_)", "int arrays (ia_)", "double arrays (da_)", "string arrays (sa_)", 
+    "pointer arrays (pa_)", "byte arrays (ba_)", "lists (l_)", "int lists (il_)", 
+    "double lists (dl_)", "string lists (sl_)", "pointer lists (pl_)", "strings (s_)", 
+    "other" 
+};
+#define BASE_FOOTPRINT_TYPES (sizeof(base_footprint_types) / sizeof(base_footprint_types[0]))
+
+static int base_footprint_type(const char *function) {
+    const char *u = strchr(function, '_');
+    if (u != NULL) {
+        size_t n = u - function;
+        for (int i = 0; i < BASE_FOOTPRINT_TYPES - 1; i++) {
+            if (strlen(base_footprint_prefixes[i]) == n && strncmp(function, base_footprint_prefixes[i], n) == 0) {
+                return i;
+            }
+        }
+    }
+    return BASE_FOOTPRINT_TYPES - 1;
+}
+
+void print_memory_footprint(void) {
+    long blocks[BASE_FOOTPRINT_TYPES] = { 0 };
+    Footprint fs[BASE_FOOTPRINT_TYPES];
+    memset(fs, 0, sizeof(fs));
+    for (int i = 0; i < BASE_SHARDS; i++) {
+        BaseAllocShard *shard = &base_alloc_shards[i];
+        base_lock(&shard->lock);
+        for (size_t b = 0; b < shard->capacity; b++) {
+            for (BaseAllocInfo *ai = shard->buckets[b]; ai != NULL; ai = ai->next) {
+                int t = base_footprint_type(ai->site->function);
+                Footprint f = base_alloc_footprint(ai, ai->size);
+                blocks[t]++;
+                fs[t].payload += f.payload;
+                fs[t].structure += f.structure;
+                fs[t].tracker += f.tracker;
+            }
+        }
+        base_unlock(&shard->lock);
+    }
+    fprintf(stderr, "Memory footprint by container type (live tracked blocks%s):\n", 
+            sample_interval > 0 ? ", sampled blocks only" : "");
+    fprintf(stderr, "%-22s %10s %14s %14s %14s\n", "type", "blocks", "requested", "allocator", "tracker");
+    long total_blocks = 0;
+    Footprint total = { 0, 0, 0 };
+    for (int t = 0; t < BASE_FOOTPRINT_TYPES; t++) {
+        if (blocks[t] == 0) continue;
+        fprintf(stderr, "%-22s %10ld %14zu %14zu %14zu\n", 
+                base_footprint_types[t], blocks[t], fs[t].payload, fs[t].structure, fs[t].tracker);
+        total_blocks += blocks[t];
+        total.payload += fs[t].payload;
+        total.structure += fs[t].structure;
+        total.tracker += fs[t].tracker;
+    }
+    fprintf(stderr, "%-22s %10ld %14zu %14zu %14zu\n", 
+            "total", total_blocks, total.payload, total.structure, total.tracker);
+}
+
+// Called at exit in sampling mode. Reports sampled blocks that have not been freed.
+static void base_report_heap_sample(void) {
+    base_print_heap_sample("Probable memory leaks");
+}
+
+#endif // NO_MEMORY_TRACKING
+
+void base_free_chain(Any first) {
+    Any p = first;
+    while (p != NULL) {
+        Any next = *(Any*)p;
+        Any slot = base_pool_slot(p);
+        if (slot == NULL) {
+            base_free(p);
+            p = next;
+            continue;
+        }
+        // the following blocks of the same slab are returned at once, their 
+        // slots are linked through their first bytes
+        BasePoolSlab *s = BASE_POOL_SLAB_OF(slot);
+        Any last = slot;
+        int n = 1;
+        while (next != NULL && BASE_POOL_SLAB_OF(next) == s) {
+            p = next;
+            next = *(Any*)p;
+            *(Any*)last = base_pool_slot(p);
+            last = *(Any*)last;
+            n++;
+        }
+        base_pool_free_blocks(s, slot, last, n);
+        p = next;
+    }
+}
+
+size_t base_node_pool_bytes(void) {
+    return __atomic_load_n(&base_pool_slab_bytes, __ATOMIC_RELAXED);
+}
+
+// Called at exit if allocation profiling is switched on.
+static void base_report_allocation_profile(void) {
+    print_allocation_profile();
+    if (profile_csv_file != NULL) {
+        base_write_allocation_profile_csv(profile_csv_file);
+    }
+}
+
 
 ////////////////////////////////////////////////////////////////////////////
 // Conversion
@@ -515,31 +2072,18 @@ void write_file_data(String name, Byte *data, int n_data) {
 ////////////////////////////////////////////////////////////////////////////
 // Random numbers
 
-static bool srand_called = false;
+static __thread unsigned long long base_random_state = 0; // each thread has its own generator
 
 int i_rnd(int i) {
     require("positive range", i > 0);
-    if (!srand_called) {
-        srand(time(NULL) << 10);
-        srand_called = true;
-    }
-    int result = 0;
-    if (RAND_MAX == 32767) {
-        result = ((rand() << 16) | rand()) % i;
-    } else {
-        result = rand() % i;
-    }
+    int result = (int)((base_random_next(&base_random_state) >> 11) % (unsigned long long)i);
     ensure("random number in range", 0 <= result && result < i);
     return result;
 }
 
 double d_rnd(double i) {
     require("positive range", i > 0);
-    if (!srand_called) {
-        srand(time(NULL) << 10);
-        srand_called = true;
-    }
-    double r = (double) rand() / (double) RAND_MAX;
+    double r = (base_random_next(&base_random_state) >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
     double result = i * r;
     ensure("random number in range", 0 <= result && result < i);
     return result;
@@ -560,7 +2104,7 @@ int base_check_success_count = 0;
 // http://www.gnu.org/software/libc/manual/html_node/Cleanups-on-Exit.html#Cleanups-on-Exit
 void base_atexit(void) {
     // if not a successful exit, supress further output
-    if (exit_status == EXIT_SUCCESS) {
+    if (__atomic_load_n(&exit_status, __ATOMIC_RELAXED) == EXIT_SUCCESS) {
         // summary information about tests (if any)
         if (base_check_count > 0) {
             int fail_count = base_check_count - base_check_success_count;
@@ -585,9 +2129,15 @@ void base_atexit(void) {
             }
         }
         // information about memory leaks (if any)
-        if (do_memory_check) {
+        if (sample_interval > 0) {
+            base_report_heap_sample();
+        } else if (do_memory_check) {
             base_check_memory();
         }
+        // allocations per call site (if requested)
+        if (do_profile_allocations) {
+            base_report_allocation_profile();
+        }
     }
 }
 
@@ -638,10 +2188,10 @@ void base_atexit_test(void) {
 
 bool base_test_equal_b(const char *file, int line, bool a, bool e) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (a == e) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value ", file, line);
@@ -655,10 +2205,10 @@ bool base_test_equal_b(const char *file, int line, bool a, bool e) {
 
 bool base_test_equal_i(const char *file, int line, int a, int e) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (a == e) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value %d differs from expected value %d.\n", file, line, a, e);
@@ -668,10 +2218,10 @@ bool base_test_equal_i(const char *file, int line, int a, int e) {
 
 bool base_test_within_d(const char *file, int line, double a, double e, double epsilon) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (fabs(a - e) <= epsilon) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value %g is not within %g of expected value %g.\n", file, line, a, epsilon, e);
@@ -681,10 +2231,10 @@ bool base_test_within_d(const char *file, int line, double a, double e, double e
 
 bool base_test_within_i(const char *file, int line, int a, int e, int epsilon) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (abs(a - e) <= epsilon) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value %d is not within %d of expected value %d.\n", file, line, a, epsilon, e);
@@ -694,10 +2244,10 @@ bool base_test_within_i(const char *file, int line, int a, int e, int epsilon) {
 
 bool base_test_equal_c(const char *file, int line, char a, char e) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (a == e) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value '%c' differs from expected value '%c'.\n", file, line, a, e);
@@ -707,10 +2257,10 @@ bool base_test_equal_c(const char *file, int line, char a, char e) {
 
 bool base_test_equal_s(const char *file, int line, String a, String e) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (strcmp(a, e) == 0) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value \"%s\" differs from expected value \"%s\".\n", file, line, a, e);
@@ -720,7 +2270,7 @@ bool base_test_equal_s(const char *file, int line, String a, String e) {
 
 bool base_test_equal_ca(const char *file, int line, Array a, char *e, int ne) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (a->n != ne) {
         printf("%s, line %d: Actual length %d "
             "differs from expected length %d\n", file, line, a->n, ne);
@@ -759,13 +2309,13 @@ bool base_test_equal_ca(const char *file, int line, Array a, char *e, int ne) {
         }
     }
     printf("%s, line %d: Check passed.\n", file, line);
-    base_check_success_count++;
+    BASE_INCREMENT(base_check_success_count);
     return true;
 }
 
 bool base_test_equal_boa(const char *file, int line, Array a, bool *e, int ne) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (a->n != ne) {
         printf("%s, line %d: Actual length %d "
             "differs from expected length %d\n", file, line, a->n, ne);
@@ -804,7 +2354,7 @@ bool base_test_equal_boa(const char *file, int line, Array a, bool *e, int ne) {
         }
     }
     printf("%s, line %d: Check passed.\n", file, line);
-    base_check_success_count++;
+    BASE_INCREMENT(base_check_success_count);
     return true;
 }
 
@@ -813,10 +2363,10 @@ bool base_test_equal_struct(const char *file, int line,
 {
     bool (*pred)(Any, Any) = predicate;
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
     if (pred(actual, expected)) {
         printf("%s, line %d: Check passed.\n", file, line);
-        base_check_success_count++;
+        BASE_INCREMENT(base_check_success_count);
         return true;
     } else {
         printf("%s, line %d: Actual value differs from expected value.\n", file, line);
@@ -826,12 +2376,12 @@ bool base_test_equal_struct(const char *file, int line,
 
 void base_count_check(void) {
     base_init();
-    base_check_count++;
+    BASE_INCREMENT(base_check_count);
 }
 
 void base_count_success(void) {
     base_init();
-    base_check_success_count++;
+    BASE_INCREMENT(base_check_success_count);
 }
 
 
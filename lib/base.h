@@ -42,6 +42,10 @@ The type @c IntStringToString represents a pointer to a function that takes an i
 
 Memory is allocated using @ref xmalloc or @ref xcalloc and released with @ref free. These functions (in fact: macros) keep track of allocated memory and report memory leaks. Make sure to always use @ref xmalloc or @ref xcalloc rather than @c malloc and @c calloc in your code.
 
+<h3>Threads</h3>
+
+The library can be used from multiple threads, as long as each array, list, and arena is used by one thread at a time. Memory allocation, leak tracking, random numbers, and the test counters are thread-safe. Each thread has its own random number generator and its own current arena (see @ref arena_enter). Settings such as @ref report_memory_leaks, @ref profile_allocations, and @ref sample_allocations should be made before starting threads.
+
 <h3>Examples</h3>
 
 <h4>Example 1: Printing an integer</h4>
@@ -157,6 +161,34 @@ Switches memory checking on or off. If on, checks for memory leaks when thr prog
 */
 void report_memory_leaks(bool do_check);
 
+/**
+Switches allocation profiling on or off. If on, the allocations of each call site of @ref xmalloc, @ref xcalloc, and @ref xrealloc are counted. For each call site the profile contains the number of allocations, the total number of bytes, the peak number of live bytes, and a histogram of block lifetimes. Lifetimes are measured in number of allocations between allocating and freeing a block. When the program terminates, the call sites with the most allocations are printed to stderr. Only allocations made while profiling is on are counted.
+@param[in] do_profile if @c true, then allocations are profiled
+@param[in] csv_file if not @c NULL, then the profile of all call sites is also written to this file in CSV format when the program terminates
+@see print_allocation_profile
+*/
+void profile_allocations(bool do_profile, String csv_file);
+
+/**
+Prints the current allocation profile to stderr, sorted by number of allocations.
+@see profile_allocations
+*/
+void print_allocation_profile(void);
+
+/**
+Switches sampling mode on or off. Sampling mode is meant for long-running programs, for which tracking every allocation is too costly. Only about one allocation per @c mean_bytes allocated bytes is tracked. The sample points are placed at random, exponentially distributed distances in the stream of allocated bytes, so larger blocks are more likely to be sampled. A sampled block that contains k sample points counts as k * mean_bytes bytes, which estimates the live heap per call site without bias. Memory is not filled with garbage in sampling mode. Only tracked allocations are profiled (see @ref profile_allocations). When the program terminates, sampled blocks that have not been freed are reported as probable memory leaks. Blocks allocated before sampling mode was switched on remain tracked. The sampling interval should not be changed while sampled blocks are live.
+@param[in] mean_bytes mean number of bytes between sample points, e.g., 524288; 0 switches sampling mode off
+@pre "non-negative interval", mean_bytes >= 0
+@see print_heap_sample
+*/
+void sample_allocations(int mean_bytes);
+
+/**
+Prints the estimated live heap per call site to stderr, based on the live sampled blocks.
+@see sample_allocations
+*/
+void print_heap_sample(void);
+
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -529,6 +561,12 @@ Prints the execution time of a function (in milliseconds).
 
 // http://www.gnu.org/software/libc/manual/html_node/Malloc-Examples.html
 
+/**
+Switching memory allocation tracking on and off.
+If @c NO_MEMORY_TRACKING is defined when compiling the library, then @ref xmalloc, @ref xcalloc, @ref xrealloc, and @ref free directly call the system allocator. Allocated memory is not filled with garbage and memory leaks are not reported. The release variant of the library, @c libprog1_release.a (<code>make release</code>), is compiled this way.
+*/
+#define NO_MEMORY_TRACKING_DOC
+
 /**
 Allocates a block of size bytes using @c malloc. Exits with an error message on failure. The contents of the allocated memory block is not initialized (i.e., the memory block contains arbitrary values). Stores file name and line number for error reporting. For zero-initialized memory use @ref xcalloc.
 
@@ -596,6 +634,96 @@ Allocates a block of (num * size) bytes with @c calloc. Exits with error message
 */
 #define xcalloc(num, size) base_calloc(__FILE__, __func__, __LINE__, num, size)
 
+/**
+Allocates a block of size bytes whose address is a multiple of 64 (the size of a cache line).
+@param[in] file file name of source code
+@param[in] function function name of source code
+@param[in] line line number in source code
+@param[in] size number of bytes to allocate
+@return pointer to the allocated memory block
+@see xmalloc_aligned
+@private
+*/
+Any base_malloc_aligned(const char *file, const char *function, int line, size_t size);
+
+/**
+Allocates a block of size bytes like @ref xmalloc, but the address of the block is a multiple of 64 (the size of a cache line). Vectorized loops over the block then never load across a cache line boundary. The array modules allocate the elements of arrays of at least 256 bytes this way (see array.h), smaller arrays are only 16-byte aligned. The block stays aligned when it is resized with @ref xrealloc. It is released with @ref free.
+@param[in] size number of bytes to allocate
+@return pointer to the allocated memory block
+@see xcalloc_aligned, use_huge_pages
+*/
+#define xmalloc_aligned(size) base_malloc_aligned(__FILE__, __func__, __LINE__, size)
+
+/**
+Allocates a block of (num * size) zero bytes whose address is a multiple of 64.
+@param[in] file file name of source code
+@param[in] function function name
+@param[in] line line number in source code
+@param[in] num number of elements
+@param[in] size size (in bytes) of each element
+@return pointer to the allocated memory block
+@see xcalloc_aligned
+@private
+*/
+Any base_calloc_aligned(const char *file, const char *function, int line, size_t num, size_t size);
+
+/**
+Allocates a block of (num * size) bytes like @ref xcalloc, but the address of the block is a multiple of 64 (the size of a cache line).
+@param[in] num number of elements
+@param[in] size size (in bytes) of each element
+@return pointer to the allocated memory block
+@see xmalloc_aligned, use_huge_pages
+*/
+#define xcalloc_aligned(num, size) base_calloc_aligned(__FILE__, __func__, __LINE__, num, size)
+
+/**
+Allocates a zero-initialized block of size bytes for a list node, like @ref xcalloc. Small blocks come from a pool of slabs, which is much cheaper than the system allocator: up to 128 bytes in the release variant, and up to 80 bytes with memory tracking, where the block also holds the tracking header. Pooled blocks are tracked like those of @ref xcalloc, such that leaked nodes are reported. They are released with @ref free like other blocks, a slab is returned to the system when all its blocks are free, unless it is the last slab of its size class and shard that has free blocks.
+@param[in] file source file name
+@param[in] function function name
+@param[in] line line number in source code
+@param[in] size size of the block in bytes
+@return pointer to the allocated memory block
+@see l_node_alloc
+@private
+*/
+Any base_node_calloc(const char *file, const char *function, int line, size_t size);
+
+/**
+Frees a chain of blocks, each of which starts with a pointer to the next block of the chain (e.g., the nodes of a list). Consecutive pooled blocks of the same slab are returned at once.
+@param[in] first first block of the chain (or NULL)
+@see base_node_calloc
+@private
+*/
+void base_free_chain(Any first);
+
+/**
+Returns the number of bytes in the slabs of the node pool.
+@return bytes reserved for pooled list nodes
+@private
+*/
+size_t base_node_pool_bytes(void);
+
+/**
+Switches the use of transparent huge pages for large aligned blocks on or off. Off by default. If on, blocks of at least 4 MB allocated with @ref xmalloc_aligned or @ref xcalloc_aligned (e.g., the elements of large arrays) are advised to the kernel as huge page candidates (<code>madvise(MADV_HUGEPAGE)</code>), which reduces TLB misses when scanning them. Without memory tracking they also start at a 2 MB boundary. Whether huge pages are actually used depends on the system configuration (<code>/sys/kernel/mm/transparent_hugepage/enabled</code>). Only blocks allocated while huge pages are switched on are affected. Has no effect on systems other than Linux.
+@param[in] do_use whether to use huge pages
+*/
+void use_huge_pages(bool do_use);
+
+/**
+Returns how many bytes a block allocated with @ref xmalloc, @ref xcalloc, @ref xrealloc, or one of their aligned variants really occupies. The caller states how many bytes of the block are payload. The rest of the block and the bookkeeping of the system allocator count as structure, the memory tracking header counts as tracker overhead. The bytes the system allocator adds are only known on Linux and macOS, elsewhere they count as 0. Blocks of an arena are included with their arena header.
+@param[in] p block allocated by this library (or NULL)
+@param[in] payload number of payload bytes in the block
+@return the footprint of the block
+@see a_footprint, l_footprint, print_memory_footprint
+*/
+Footprint memory_footprint(Any p, size_t payload);
+
+/**
+Prints a summary of all live blocks to stderr, broken down by container type (e.g., int arrays, string lists, strings). The type of a block is derived from the function that allocated it (e.g., @c ia_create allocates for int arrays). For each type the summary shows the number of blocks, the number of requested bytes, the bytes added by the system allocator, and the bytes of the memory tracking headers. In sampling mode (see @ref sample_allocations) only the sampled blocks are tracked and shown. Blocks of arenas are not shown. In the release variant no blocks are tracked.
+@see memory_footprint
+*/
+void print_memory_footprint(void);
+
 /**
 Our own version of free. Keeps track of allocated blocks for error reporting.
 @param[in] p pointer to memory block to free
@@ -622,6 +750,76 @@ Exits the process and returns the given status to the operating system.
 */
 #define exit base_exit
 
+////////////////////////////////////////////////////////////////////////////
+// Arenas
+
+/**
+An arena (or region) is a memory pool from which blocks are cut one after the other. Blocks of an arena are not freed individually, but all at once with @ref arena_reset or @ref arena_free.
+
+While an arena is current (see @ref arena_enter), all blocks allocated with @ref xmalloc, @ref xcalloc, and @ref xrealloc come from this arena. This includes all arrays, lists, and strings created by the library functions (e.g., @c a_create, @c sl_split, @c s_sub, @c ia_filter, @c l_map), as well as the new nodes and element blocks of containers that were created outside the arena but grow while it is current (e.g., @c l_append, @c il_insert, @c ia_push). Such a container then points into the arena and must not be used after @ref arena_reset or @ref arena_free, so containers that outlive the arena should only be modified while it is not current (see @ref arena_leave). Calling @ref free on a block of an arena does nothing, so existing code that frees its temporary objects works unchanged. Arena blocks are not tracked, i.e., they are never reported as memory leaks.
+
+Example:
+@code{.c}
+Arena arena = arena_create(64 * 1024);
+for (int i = 0; i < n; i++) {
+    arena_enter(arena);
+    List words = sl_split(requests[i], ' ');
+    ... // no need to free words
+    arena_leave();
+    arena_reset(arena); // releases everything allocated in the loop body
+}
+arena_free(arena);
+@endcode
+*/
+typedef struct ArenaHead * Arena;
+
+/**
+Creates an arena.
+@param[in] chunk_size number of bytes the arena requests from the system allocator at a time, rounded up to a multiple of 64 KB
+@return the new arena
+@pre "positive chunk size"
+*/
+Arena arena_create(int chunk_size);
+
+/**
+Releases all blocks of the arena at once. The arena can be used again afterwards. If the blocks since the last reset did not fit into a single chunk, the arena keeps one chunk that is large enough for all of them.
+@param[in,out] arena the arena to reset
+*/
+void arena_reset(Arena arena);
+
+/**
+Releases all blocks of the arena and the arena itself.
+@param[in,out] arena the arena to free
+@pre "arena not entered"
+*/
+void arena_free(Arena arena);
+
+/**
+Makes the arena the current arena. Subsequent allocations come from this arena until @ref arena_leave is called. Arenas can be nested.
+@param[in,out] arena the arena to enter
+@pre "arena not entered"
+*/
+void arena_enter(Arena arena);
+
+/**
+Leaves the current arena. The arena that was current before the matching @ref arena_enter (or none) becomes current again.
+@pre "inside an arena"
+*/
+void arena_leave(void);
+
+/**
+Returns the current arena.
+@return the current arena or NULL if allocations currently come from the heap
+*/
+Arena arena_current(void);
+
+/**
+Returns the number of bytes handed out by the arena since it was created or last reset, including block headers.
+@param[in] arena the arena
+@return number of bytes handed out by the arena
+*/
+size_t arena_bytes(Arena arena);
+
 
 ////////////////////////////////////////////////////////////////////////////
 // Conversion
@@ -910,5 +1108,6 @@ void base_count_success(void);
 #include "double_list.h"
 #include "string_list.h"
 #include "pointer_list.h"
+#include "unrolled_list.h"
 
 #endif
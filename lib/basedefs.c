@@ -90,7 +90,11 @@ StringTriple make_string_triple(String a, String b, String c) {
 }
 
 ListHead make_list_head(int s, ListNode *first, ListNode *last) {
-    ListHead result = { s, first, last };
+    int n = 0;
+    for (ListNode *node = first; node != NULL; node = node->next) {
+        n++;
+    }
+    ListHead result = { s, n, first, last, NULL, 0 };
     return result;
 }
 
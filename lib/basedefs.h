@@ -298,6 +298,9 @@ typedef struct ArrayHead {
     int n; ///< number of elements
     int s; ///< element size (in bytes)
     Any a; ///< pointer to actual data
+    int c; ///< capacity: number of elements that fit into the data block without reallocation (c >= n)
+    struct ArrayHead *base; ///< the array whose elements this array views (see a_view), NULL if the array owns its elements
+    struct ArrayShare *share; ///< bookkeeping for elements shared copy-on-write (see a_copy_shared), NULL if the elements were never shared
 } ArrayHead;
 
 typedef struct ArrayHead * Array;
@@ -315,8 +318,11 @@ Contains information about a list.
 */
 typedef struct ListHead { 
     int s; ///< element size (in bytes)
+    int n; ///< number of elements, kept up to date by every function that adds or removes nodes
     Any first; ///< pointer to first list node (or NULL); type is ListNode*, IntListNode*, etc.
     Any last; ///< pointer to last list node (or NULL); type is ListNode*, IntListNode*, etc.
+    Any cursor; ///< the node last accessed by index (or NULL), indexed access starts here if it is not before the cursor (see l_node_at)
+    int cursor_index; ///< index of the cursor node
 } ListHead;
 
 typedef struct ListHead * List;
@@ -358,6 +364,49 @@ typedef struct PointerListNode {
     Any value; ///< value that the node holds
 } PointerListNode;
 
+/**
+Represents a chunk of an unrolled list. The chunk holds up to c elements (see @ref UListHead), which are stored inline right after the chunk header.
+*/
+typedef struct UListChunk {
+    struct UListChunk *next; ///< next chunk (or NULL)
+    int n; ///< number of elements in this chunk
+    int padding; ///< keeps the elements 8-byte aligned
+} UListChunk;
+
+/**
+Contains information about an unrolled list, a list of chunks of elements (see unrolled_list.h).
+*/
+typedef struct UListHead {
+    int s; ///< element size (in bytes)
+    int n; ///< number of elements
+    int c; ///< capacity of a chunk (in elements)
+    UListChunk *first; ///< first chunk (or NULL)
+    UListChunk *last; ///< last chunk (or NULL)
+    UListChunk *cursor; ///< the chunk last accessed by index (or NULL), indexed access starts here if it is not behind the index
+    int cursor_index; ///< index of the first element of the cursor chunk
+} UListHead;
+
+typedef struct UListHead * UList;
+
+/**
+Represents the state for iterating through an unrolled list.
+*/
+typedef struct UListIterator {
+    UListChunk *chunk; ///< current chunk (or NULL)
+    int i; ///< index of the next element in the current chunk
+    int s; ///< element size (in bytes)
+} UListIterator;
+
+/**
+Describes how many bytes an object occupies, e.g., an array or a list. The sum of the three parts is the memory the object really costs.
+@see memory_footprint, a_footprint, l_footprint
+*/
+typedef struct Footprint {
+    size_t payload; ///< bytes of the elements
+    size_t structure; ///< bytes needed to organize the elements: heads, node links, padding and rounding of the allocator
+    size_t tracker; ///< bytes of the memory tracking headers (0 if compiled with NO_MEMORY_TRACKING)
+} Footprint;
+
 
 
 ////////////////////////////////////////////////////////////////////////////
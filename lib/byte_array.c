@@ -6,6 +6,7 @@
 
 #include "array.h"
 #include "byte_array.h"
+#include "array_sort.h"
 
 
 
@@ -36,14 +37,11 @@ static void ba_create_test(void) {
 
 Array ba_create(int n, Byte value) {
     require("non-negative length", n >= 0);
-    Byte *a = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = value;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = a;
     return result;
 }
 
@@ -90,25 +88,19 @@ static void ba_range_test(void) {
 Array ba_range(Byte a, Byte b) {
     if (a <= b) {
         int n = b - a;
-        Byte *arr = xmalloc(n * sizeof(Byte));
+        Array result = a_alloc(n, sizeof(Byte), false);
+        Byte *arr = result->a;
         for (int i = 0; i < n; i++) {
             arr[i] = a + i;
         }
-        Array result = xmalloc(sizeof(ArrayHead));
-        result->n = n;
-        result->s = sizeof(Byte);
-        result->a = arr;
         return result;
     } else /* a > b */ {
         int n = a - b;
-        Byte *arr = xmalloc(n * sizeof(Byte));
+        Array result = a_alloc(n, sizeof(Byte), false);
+        Byte *arr = result->a;
         for (int i = 0; i < n; i++) {
             arr[i] = a - i;
         }
-        Array result = xmalloc(sizeof(ArrayHead));
-        result->n = n;
-        result->s = sizeof(Byte);
-        result->a = arr;
         return result;
     }
 }
@@ -187,7 +179,8 @@ Array ba_of_string(String s) {
     }
 
     // n ints found
-    Byte *a = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *a = result->a;
     t = s;
     int i = 0;
     while (*t != '\0') {
@@ -202,10 +195,6 @@ Array ba_of_string(String s) {
             t++; // not a digit, skip
         }
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = a;
     return result;
 }
 
@@ -242,14 +231,11 @@ static void ba_fn_test(void) {
 Array ba_fn(int n, IntByteToByte init, Byte x) {
     require("non-negative length", n >= 0);
     require_not_null(init);
-    Byte *a = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = init(i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = a;
     return result;
 }
 
@@ -268,11 +254,42 @@ void ba_set(Array array, int index, Byte value) {
     require_element_size_byte(array);
     require_x("index in range", index >= 0 && index < array->n, 
             "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     Byte *a = array->a;
     a[index] = value;
 }
 #endif
 
+static void ba_push_pop_test(void) {
+    printsln((String)__func__);
+    Array a = ba_create(0, 0);
+    for (int i = 0; i < 300; i++) {
+        ba_push(a, i);
+    }
+    test_equal_i(a_length(a), 300);
+    test_equal_i(ba_get(a, 299), 299 % 256);
+    test_equal_i(ba_pop(a), 299 % 256);
+    test_equal_i(a_length(a), 299);
+    a_free(a);
+}
+
+void ba_push(Array array, Byte value) {
+    require_not_null(array);
+    require_element_size_byte(array);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    Byte *a = array->a;
+    a[array->n++] = value;
+}
+
+Byte ba_pop(Array array) {
+    require_not_null(array);
+    require_element_size_byte(array);
+    require("not empty", array->n > 0);
+    Byte *a = array->a;
+    return a[--array->n];
+}
+
 void ba_print(Array array) {
     require_not_null(array);
     require_element_size_byte(array);
@@ -307,13 +324,7 @@ static void ba_contains_test(void) {
 bool ba_contains(Array array, Byte value) {
     require_not_null(array);
     require_element_size_byte(array);
-    Byte *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (a[i] == value) {
-            return true;
-        }
-    }
-    return false;
+    return memchr(array->a, value, array->n) != NULL; // vectorized in the C library
 }
 
 static void ba_fill_test(void) {
@@ -342,6 +353,7 @@ static void ba_fill_test(void) {
 void ba_fill(Array array, Byte value) {
     require_not_null(array);
     require_element_size_byte(array);
+    a_unshare(array);
     Byte *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = value;
@@ -404,6 +416,7 @@ static void ba_fill_from_to_test(void) {
 void ba_fill_from_to(Array array, Byte value, int from, int to) {
     require_not_null(array);
     require_element_size_byte(array);
+    a_unshare(array);
     if (from < 0) from = 0;
     if (to > array->n) to = array->n;
     Byte *a = array->a;
@@ -440,13 +453,8 @@ static void ba_index_test(void) {
 int ba_index(Array array, Byte value) {
     require_not_null(array);
     require_element_size_byte(array);
-    Byte *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    Byte *p = memchr(array->a, value, array->n); // vectorized in the C library
+    return p == NULL ? -1 : (int)(p - (Byte*)array->a);
 }
 
 static void ba_index_from_test(void) {
@@ -465,13 +473,9 @@ int ba_index_from(Array array, Byte value, int from) {
     require_not_null(array);
     require_element_size_byte(array);
     if (from < 0) from = 0;
-    Byte *a = array->a;
-    for (int i = from; i < array->n; i++) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    if (from >= array->n) return -1;
+    Byte *p = memchr((Byte*)array->a + from, value, array->n - from);
+    return p == NULL ? -1 : (int)(p - (Byte*)array->a);
 }
 
 static void ba_index_fn_test(void) {
@@ -563,14 +567,12 @@ int ba_last_index_fn(Array array, ByteIntByteToBool predicate, Byte x) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static CmpResult byte_compare(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    Byte x = *(Byte*)a;
-    Byte y = *(Byte*)b;
-    return (x == y) ? 0 : (x < y ? -1 : 1);
+static inline bool byte_less(const Byte *x, const Byte *y) {
+    return *x < *y;
 }
 
+A_SORT_DEFINE(byte_sort, Byte, byte_less)
+
 static void ba_sort_test(void) {
     printsln((String)__func__);
     Array ac, ex;
@@ -603,22 +605,59 @@ static void ba_sort_test(void) {
     ba_test_equal(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN elements are radix sorted
+    ac = ba_range(200, 0);
+    ex = ba_range(1, 201);
+    ba_sort(ac);
+    ba_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
 void ba_sort(Array array) {
     require_not_null(array);
     require_element_size_byte(array);
-    qsort(array->a, array->n, array->s, byte_compare);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN) {
+        a_counting_sort_byte(array->a, array->n, false);
+    } else {
+        byte_sort_n(array->a, array->n);
+    }
+}
+
+static void ba_sort_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = ba_of_string("5, 4, 3, 2, 1");
+    Array ex = ba_of_string("5, 2, 3, 4, 1");
+    ba_sort_from_to(ac, 1, 4);
+    ba_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
+}
+
+void ba_sort_from_to(Array array, int from, int to) {
+    require_not_null(array);
+    require_element_size_byte(array);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    if (from < to) {
+        Byte *a = array->a;
+        if (to - from >= A_RADIX_SORT_MIN) {
+            a_counting_sort_byte(a + from, to - from, false);
+        } else {
+            byte_sort_n(a + from, to - from);
+        }
+    }
 }
 
-static CmpResult byte_compare_dec(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    Byte x = *(Byte*)b;
-    Byte y = *(Byte*)a;
-    return (x == y) ? 0 : (x < y ? -1 : 1);
+static inline bool byte_greater(const Byte *x, const Byte *y) {
+    return *x > *y;
 }
 
+A_SORT_DEFINE(byte_sort_dec, Byte, byte_greater)
+
 void ba_sort_dec(Array array);
 
 static void ba_sort_dec_test(void) {
@@ -653,12 +692,25 @@ static void ba_sort_dec_test(void) {
     ba_test_equal(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN elements are radix sorted
+    ac = ba_range(1, 201);
+    ex = ba_range(200, 0);
+    ba_sort_dec(ac);
+    ba_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
 void ba_sort_dec(Array array) {
     require_not_null(array);
     require_element_size_byte(array);
-    qsort(array->a, array->n, array->s, byte_compare_dec);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN) {
+        a_counting_sort_byte(array->a, array->n, true);
+    } else {
+        byte_sort_dec_n(array->a, array->n);
+    }
 }
 
 static void ba_insert_test(void) {
@@ -711,6 +763,7 @@ static void ba_insert_test(void) {
 void ba_insert(Array array, int i, Byte v) {
     require_not_null(array);
     require_element_size_byte(array);
+    a_unshare(array);
     if (i < 0 || i >= array->n) return;
     // make space at i
     Byte *a = array->a;
@@ -778,6 +831,7 @@ static void ba_remove_test(void) {
 void ba_remove(Array array, int i, Byte v) {
     require_not_null(array);
     require_element_size_byte(array);
+    a_unshare(array);
     if (i < 0 || i >= array->n) return;
     // shift down, starting from i
     Byte *a = array->a;
@@ -887,6 +941,7 @@ void ba_each(Array array, ByteIntByteToByte f, Byte x) {
     require_not_null(array);
     require_not_null(f);
     require_element_size_byte(array);
+    a_unshare(array);
     Byte *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x);
@@ -903,6 +958,7 @@ void ba_each_state(Array array, ByteIntByteAnyToByte f, Byte x, Any state) {
     require_not_null(f);
     require_not_null(array);
     require_element_size_byte(array);
+    a_unshare(array);
     Byte *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x, state);
@@ -915,14 +971,11 @@ Array ba_map(Array array, ByteIntByteToByte f, Byte x) {
     require_not_null(f);
     require_element_size_byte(array);
     Byte *a = array->a;
-    Byte *b = xmalloc(array->n * sizeof(Byte));
+    Array result = a_alloc(array->n, sizeof(Byte), false);
+    Byte *b = result->a;
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(Byte);
-    result->a = b;
     return result;
 }
 
@@ -932,14 +985,11 @@ Array ba_map_state(Array array, ByteIntByteAnyToByte f, Byte x, Any state) {
     require_not_null(f);
     require_element_size_byte(array);
     Byte *a = array->a;
-    Byte *b = xmalloc(array->n * sizeof(Byte));
+    Array result = a_alloc(array->n, sizeof(Byte), false);
+    Byte *b = result->a;
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x, state);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(Byte);
-    result->a = b;
     return result;
 }
 
@@ -1027,17 +1077,14 @@ Array ba_filter(Array array, ByteIntByteToBool predicate, Byte x) {
         ps[i] = predicate(a[i], i, x);
         if (ps[i]) n++;
     }
-    Byte *b = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = b;
     return result;
 }
 
@@ -1054,17 +1101,14 @@ Array ba_filter_state(Array array, ByteIntByteAnyToBool predicate, Byte x, Any s
         ps[i] = predicate(a[i], i, x, state);
         if (ps[i]) n++;
     }
-    Byte *b = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = b;
     return result;
 }
 
@@ -1102,13 +1146,10 @@ Array ba_choose(Array array, ByteIntByteToByteOption f, Byte x) {
             b[n++] = op.some;
         }
     }
-    Byte *c = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *c = result->a;
     memcpy(c, b, n * sizeof(Byte));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = c;
     return result;
 }
 
@@ -1127,13 +1168,10 @@ Array ba_choose_state(Array array, ByteIntByteAnyToByteOption f, Byte x, Any sta
             b[n++] = op.some;
         }
     }
-    Byte *c = xmalloc(n * sizeof(Byte));
+    Array result = a_alloc(n, sizeof(Byte), false);
+    Byte *c = result->a;
     memcpy(c, b, n * sizeof(Byte));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Byte);
-    result->a = c;
     return result;
 }
 
@@ -1263,6 +1301,7 @@ bool ba_test_equal_file_line(const char *file, const char *function, int line, A
 
 void ba_test_all(void) {
     ba_create_test();
+    ba_push_pop_test();
     ba_range_test();
     ba_of_string_test();
     ba_fn_test();
@@ -1276,6 +1315,7 @@ void ba_test_all(void) {
     ba_last_index_from_test();
     ba_last_index_fn_test();
     ba_sort_test();
+    ba_sort_from_to_test();
     ba_sort_dec_test();
     ba_insert_test();
     ba_remove_test();
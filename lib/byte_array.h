@@ -114,6 +114,23 @@ Sets array element at index to value.
 void ba_set(Array array, int index, Byte value);
 #endif
 
+/**
+Appends value at the end of the array. Takes amortized constant time.
+@param[in,out] array Byte array
+@param[in] value value to append
+@see a_push, a_reserve
+*/
+void ba_push(Array array, Byte value);
+
+/**
+Removes the last element of the array and returns it.
+@param[in,out] array Byte array
+@return the removed element
+@pre "not empty", length > 0
+@see a_pop
+*/
+Byte ba_pop(Array array);
+
 /**
 Prints the array.
 @param[in] array Byte array
@@ -224,6 +241,15 @@ Sorts the elements in increasing order. The input array is modified.
 */
 void ba_sort(Array array);
 
+/**
+Sorts the elements array[from, to) in increasing order. The other elements are not touched. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array Byte array
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+@see a_view
+*/
+void ba_sort_from_to(Array array, int from, int to);
+
 /**
 Sorts the elements in decreasing order.The input array is modified.
 @param[in,out] array Byte array
@@ -7,6 +7,8 @@
 #include <stdarg.h>
 #include "array.h"
 #include "double_array.h"
+#include "array_sort.h"
+#include <stdint.h> // int64_t
 
 static void da_create_test(void) {
     printsln((String)__func__);
@@ -35,14 +37,11 @@ static void da_create_test(void) {
 
 Array da_create(int n, double init) {
     require("non-negative length", n >= 0);
-    double *a = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = init;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = a;
     return result;
 }
 
@@ -105,16 +104,13 @@ Array da_range(double a, double b, double step) {
             n++;
         }
     }
-    double *arr = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *arr = result->a;
     double x = a;
     for (int i = 0; i < n; i++) {
         arr[i] = x;
         x += step;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = arr;
     
     return result;
 }
@@ -216,7 +212,8 @@ Array da_of_string(String s) {
     }
 
     // n ints found
-    double *a = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *a = result->a;
     t = s;
     int i = 0;
     while (*t != '\0') {
@@ -231,10 +228,6 @@ Array da_of_string(String s) {
         }
     }
 
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = a;
     return result;
 }
 
@@ -266,14 +259,11 @@ static void da_fn_test(void) {
 Array da_fn(int n, IntDoubleToDouble init, double x) {
     require("non-negative length", n >= 0);
     require_not_null(init);
-    double *a = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = init(i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = a;
     return result;
 }
 
@@ -318,6 +308,7 @@ void da_set(Array array, int i, double v) {
     require_not_null(array);
     require_element_size_double(array);
     require_x("index in range", i >= 0 && i < array->n, "index == %d, length == %d", i, array->n);
+    a_unshare(array);
     double *a = array->a;
     a[i] = v;
 }
@@ -328,11 +319,43 @@ void da_inc(Array array, int i, double v) {
     require_not_null(array);
     require_element_size_double(array);
     require_x("index in range", i >= 0 && i < array->n, "index == %d, length == %d", i, array->n);
+    a_unshare(array);
     double *a = array->a;
     a[i] += v;
 }
 #endif
 
+static void da_push_pop_test(void) {
+    printsln((String)__func__);
+    Array a = da_create(0, 0);
+    for (int i = 0; i < 1000; i++) {
+        da_push(a, 0.5 * i);
+    }
+    test_equal_i(a_length(a), 1000);
+    test_within_d(da_get(a, 999), 499.5, EPSILON);
+    test_within_d(da_pop(a), 499.5, EPSILON);
+    test_within_d(da_pop(a), 499.0, EPSILON);
+    test_equal_i(a_length(a), 998);
+    a_free(a);
+}
+
+void da_push(Array array, double value) {
+    require_not_null(array);
+    require_element_size_double(array);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    double *a = array->a;
+    a[array->n++] = value;
+}
+
+double da_pop(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    require("not empty", array->n > 0);
+    double *a = array->a;
+    return a[--array->n];
+}
+
 void da_print(Array array) {
     require_not_null(array);
     require_element_size_double(array);
@@ -369,13 +392,7 @@ bool da_contains(Array array, double value, double epsilon) {
     require_not_null(array);
     require_element_size_double(array);
     require("positive", epsilon > 0);
-    double *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (fabs(a[i] - value) < epsilon) {
-            return true;
-        }
-    }
-    return false;
+    return a_index_double(array->a, array->n, value, epsilon) >= 0;
 }
 
 static void da_fill_test(void) {
@@ -404,6 +421,7 @@ static void da_fill_test(void) {
 void da_fill(Array array, double value) {
     require_not_null(array);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = value;
@@ -466,6 +484,7 @@ static void da_fill_from_to_test(void) {
 void da_fill_from_to(Array array, double value, int from, int to) {
     require_not_null(array);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
     if (from < 0) from = 0;
     if (to > array->n) to = array->n;
@@ -503,13 +522,7 @@ int da_index(Array array, double value, double epsilon) {
     require_not_null(array);
     require_element_size_double(array);
     require("positive", epsilon > 0);
-    double *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (fabs(a[i] - value) < epsilon) {
-            return i;
-        }
-    }
-    return -1;
+    return a_index_double(array->a, array->n, value, epsilon);
 }
 
 static void da_index_from_test(void) {
@@ -528,14 +541,10 @@ int da_index_from(Array array, double value, int from, double epsilon) {
     require_not_null(array);
     require_element_size_double(array);
     require("positive", epsilon > 0);
-    double *a = array->a;
     if (from < 0) from = 0;
-    for (int i = from; i < array->n; i++) {
-        if (fabs(a[i] - value) < epsilon) {
-            return i;
-        }
-    }
-    return -1;
+    if (from >= array->n) return -1;
+    int i = a_index_double((double*)array->a + from, array->n - from, value, epsilon);
+    return i < 0 ? -1 : from + i;
 }
 
 static void da_index_fn_test(void) {
@@ -660,20 +669,107 @@ static void da_sort_test(void) {
     da_test_within(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN_DOUBLE elements are radix sorted
+    ac = da_range(100, -100, 1);
+    ex = da_range(-99, 101, 1);
+    da_sort(ac);
+    da_test_within(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
-static CmpResult double_compare(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    double x = *(double*)a;
-    double y = *(double*)b;
-    return (x == y) ? EQ : (x < y ? LT : GT);
+static inline bool double_less(const double *x, const double *y) {
+    return *x < *y;
 }
 
+A_SORT_DEFINE(double_sort, double, double_less)
+
 void da_sort(Array array) {
     require_not_null(array);
     require_element_size_double(array);
-    qsort(array->a, array->n, sizeof(double), double_compare);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN_DOUBLE) {
+        a_radix_sort_double(array->a, array->n, false);
+    } else {
+        double_sort_n(array->a, array->n);
+    }
+}
+
+static void da_sort_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = da_of_string("5, 4, 3, 2, 1");
+    Array ex = da_of_string("5, 2, 3, 4, 1");
+    da_sort_from_to(ac, 1, 4);
+    da_test_within(ac, ex);
+    a_free(ac);
+    a_free(ex);
+}
+
+void da_sort_from_to(Array array, int from, int to) {
+    require_not_null(array);
+    require_element_size_double(array);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    if (from < to) {
+        double *a = array->a;
+        if (to - from >= A_RADIX_SORT_MIN_DOUBLE) {
+            a_radix_sort_double(a + from, to - from, false);
+        } else {
+            double_sort_n(a + from, to - from);
+        }
+    }
+}
+
+static void double_sort_range(Any a, int n, int s, Comparator c) {
+    if (n >= A_RADIX_SORT_MIN_DOUBLE) {
+        a_radix_sort_double(a, n, false);
+    } else {
+        double_sort_n(a, n);
+    }
+}
+
+// Orders like the radix sort: -0.0 before 0.0, NaNs with the sign bit set 
+// first and the others last. Each thread of da_sort_parallel gets at least 
+// A_SORT_PARALLEL_MIN elements, which are radix sorted, so the merged 
+// result is the same as that of da_sort.
+static inline bool double_key_less(const double *x, const double *y) {
+    int64_t a, b;
+    memcpy(&a, x, sizeof(a));
+    memcpy(&b, y, sizeof(b));
+    if (a < 0) a ^= INT64_MAX;
+    if (b < 0) b ^= INT64_MAX;
+    return a < b;
+}
+
+A_MERGE_DEFINE(double_merge, double, double_key_less)
+
+static const ASortParallel double_sort_parallel = { double_sort_range, double_merge_split, double_merge_merge };
+
+static void da_sort_parallel_test(void) {
+    printsln((String)__func__);
+    int n = 4 * A_SORT_PARALLEL_MIN + 3;
+    Array input = da_create(n, 0);
+    for (int i = 0; i < n; i++) {
+        da_set(input, i, i % 100 == 0 ? -0.0 : d_rnd(2.0) - 1.0);
+    }
+    Array ex = a_copy(input);
+    da_sort(ex);
+    for (int threads = 0; threads <= 5; threads++) {
+        Array ac = a_copy(input);
+        da_sort_parallel(ac, threads);
+        test_equal_b(memcmp(ac->a, ex->a, (size_t)n * sizeof(double)) == 0, true);
+        a_free(ac);
+    }
+    a_free(input);
+    a_free(ex);
+}
+
+void da_sort_parallel(Array array, int threads) {
+    require_not_null(array);
+    require_element_size_double(array);
+    a_sort_parallel_with(array, NULL, threads, &double_sort_parallel);
 }
 
 static void da_sort_dec_test(void) {
@@ -707,20 +803,31 @@ static void da_sort_dec_test(void) {
     da_test_within(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN_DOUBLE elements are radix sorted
+    ac = da_range(-100, 100, 1);
+    ex = da_range(99, -101, 1);
+    da_sort_dec(ac);
+    da_test_within(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
-static CmpResult double_compare_dec(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    double x = *(double*)b;
-    double y = *(double*)a;
-    return (x == y) ? EQ : (x < y ? LT : GT);
+static inline bool double_greater(const double *x, const double *y) {
+    return *x > *y;
 }
 
+A_SORT_DEFINE(double_sort_dec, double, double_greater)
+
 void da_sort_dec(Array array) {
     require_not_null(array);
     require_element_size_double(array);
-    qsort(array->a, array->n, sizeof(double), double_compare_dec);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN_DOUBLE) {
+        a_radix_sort_double(array->a, array->n, true);
+    } else {
+        double_sort_dec_n(array->a, array->n);
+    }
 }
 
 #if 0
@@ -776,6 +883,7 @@ static void da_insert_test(void) {
 void da_insert(Array array, int i, double v) {
     require_not_null(array);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
     if (i < 0 || i >= array->n) return;
     // make space at i
@@ -845,6 +953,7 @@ static void da_remove_test(void) {
 void da_remove(Array array, int i, double v) {
     require_not_null(array);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
     if (i < 0 || i >= array->n) return;
     // shift down, starting from i
@@ -935,7 +1044,12 @@ void da_each(Array array, DoubleIntDoubleToDouble f, double x) {
     require_not_null(array);
     require_not_null(f);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
+    if (f == da_times) {
+        a_times_double(a, array->n, x, a);
+        return;
+    }
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x);
     }
@@ -947,6 +1061,7 @@ void da_each_state(Array array, DoubleIntDoubleAnyToDouble f, double x, Any stat
     require_not_null(array);
     require_not_null(f);
     require_element_size_double(array);
+    a_unshare(array);
     double *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x, state);
@@ -960,14 +1075,15 @@ Array da_map(Array array, DoubleIntDoubleToDouble f, double x) {
     require_not_null(f);
     require_element_size_double(array);
     double *a = array->a;
-    double *b = xmalloc(array->n * sizeof(double));
+    Array result = a_alloc(array->n, sizeof(double), false);
+    double *b = result->a;
+    if (f == da_times) {
+        a_times_double(a, array->n, x, b);
+        return result;
+    }
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(double);
-    result->a = b;
     return result;
 }
 
@@ -978,14 +1094,11 @@ Array da_map_state(Array array, DoubleIntDoubleAnyToDouble f, double x, Any stat
     require_not_null(f);
     require_element_size_double(array);
     double *a = array->a;
-    double *b = xmalloc(array->n * sizeof(double));
+    Array result = a_alloc(array->n, sizeof(double), false);
+    double *b = result->a;
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x, state);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(double);
-    result->a = b;
     return result;
 }
 
@@ -1007,6 +1120,26 @@ double da_foldl(Array array, DoubleDoubleIntToDouble f, double init) {
     require_not_null(f);
     require_element_size_double(array);
     double *a = array->a;
+    // the builtins are applied in the same order as by calling f, with the 
+    // same result, but without the call per element
+    if (f == double_plus) {
+        for (int i = 0; i < array->n; i++) {
+            init += a[i];
+        }
+        return init;
+    }
+    if (f == double_minus) {
+        for (int i = 0; i < array->n; i++) {
+            init -= a[i];
+        }
+        return init;
+    }
+    if (f == double_mult) {
+        for (int i = 0; i < array->n; i++) {
+            init *= a[i];
+        }
+        return init;
+    }
     for (int i = 0; i < array->n; i++) {
         init = f(init, a[i], i);
     }
@@ -1031,12 +1164,134 @@ double da_foldr(Array array, DoubleDoubleIntToDouble f, double init) {
     require_not_null(f);
     require_element_size_double(array);
     double *a = array->a;
+    if (f == double_plus) {
+        for (int i = array->n - 1; i >= 0; i--) {
+            init = a[i] + init;
+        }
+        return init;
+    }
+    if (f == double_mult) {
+        for (int i = array->n - 1; i >= 0; i--) {
+            init = a[i] * init;
+        }
+        return init;
+    }
     for (int i = array->n - 1; i >= 0; i--) {
         init = f(a[i], init, i);
     }
     return init;
 }
 
+static void da_reductions_test(void) {
+    printsln((String)__func__);
+    Array a = da_of_string("3, -1, 4, -1, 5, 9, 2, 6");
+    Array b = da_of_string("1, 2, 3, 4, 5, 6, 7, 8");
+    test_within_d(da_sum(a), 27, EPSILON);
+    test_within_d(da_sum_fast(a), 27, EPSILON);
+    test_within_d(da_min(a), -1, EPSILON);
+    test_equal_i(da_min_index(a), 1);
+    test_within_d(da_max(a), 9, EPSILON);
+    test_equal_i(da_max_index(a), 5);
+    test_within_d(da_mean(a), 27.0 / 8, EPSILON);
+    double m = 27.0 / 8, v = 0;
+    for (int i = 0; i < 8; i++) v += (da_get(a, i) - m) * (da_get(a, i) - m);
+    test_within_d(da_variance(a), v / 8, EPSILON);
+    test_within_d(da_dot(a, b), 3 - 2 + 12 - 4 + 25 + 54 + 14 + 48, EPSILON);
+    test_within_d(da_norm(b), sqrt(204), EPSILON);
+    a_free(a);
+    a_free(b);
+
+    // NaNs are skipped by min and max
+    a = da_of_string("2, 1, 3");
+    da_set(a, 0, NAN);
+    test_equal_i(da_min_index(a), 1);
+    test_equal_i(da_max_index(a), 2);
+    test_equal_b(isnan(da_sum(a)), true);
+    a_free(a);
+
+    // compensated summation
+    a = da_create(1001, 1e-16);
+    da_set(a, 0, 1.0);
+    test_equal_b(da_sum(a) == 1.0 + 1000e-16, true);
+    test_within_d(da_sum_fast(a), 1.0 + 1000e-16, 1e-12); // loses some of the small values
+    a_free(a);
+
+    a = da_create(0, 0);
+    test_within_d(da_sum(a), 0, EPSILON);
+    test_equal_i(da_min_index(a), -1);
+    test_equal_i(da_max_index(a), -1);
+    a_free(a);
+}
+
+double da_sum(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    return a_sum_double(array->a, array->n);
+}
+
+double da_sum_fast(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    return a_sum_double_fast(array->a, array->n);
+}
+
+double da_min(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    int i = a_min_index_double(array->a, array->n);
+    require("not empty and not only NaNs", i >= 0);
+    double *a = array->a;
+    return a[i];
+}
+
+int da_min_index(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    return a_min_index_double(array->a, array->n);
+}
+
+double da_max(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    int i = a_max_index_double(array->a, array->n);
+    require("not empty and not only NaNs", i >= 0);
+    double *a = array->a;
+    return a[i];
+}
+
+int da_max_index(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    return a_max_index_double(array->a, array->n);
+}
+
+double da_mean(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    require("not empty", array->n > 0);
+    return a_sum_double(array->a, array->n) / array->n;
+}
+
+double da_variance(Array array) {
+    double mean = da_mean(array);
+    return a_squares_double(array->a, array->n, mean) / array->n;
+}
+
+double da_dot(Array a, Array b) {
+    require_not_null(a);
+    require_not_null(b);
+    require_element_size_double(a);
+    require_element_size_double(b);
+    require_x("same length", a->n == b->n, "a->n == %d, b->n == %d", a->n, b->n);
+    return a_dot_double(a->a, b->a, a->n);
+}
+
+double da_norm(Array array) {
+    require_not_null(array);
+    require_element_size_double(array);
+    return sqrt(a_dot_double(array->a, array->a, array->n));
+}
+
 static void da_filter_test(void) {
     printsln((String)__func__);
     Array a, ac, ex;
@@ -1062,10 +1317,27 @@ static void da_filter_test(void) {
     a_free(a);
 }
 
+// Finds the comparison of a builtin predicate. Returns false for other predicates.
+static bool da_builtin_compare(DoubleIntDoubleToBool predicate, ACompare *op) {
+    if (predicate == da_gt) *op = A_GT;
+    else if (predicate == da_ge) *op = A_GE;
+    else if (predicate == da_lt) *op = A_LT;
+    else if (predicate == da_le) *op = A_LE;
+    else return false;
+    return true;
+}
+
 Array da_filter(Array array, DoubleIntDoubleToBool predicate, double x) {
     require_not_null(array);
     require_not_null(predicate);
     require_element_size_double(array);
+    ACompare op;
+    if (da_builtin_compare(predicate, &op)) {
+        int n = a_count_double(array->a, array->n, op, x);
+        Array result = a_alloc(n, sizeof(double), false);
+        a_select_double(array->a, op, x, result->a, n);
+        return result;
+    }
     bool *ps = xmalloc(array->n * sizeof(bool));
     int n = 0;
     double *a = array->a;
@@ -1073,20 +1345,90 @@ Array da_filter(Array array, DoubleIntDoubleToBool predicate, double x) {
         ps[i] = predicate(a[i], i, x);
         if (ps[i]) n++;
     }
-    double *b = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = b;    
     return result;
 }
 
+// The same as the builtin predicates and functions, but not recognized by 
+// da_filter, da_map, etc.
+static bool da_gt_user(double value, int index, double x) { return value > x; }
+static bool da_ge_user(double value, int index, double x) { return value >= x; }
+static bool da_lt_user(double value, int index, double x) { return value < x; }
+static bool da_le_user(double value, int index, double x) { return value <= x; }
+static double da_times_user(double value, int index, double x) { return value * x; }
+static double double_plus_user(double x, double y, int index) { return x + y; }
+static double double_minus_user(double x, double y, int index) { return x - y; }
+static double double_mult_user(double x, double y, int index) { return x * y; }
+
+static void da_builtins_test(void) {
+    printsln((String)__func__);
+    DoubleIntDoubleToBool builtin[] = { da_gt, da_ge, da_lt, da_le };
+    DoubleIntDoubleToBool user[] = { da_gt_user, da_ge_user, da_lt_user, da_le_user };
+    Array a = da_create(0, 0);
+    bool ok = true;
+    for (int n = 0; n <= 40; n++) {
+        for (int k = 0; k < 4; k++) {
+            Array ac = da_filter(a, builtin[k], 0.5);
+            Array ex = da_filter(a, user[k], 0.5);
+            ok = ok && a_length(ac) == a_length(ex) && memcmp(ac->a, ex->a, a_length(ac) * sizeof(double)) == 0;
+            a_free(ac);
+            a_free(ex);
+        }
+        Array ac = da_map(a, da_times, 0.1);
+        Array ex = da_map(a, da_times_user, 0.1);
+        ok = ok && memcmp(ac->a, ex->a, n * sizeof(double)) == 0;
+        da_each(ac, da_times, -3.0);
+        da_each(ex, da_times_user, -3.0);
+        ok = ok && memcmp(ac->a, ex->a, n * sizeof(double)) == 0;
+        a_free(ac);
+        a_free(ex);
+        double p = da_foldl(a, double_mult, 0.5), q = da_foldl(a, double_mult_user, 0.5);
+        ok = ok && memcmp(&p, &q, sizeof(double)) == 0;
+        p = da_foldr(a, double_mult, 0.5);
+        q = da_foldr(a, double_mult_user, 0.5);
+        ok = ok && memcmp(&p, &q, sizeof(double)) == 0;
+        p = da_foldl(a, double_plus, 0.5);
+        q = da_foldl(a, double_plus_user, 0.5);
+        ok = ok && memcmp(&p, &q, sizeof(double)) == 0;
+        p = da_foldl(a, double_minus, 0.5);
+        q = da_foldl(a, double_minus_user, 0.5);
+        ok = ok && memcmp(&p, &q, sizeof(double)) == 0;
+        p = da_foldr(a, double_plus, 0.5);
+        q = da_foldr(a, double_plus_user, 0.5);
+        ok = ok && memcmp(&p, &q, sizeof(double)) == 0;
+        da_push(a, n % 9 == 4 ? NAN : d_rnd(2.0) - 0.5);
+    }
+    test_equal_b(ok, true);
+    a_free(a);
+
+    // infinities
+    a = da_of_string("1, 2, 3");
+    da_set(a, 1, INFINITY);
+    test_equal_b(da_foldl(a, double_plus, 0) == INFINITY, true);
+    test_equal_b(da_foldl(a, double_minus, 0) == -INFINITY, true);
+    test_equal_b(da_foldr(a, double_plus, 0) == INFINITY, true);
+    test_equal_b(da_sum(a) == INFINITY, true);
+    test_equal_b(da_mean(a) == INFINITY, true);
+    a_free(a);
+
+    // NaN satisfies no comparison
+    a = da_of_string("1, 2, 3");
+    da_set(a, 1, NAN);
+    Array ac = da_filter(a, da_ge, 0);
+    Array ex = da_of_string("1, 3");
+    da_test_within(ac, ex);
+    a_free(ac);
+    a_free(ex);
+    a_free(a);
+}
+
 // @todo: add tests
 Array da_filter_state(Array array, DoubleIntDoubleAnyToBool predicate, double x, Any state) {
     require_not_null(array);
@@ -1099,17 +1441,14 @@ Array da_filter_state(Array array, DoubleIntDoubleAnyToBool predicate, double x,
         ps[i] = predicate(a[i], i, x, state);
         if (ps[i]) n++;
     }
-    double *b = xmalloc(n * sizeof(double));
+    Array result = a_alloc(n, sizeof(double), false);
+    double *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(double);
-    result->a = b;    
     return result;
 }
 
@@ -1281,6 +1620,7 @@ DoubleOption da_index_option(Array array, double value, double epsilon) {
 
 void da_test_all(void) {
     da_create_test();
+    da_push_pop_test();
     da_range_test();
     da_of_string_test();
     da_fn_test();
@@ -1295,13 +1635,17 @@ void da_test_all(void) {
     da_last_index_from_test();
     da_last_index_fn_test();
     da_sort_test();
+    da_sort_from_to_test();
+    da_sort_parallel_test();
     da_sort_dec_test();
 //    da_insert_test();
 //    da_remove_test();
     da_each_test();
     da_foldl_test();
     da_foldr_test();
+    da_reductions_test();
     da_filter_test();
+    da_builtins_test();
     da_exists_test();
     da_forall_test();
     da_index_option_test();
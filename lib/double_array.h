@@ -119,6 +119,23 @@ Increments array element at index by value. Avoids common pattern: set(a, i, get
 void da_inc(Array array, int index, double value);
 #endif
 
+/**
+Appends value at the end of the array. Takes amortized constant time.
+@param[in,out] array double array
+@param[in] value value to append
+@see a_push, a_reserve
+*/
+void da_push(Array array, double value);
+
+/**
+Removes the last element of the array and returns it.
+@param[in,out] array double array
+@return the removed element
+@pre "not empty", length > 0
+@see a_pop
+*/
+double da_pop(Array array);
+
 /**
 Prints the array.
 @param[in] array double array
@@ -239,6 +256,23 @@ Sorts the elements in increasing order. The input array is modified.
 */
 void da_sort(Array array);
 
+/**
+Sorts the elements array[from, to) in increasing order. The other elements are not touched. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array double array
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+@see a_view
+*/
+void da_sort_from_to(Array array, int from, int to);
+
+/**
+Sorts the elements in increasing order with the given number of threads. The result is the same as that of @ref da_sort, bit for bit (e.g., -0.0 before 0.0). Each thread sorts a range of the array, then the ranges are merged (see @ref a_sort_parallel). Arrays of less than 2 * @ref A_SORT_PARALLEL_MIN elements are sorted by the calling thread alone. The input array is modified.
+@param[in,out] array double array
+@param[in] threads number of threads, 0 for one per processor
+@pre "non-negative thread count", threads >= 0
+*/
+void da_sort_parallel(Array array, int threads);
+
 /**
 Sorts the elements in decreasing order. The input array is modified.
 @param[in,out] array double array
@@ -278,6 +312,8 @@ double f(double element, int index, double x) {}
 @param[in] f a function that is called for each element of input array
 @param[in] x provided to each invocation of f
 
+If f is @ref da_times, the array is multiplied by x in a vectorized loop, without calling f.
+
 <b>Step by step:</b><br/>
 array[0] := f(array[0], 0, x)<br/>
 array[1] := f(array[1], 1, x)<br/>
@@ -318,6 +354,8 @@ double f(double element, int index, double x) {}
 @param[in] f transformation function, called for each element of input array
 @param[in] x provided to each invocation of f
 @return the mapped array
+
+If f is @ref da_times, the elements are multiplied by x in a vectorized loop, without calling f.
 */
 Array da_map(Array array, DoubleIntDoubleToDouble f, double x);
 
@@ -348,6 +386,8 @@ double f(double state, double element, int index) {}
 @param[in] state provided to each invocation of f
 @return the accumulated state
 
+If f is @ref double_plus, @ref double_minus, or @ref double_mult, the loop does not call f. The result is the same as with calling f, for a sum that is more precise see @ref da_sum.
+
 <b>Step by step:</b><br/>
 state := f(state, array[0], 0)<br/>
 state := f(state, array[1], 1)<br/>
@@ -368,6 +408,8 @@ int f(int element, int state, int index) {}
 @param[in] state provided to each invocation of f
 @return the accumulated state
 
+If f is @ref double_plus or @ref double_mult, the loop does not call f. The result is the same as with calling f.
+
 <b>Step by step:</b><br/>
 state := f(array[n-1], state, n-1)<br/>
 ... <br/>
@@ -376,6 +418,83 @@ state := f(array[0], state, 0)
 */
 double da_foldr(Array array, DoubleDoubleIntToDouble f, double state);
 
+/**
+Returns the sum of the elements. Uses compensated (Kahan) summation in a fixed order, so the result is accurate (the error does not grow with the length of the array) and the same on any CPU, with or without vector instructions. Vectorized (AVX2 or SSE2, chosen at runtime).
+@param[in] array double array
+@return the sum, 0 for an empty array
+@see da_sum_fast
+*/
+double da_sum(Array array);
+
+/**
+Returns the sum of the elements without compensation. About twice as fast as @ref da_sum if the array is in the cache, but the rounding error grows with the length of the array and the result may differ in the last bits between CPUs.
+@param[in] array double array
+@return the sum, 0 for an empty array
+*/
+double da_sum_fast(Array array);
+
+/**
+Returns the smallest element. NaNs are skipped.
+@param[in] array double array
+@return the smallest element
+@pre "not empty and not only NaNs", da_min_index(array) >= 0
+*/
+double da_min(Array array);
+
+/**
+Returns the index of the smallest element. If there are several, the index of the first one. NaNs are skipped. Vectorized like @ref da_sum.
+@param[in] array double array
+@return the index of the smallest element, -1 for an empty array or an array of NaNs
+*/
+int da_min_index(Array array);
+
+/**
+Returns the largest element. NaNs are skipped.
+@param[in] array double array
+@return the largest element
+@pre "not empty and not only NaNs", da_max_index(array) >= 0
+*/
+double da_max(Array array);
+
+/**
+Returns the index of the largest element. If there are several, the index of the first one. NaNs are skipped. Vectorized like @ref da_sum.
+@param[in] array double array
+@return the index of the largest element, -1 for an empty array or an array of NaNs
+*/
+int da_max_index(Array array);
+
+/**
+Returns the mean of the elements, using @ref da_sum.
+@param[in] array double array
+@return the mean
+@pre "not empty", a_length(array) > 0
+*/
+double da_mean(Array array);
+
+/**
+Returns the (population) variance of the elements, i.e., the mean of the squared deviations from the mean. Takes two passes over the array, which avoids the cancellation of the one-pass formula. The result is the same on any CPU.
+@param[in] array double array
+@return the variance
+@pre "not empty", a_length(array) > 0
+*/
+double da_variance(Array array);
+
+/**
+Returns the dot product of a and b, i.e., the sum of a[i] * b[i]. The products are summed in a fixed order, so the result is the same on any CPU.
+@param[in] a double array
+@param[in] b double array
+@return the dot product
+@pre "same length", a_length(a) == a_length(b)
+*/
+double da_dot(Array a, Array b);
+
+/**
+Returns the Euclidean (L2) norm of the elements, i.e., the square root of the sum of their squares.
+@param[in] array double array
+@return the norm
+*/
+double da_norm(Array array);
+
 /**
 Predicates
 */
@@ -408,6 +527,8 @@ bool predicate(double element, int index, double x) {}
 @param[in] predicate predicate function, returns true iff element should be included
 @param[in] x given to each invocation of predicate
 @return filtered array
+
+If predicate is @ref da_gt, @ref da_ge, @ref da_lt, or @ref da_le, the elements are compared to x in a vectorized loop, without calling predicate and without a temporary array.
 */
 Array da_filter(Array array, DoubleIntDoubleToBool predicate, double x);
 
@@ -267,40 +267,22 @@ List dl_of_il(List list) {
 double dl_get(List list, int index) {
     require_not_null(list);
     require_element_size_double(list);
-    int i = 0;
-    for (DoubleListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            return node->value;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
-    return 0;
+    DoubleListNode *node = l_node_at(list, index);
+    return node->value;
 }
 
 void dl_set(List list, int index, double value) {
     require_not_null(list);
     require_element_size_double(list);
-    int i = 0;
-    for (DoubleListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value = value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    DoubleListNode *node = l_node_at(list, index);
+    node->value = value;
 }
 
 void dl_inc(List list, int index, double value) {
     require_not_null(list);
     require_element_size_double(list);
-    int i = 0;
-    for (DoubleListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value += value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    DoubleListNode *node = l_node_at(list, index);
+    node->value += value;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -370,7 +352,7 @@ void dl_append(List list, double value) {
     require_not_null(list);
     require_element_size_double(list);
     // allocate memory for next-pointer and content
-    DoubleListNode *node = xcalloc(1, sizeof(DoubleListNode));
+    DoubleListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     // if this is the first element of the list set first pointer
@@ -384,13 +366,14 @@ void dl_append(List list, double value) {
     }
     // the new node is the last node of the list
     list->last = node;
+    list->n++;
 }
 
 void dl_prepend(List list, double value) {
     require_not_null(list);
     require_element_size_double(list);
     // allocate memory for next-pointer and content
-    DoubleListNode *node = xcalloc(1, sizeof(DoubleListNode));
+    DoubleListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     node->next = list->first;
@@ -398,6 +381,8 @@ void dl_prepend(List list, double value) {
     if (list->last == NULL) {
         list->last = node;
     }
+    list->n++;
+    list->cursor_index++;
 }
 
 void dl_print(List list) {
@@ -765,6 +750,41 @@ List dl_sort_dec(List list) {
 	return result;
 }
 
+void dl_sort_inplace(List list);
+
+static void dl_sort_inplace_test(void) {
+    printsln((String)__func__);
+    List ac, ex;
+
+    ac = dl_of_string("5, 4, 3, 2, 1");
+    ex = dl_of_string("1, 2, 3, 4, 5, 6");
+    dl_sort_inplace(ac);
+    dl_append(ac, 6);
+    dl_test_within(ac, ex);
+    l_free(ac);
+    l_free(ex);
+
+    ac = dl_of_string("1.5, 2, 1.5, -3, 2");
+    ex = dl_of_string("-3, 1.5, 1.5, 2, 2");
+    dl_sort_inplace(ac);
+    dl_test_within(ac, ex);
+    l_free(ac);
+    l_free(ex);
+
+    ac = dl_of_string("");
+    ex = dl_of_string("");
+    dl_sort_inplace(ac);
+    dl_test_within(ac, ex);
+    l_free(ac);
+    l_free(ex);
+}
+
+void dl_sort_inplace(List list) {
+    require_not_null(list);
+    require_element_size_double(list);
+    l_sort_inplace(list, double_compare);
+}
+
 static void dl_insert_test(void) {
     printsln((String)__func__);
     List ac, ex;
@@ -815,23 +835,7 @@ static void dl_insert_test(void) {
 void dl_insert(List list, int index, double value) {
     require_not_null(list);
     require_element_size_double(list);
-    if (index <= 0) {
-        dl_prepend(list, value);
-        return;
-    }
-    // assert: index > 0
-    DoubleListNode *node = list->first;
-    int k = 1;
-    while (node != NULL && k < index) {
-        node = node->next;
-        k++;
-    }
-    if (node != NULL) {
-        DoubleListNode *new_node = xcalloc(1, sizeof(DoubleListNode));
-		new_node->value = value;
-        new_node->next = node->next;
-        node->next = new_node;
-    }
+    l_insert(list, index, &value);
 }
 
 static void dl_remove_test(void) {
@@ -1351,6 +1355,11 @@ bool dl_test_within_file_line(const char *file, const char *function, int line,
         printf("%s, line %d: Actual and expected lengths differ\n", file, line);
         return false;
     }
+    if (a->n != i || e->n != i) {
+        printf("%s, line %d: Length %d differs from the number of nodes %d\n", 
+                file, line, a->n != i ? a->n : e->n, i);
+        return false;
+    }
     printf("%s, line %d: Check passed.\n", file, line);
     base_count_success();
     return true;
@@ -1376,6 +1385,7 @@ void dl_test_all(void) {
     dl_index_fn_test();
     dl_sort_test();
     dl_sort_dec_test();
+    dl_sort_inplace_test();
     dl_insert_test();
     dl_remove_test();
     dl_each_test();
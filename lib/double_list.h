@@ -102,7 +102,7 @@ The input list is not modified.
 List dl_of_il(List list);
 
 /**
-Returns list element at index.
+Returns list element at index. Accessing the elements in order takes amortized constant time per element (see @ref l_get).
 @param[in] list double list
 @param[in] index index of list element to return
 @return list element
@@ -250,6 +250,13 @@ Creates a new list. Does not modify the original list.
 */
 List dl_sort_dec(List list);
 
+/**
+Sorts the elements in increasing order in place. Equal elements keep their relative order (stable sort).
+Does not create a new list, the nodes are relinked (see @ref l_sort_inplace).
+@param[in,out] list double list
+*/
+void dl_sort_inplace(List list);
+
 /**
 Inserts value at index in list. 
 Does nothing if index is not valid, i.e., if not in interval [0,n].
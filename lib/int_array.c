@@ -6,6 +6,8 @@
 
 #include "array.h"
 #include "int_array.h"
+#include "array_sort.h"
+#include <limits.h> // INT_MAX
 
 Array ia_create(int n, int init);
 
@@ -36,14 +38,11 @@ static void ia_create_test(void) {
 
 Array ia_create(int n, int value) {
     require("non-negative length", n >= 0);
-    int *a = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = value;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = a;
     return result;
 }
 
@@ -92,25 +91,19 @@ static void ia_range_test(void) {
 Array ia_range(int a, int b) {
     if (a <= b) {
         int n = b - a;
-        int *arr = xmalloc(n * sizeof(int));
+        Array result = a_alloc(n, sizeof(int), false);
+        int *arr = result->a;
         for (int i = 0; i < n; i++) {
             arr[i] = a + i;
         }
-        Array result = xmalloc(sizeof(ArrayHead));
-        result->n = n;
-        result->s = sizeof(int);
-        result->a = arr;
         return result;
     } else /* a > b */ {
         int n = a - b;
-        int *arr = xmalloc(n * sizeof(int));
+        Array result = a_alloc(n, sizeof(int), false);
+        int *arr = result->a;
         for (int i = 0; i < n; i++) {
             arr[i] = a - i;
         }
-        Array result = xmalloc(sizeof(ArrayHead));
-        result->n = n;
-        result->s = sizeof(int);
-        result->a = arr;
         return result;
     }
 }
@@ -205,7 +198,8 @@ Array ia_of_string(String s) {
     }
 
     // n ints found
-    int *a = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *a = result->a;
     t = s;
     int i = 0;
     while (*t != '\0') {
@@ -220,10 +214,6 @@ Array ia_of_string(String s) {
             t++; // not a digit, skip
         }
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = a;
     return result;
 }
 
@@ -262,14 +252,11 @@ static void ia_fn_test(void) {
 Array ia_fn(int n, IntIntToInt init, int x) {
     require("non-negative length", n >= 0);
     require_not_null(init);
-    int *a = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = init(i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = a;
     return result;
 }
 
@@ -318,6 +305,7 @@ void ia_set(Array array, int index, int value) {
     require_element_size_int(array);
     require_x("index in range", index >= 0 && index < array->n, 
             "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     int *a = array->a;
     a[index] = value;
 }
@@ -329,6 +317,7 @@ int ia_inc(Array array, int index, int value) {
     require_element_size_int(array);
     require_x("index in range", index >= 0 && index < array->n, 
             "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     int *a = array->a;
     value += a[index];
     a[index] = value;
@@ -336,6 +325,39 @@ int ia_inc(Array array, int index, int value) {
 }
 #endif
 
+static void ia_push_pop_test(void) {
+    printsln((String)__func__);
+    Array a = ia_create(0, 0);
+    for (int i = 0; i < 1000; i++) {
+        ia_push(a, i);
+    }
+    test_equal_i(a_length(a), 1000);
+    test_equal_i(ia_get(a, 999), 999);
+    test_equal_i(ia_pop(a), 999);
+    test_equal_i(ia_pop(a), 998);
+    test_equal_i(a_length(a), 998);
+    ia_push(a, -1);
+    test_equal_i(ia_get(a, 998), -1);
+    a_free(a);
+}
+
+void ia_push(Array array, int value) {
+    require_not_null(array);
+    require_element_size_int(array);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    int *a = array->a;
+    a[array->n++] = value;
+}
+
+int ia_pop(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    require("not empty", array->n > 0);
+    int *a = array->a;
+    return a[--array->n];
+}
+
 void ia_print(Array array) {
     require_not_null(array);
     require_element_size_int(array);
@@ -372,13 +394,7 @@ static void ia_contains_test(void) {
 bool ia_contains(Array array, int value) {
     require_not_null(array);
     require_element_size_int(array);
-    int *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (a[i] == value) {
-            return true;
-        }
-    }
-    return false;
+    return a_index_int(array->a, array->n, value) >= 0;
 }
 
 void ia_fill(Array array, int value);
@@ -409,6 +425,7 @@ static void ia_fill_test(void) {
 void ia_fill(Array array, int value) {
     require_not_null(array);
     require_element_size_int(array);
+    a_unshare(array);
     int *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = value;
@@ -473,6 +490,7 @@ static void ia_fill_from_to_test(void) {
 void ia_fill_from_to(Array array, int value, int from, int to) {
     require_not_null(array);
     require_element_size_int(array);
+    a_unshare(array);
     if (from < 0) from = 0;
     if (to > array->n) to = array->n;
     int *a = array->a;
@@ -511,13 +529,7 @@ static void ia_index_test(void) {
 int ia_index(Array array, int value) {
     require_not_null(array);
     require_element_size_int(array);
-    int *a = array->a;
-    for (int i = 0; i < array->n; i++) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    return a_index_int(array->a, array->n, value);
 }
 
 int ia_index_from(Array array, int value, int from);
@@ -538,13 +550,9 @@ int ia_index_from(Array array, int value, int from) {
     require_not_null(array);
     require_element_size_int(array);
     if (from < 0) from = 0;
-    int *a = array->a;
-    for (int i = from; i < array->n; i++) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    if (from >= array->n) return -1;
+    int i = a_index_int((int*)array->a + from, array->n - from, value);
+    return i < 0 ? -1 : from + i;
 }
 
 int ia_index_fn(Array array, IntIntIntToBool predicate, int x);
@@ -584,13 +592,7 @@ static void ia_last_index_test(void) {
 int ia_last_index(Array array, int value) {
     require_not_null(array);
     require_element_size_int(array);
-    int *a = array->a;
-    for (int i = array->n - 1; i >= 0; i--) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    return a_last_index_int(array->a, array->n, value);
 }
 
 int ia_last_index_from(Array array, int value, int from);
@@ -610,13 +612,8 @@ int ia_last_index_from(Array array, int value, int from) {
     require_not_null(array);
     require_element_size_int(array);
     if (from >= array->n) from = array->n - 1;
-    int *a = array->a;
-    for (int i = from; i >= 0; i--) {
-        if (a[i] == value) {
-            return i;
-        }
-    }
-    return -1;
+    if (from < 0) return -1;
+    return a_last_index_int(array->a, from + 1, value);
 }
 
 int ia_last_index_fn(Array array, IntIntIntToBool predicate, int x);
@@ -644,14 +641,12 @@ int ia_last_index_fn(Array array, IntIntIntToBool predicate, int x) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static CmpResult int_compare(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    int x = *(int*)a;
-    int y = *(int*)b;
-    return (x == y) ? 0 : (x < y ? -1 : 1);
+static inline bool int_less(const int *x, const int *y) {
+    return *x < *y;
 }
 
+A_SORT_DEFINE(int_sort, int, int_less)
+
 void ia_sort(Array array);
 
 static void ia_sort_test(void) {
@@ -686,22 +681,96 @@ static void ia_sort_test(void) {
     ia_test_equal(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN elements are radix sorted
+    ac = ia_range(500, -500);
+    ex = ia_range(-499, 501);
+    ia_sort(ac);
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
 void ia_sort(Array array) {
     require_not_null(array);
     require_element_size_int(array);
-    qsort(array->a, array->n, array->s, int_compare);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN) {
+        a_radix_sort_int(array->a, array->n, false);
+    } else {
+        int_sort_n(array->a, array->n);
+    }
 }
 
-static CmpResult int_compare_dec(ConstAny a, ConstAny b) {
-    require_not_null(a);
-    require_not_null(b);
-    int x = *(int*)b;
-    int y = *(int*)a;
-    return (x == y) ? 0 : (x < y ? -1 : 1);
+static void ia_sort_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = ia_of_string("5, 4, 3, 2, 1");
+    Array ex = ia_of_string("5, 2, 3, 4, 1");
+    ia_sort_from_to(ac, 1, 4);
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
+}
+
+void ia_sort_from_to(Array array, int from, int to) {
+    require_not_null(array);
+    require_element_size_int(array);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    if (from < to) {
+        int *a = array->a;
+        if (to - from >= A_RADIX_SORT_MIN) {
+            a_radix_sort_int(a + from, to - from, false);
+        } else {
+            int_sort_n(a + from, to - from);
+        }
+    }
+}
+
+static void int_sort_range(Any a, int n, int s, Comparator c) {
+    if (n >= A_RADIX_SORT_MIN) {
+        a_radix_sort_int(a, n, false);
+    } else {
+        int_sort_n(a, n);
+    }
+}
+
+A_MERGE_DEFINE(int_merge, int, int_less)
+
+static const ASortParallel int_sort_parallel = { int_sort_range, int_merge_split, int_merge_merge };
+
+static void ia_sort_parallel_test(void) {
+    printsln((String)__func__);
+    int n = 4 * A_SORT_PARALLEL_MIN + 3;
+    Array input = ia_create(n, 0);
+    for (int i = 0; i < n; i++) {
+        ia_set(input, i, i_rnd(2 * n) - n);
+    }
+    Array ex = a_copy(input);
+    ia_sort(ex);
+    for (int threads = 0; threads <= 5; threads++) {
+        Array ac = a_copy(input);
+        ia_sort_parallel(ac, threads);
+        ia_test_equal(ac, ex);
+        a_free(ac);
+    }
+    a_free(input);
+    a_free(ex);
+}
+
+void ia_sort_parallel(Array array, int threads) {
+    require_not_null(array);
+    require_element_size_int(array);
+    a_sort_parallel_with(array, NULL, threads, &int_sort_parallel);
+}
+
+static inline bool int_greater(const int *x, const int *y) {
+    return *x > *y;
 }
 
+A_SORT_DEFINE(int_sort_dec, int, int_greater)
+
 void ia_sort_dec(Array array);
 
 static void ia_sort_dec_test(void) {
@@ -736,12 +805,25 @@ static void ia_sort_dec_test(void) {
     ia_test_equal(ac, ex);
     a_free(ac);
     a_free(ex);
+
+    // arrays of at least A_RADIX_SORT_MIN elements are radix sorted
+    ac = ia_range(-500, 500);
+    ex = ia_range(499, -501);
+    ia_sort_dec(ac);
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
 }
 
 void ia_sort_dec(Array array) {
     require_not_null(array);
     require_element_size_int(array);
-    qsort(array->a, array->n, array->s, int_compare_dec);
+    a_unshare(array);
+    if (array->n >= A_RADIX_SORT_MIN) {
+        a_radix_sort_int(array->a, array->n, true);
+    } else {
+        int_sort_dec_n(array->a, array->n);
+    }
 }
 
 #if 0
@@ -797,6 +879,7 @@ static void ia_insert_test(void) {
 void ia_insert(Array array, int i, int v) {
     require_not_null(array);
     require_element_size_int(array);
+    a_unshare(array);
     if (i < 0 || i >= array->n) return;
     // make space at i
     int *a = array->a;
@@ -866,6 +949,7 @@ static void ia_remove_test(void) {
 void ia_remove(Array array, int i, int v) {
     require_not_null(array);
     require_element_size_int(array);
+    a_unshare(array);
     if (i < 0 || i >= array->n) return;
     // shift down, starting from i
     int *a = array->a;
@@ -978,7 +1062,12 @@ void ia_each(Array array, IntIntIntToInt f, int x) {
     require_not_null(array);
     require_element_size_int(array);
     require_not_null(f);
+    a_unshare(array);
     int *a = array->a;
+    if (f == ia_times) {
+        a_times_int(a, array->n, x, a);
+        return;
+    }
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x);
     }
@@ -995,6 +1084,7 @@ void ia_each_state(Array array, IntIntIntAnyToInt f, int x, Any state) {
     require_not_null(array);
     require_element_size_int(array);
     require_not_null(f);
+    a_unshare(array);
     int *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x, state);
@@ -1007,14 +1097,15 @@ Array ia_map(Array array, IntIntIntToInt f, int x) {
     require_element_size_int(array);
     require_not_null(f);
     int *a = array->a;
-    int *b = xmalloc(array->n * sizeof(int));
+    Array result = a_alloc(array->n, sizeof(int), false);
+    int *b = result->a;
+    if (f == ia_times) {
+        a_times_int(a, array->n, x, b);
+        return result;
+    }
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(int);
-    result->a = b;
     return result;
 }
 
@@ -1024,14 +1115,11 @@ Array ia_map_state(Array array, IntIntIntAnyToInt f, int x, Any state) {
     require_element_size_int(array);
     require_not_null(f);
     int *a = array->a;
-    int *b = xmalloc(array->n * sizeof(int));
+    Array result = a_alloc(array->n, sizeof(int), false);
+    int *b = result->a;
     for (int i = 0; i < array->n; i++) {
         b[i] = f(a[i], i, x, state);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = array->n;
-    result->s = sizeof(int);
-    result->a = b;
     return result;
 }
 
@@ -1050,11 +1138,31 @@ static void ia_foldl_test(void) {
     a_free(a);
 }
 
+// The products of the ints and init. Overflow wraps around, so the order 
+// does not matter and four partial products hide the latency.
+static int ia_product(const int *a, int n, int init) {
+    unsigned p0 = (unsigned)init, p1 = 1, p2 = 1, p3 = 1;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        p0 *= (unsigned)a[i];
+        p1 *= (unsigned)a[i + 1];
+        p2 *= (unsigned)a[i + 2];
+        p3 *= (unsigned)a[i + 3];
+    }
+    for (; i < n; i++) {
+        p0 *= (unsigned)a[i];
+    }
+    return (int)(p0 * p1 * p2 * p3);
+}
+
 int ia_foldl(Array array, IntIntIntToInt f, int init) {
     require_not_null(array);
     require_element_size_int(array);
     require_not_null(f);
     int *a = array->a;
+    if (f == int_plus) return (int)(init + a_sum_int(a, array->n));
+    if (f == int_minus) return (int)(init - a_sum_int(a, array->n));
+    if (f == int_mult) return ia_product(a, array->n, init);
     for (int i = 0; i < array->n; i++) {
         init = f(init, a[i], i);
     }
@@ -1081,12 +1189,109 @@ int ia_foldr(Array array, IntIntIntToInt f, int init) {
     require_element_size_int(array);
     require_not_null(f);
     int *a = array->a;
+    if (f == int_plus) return (int)(init + a_sum_int(a, array->n));
+    if (f == int_mult) return ia_product(a, array->n, init);
     for (int i = array->n - 1; i >= 0; i--) {
         init = f(a[i], init, i);
     }
     return init;
 }
 
+static void ia_reductions_test(void) {
+    printsln((String)__func__);
+    Array a = ia_of_string("3, -1, 4, -1, 5, 9, 2, 6");
+    Array b = ia_of_string("1, 2, 3, 4, 5, 6, 7, 8");
+    test_equal_b(ia_sum(a) == 27, true);
+    test_equal_i(ia_min(a), -1);
+    test_equal_i(ia_min_index(a), 1);
+    test_equal_i(ia_max(a), 9);
+    test_equal_i(ia_max_index(a), 5);
+    test_within_d(ia_mean(a), 27.0 / 8, EPSILON);
+    double m = 27.0 / 8, v = 0;
+    for (int i = 0; i < 8; i++) v += (ia_get(a, i) - m) * (ia_get(a, i) - m);
+    test_within_d(ia_variance(a), v / 8, EPSILON);
+    test_equal_b(ia_dot(a, b) == 3 - 2 + 12 - 4 + 25 + 54 + 14 + 48, true);
+    test_within_d(ia_norm(b), sqrt(204), EPSILON);
+    a_free(a);
+    a_free(b);
+
+    // no overflow
+    a = ia_create(1000, INT_MAX);
+    test_equal_b(ia_sum(a) == 1000L * INT_MAX, true);
+    test_within_d(ia_variance(a), 0, EPSILON);
+    a_free(a);
+    a = ia_create(2, INT_MAX);
+    test_equal_b(ia_dot(a, a) == 2L * INT_MAX * INT_MAX, true);
+    a_free(a);
+
+    a = ia_create(0, 0);
+    test_equal_b(ia_sum(a) == 0, true);
+    test_equal_i(ia_min_index(a), -1);
+    test_equal_i(ia_max_index(a), -1);
+    a_free(a);
+}
+
+long ia_sum(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    return a_sum_int(array->a, array->n);
+}
+
+int ia_min(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    require("not empty", array->n > 0);
+    int *a = array->a;
+    return a[a_min_index_int(a, array->n)];
+}
+
+int ia_min_index(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    return a_min_index_int(array->a, array->n);
+}
+
+int ia_max(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    require("not empty", array->n > 0);
+    int *a = array->a;
+    return a[a_max_index_int(a, array->n)];
+}
+
+int ia_max_index(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    return a_max_index_int(array->a, array->n);
+}
+
+double ia_mean(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    require("not empty", array->n > 0);
+    return (double)a_sum_int(array->a, array->n) / array->n;
+}
+
+double ia_variance(Array array) {
+    double mean = ia_mean(array);
+    return a_squares_int(array->a, array->n, mean) / array->n;
+}
+
+long ia_dot(Array a, Array b) {
+    require_not_null(a);
+    require_not_null(b);
+    require_element_size_int(a);
+    require_element_size_int(b);
+    require_x("same length", a->n == b->n, "a->n == %d, b->n == %d", a->n, b->n);
+    return a_dot_int(a->a, b->a, a->n);
+}
+
+double ia_norm(Array array) {
+    require_not_null(array);
+    require_element_size_int(array);
+    return sqrt(a_squares_int(array->a, array->n, 0.0));
+}
+
 Array ia_filter(Array array, IntIntIntToBool predicate, int x);
 
 static void ia_filter_test(void) {
@@ -1114,31 +1319,107 @@ static void ia_filter_test(void) {
     a_free(a);
 }
 
+// Finds the comparison of a builtin predicate. Returns false for other predicates.
+static bool ia_builtin_compare(IntIntIntToBool predicate, ACompare *op) {
+    if (predicate == ia_gt) *op = A_GT;
+    else if (predicate == ia_ge) *op = A_GE;
+    else if (predicate == ia_lt) *op = A_LT;
+    else if (predicate == ia_le) *op = A_LE;
+    else if (predicate == ia_even) *op = A_EVEN;
+    else if (predicate == int_odd) *op = A_ODD;
+    else return false;
+    return true;
+}
+
 Array ia_filter(Array array, IntIntIntToBool predicate, int x) {
     require_not_null(array);
     require_element_size_int(array);
     require_not_null(predicate);
     int *a = array->a;
+    ACompare op;
+    if (ia_builtin_compare(predicate, &op)) {
+        int n = a_count_int(a, array->n, op, x);
+        Array result = a_alloc(n, sizeof(int), false);
+        a_select_int(a, op, x, result->a, n);
+        return result;
+    }
     bool *ps = xmalloc(array->n * sizeof(bool));
     int n = 0;
     for (int i = 0; i < array->n; i++) {
         ps[i] = predicate(a[i], i, x);
         if (ps[i]) n++;
     }
-    int *b = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = b;
     return result;
 }
 
+// The same as the builtin predicates and functions, but not recognized by 
+// ia_filter, ia_map, etc.
+static bool ia_gt_user(int value, int index, int x) { return value > x; }
+static bool ia_ge_user(int value, int index, int x) { return value >= x; }
+static bool ia_lt_user(int value, int index, int x) { return value < x; }
+static bool ia_le_user(int value, int index, int x) { return value <= x; }
+static bool ia_even_user(int value, int index, int x) { return (value & 1) == 0; }
+static bool ia_odd_user(int value, int index, int x) { return (value & 1) == 1; }
+static int ia_times_user(int value, int index, int x) { return value * x; }
+static int int_plus_user(int x, int y, int index) { return x + y; }
+static int int_minus_user(int x, int y, int index) { return x - y; }
+static int int_mult_user(int x, int y, int index) { return x * y; }
+
+static void ia_builtins_test(void) {
+    printsln((String)__func__);
+    IntIntIntToBool builtin[] = { ia_gt, ia_ge, ia_lt, ia_le, ia_even, int_odd };
+    IntIntIntToBool user[] = { ia_gt_user, ia_ge_user, ia_lt_user, ia_le_user, ia_even_user, ia_odd_user };
+    Array a = ia_create(0, 0);
+    bool ok = true;
+    for (int n = 0; n <= 40; n++) {
+        for (int k = 0; k < 6; k++) {
+            Array ac = ia_filter(a, builtin[k], 0);
+            Array ex = ia_filter(a, user[k], 0);
+            ok = ok && a_length(ac) == a_length(ex) && memcmp(ac->a, ex->a, a_length(ac) * sizeof(int)) == 0;
+            a_free(ac);
+            a_free(ex);
+        }
+        Array ac = ia_map(a, ia_times, 3);
+        Array ex = ia_map(a, ia_times_user, 3);
+        ok = ok && memcmp(ac->a, ex->a, n * sizeof(int)) == 0;
+        ia_each(ac, ia_times, -2);
+        ia_each(ex, ia_times_user, -2);
+        ok = ok && memcmp(ac->a, ex->a, n * sizeof(int)) == 0;
+        a_free(ac);
+        a_free(ex);
+        ok = ok && ia_foldl(a, int_plus, 7) == ia_foldl(a, int_plus_user, 7);
+        ok = ok && ia_foldl(a, int_minus, 7) == ia_foldl(a, int_minus_user, 7);
+        ok = ok && ia_foldl(a, int_mult, 7) == ia_foldl(a, int_mult_user, 7);
+        ok = ok && ia_foldr(a, int_plus, 7) == ia_foldr(a, int_plus_user, 7);
+        ok = ok && ia_foldr(a, int_mult, 7) == ia_foldr(a, int_mult_user, 7);
+        ia_push(a, i_rnd(11) - 5);
+    }
+    test_equal_b(ok, true);
+    a_free(a);
+
+    a = ia_of_string("-3, -2, -1, 0, 1, 2, 3");
+    Array ac = ia_filter(a, int_odd, 0);
+    Array ex = ia_of_string("-3, -1, 1, 3");
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
+    ac = ia_filter(a, ia_ge, 1);
+    ex = ia_of_string("1, 2, 3");
+    ia_test_equal(ac, ex);
+    a_free(ac);
+    a_free(ex);
+    test_equal_i(ia_foldl(a, int_mult, 1), 0);
+    a_free(a);
+}
+
 // @todo: add tests
 Array ia_filter_state(Array array, IntIntIntAnyToBool predicate, int x, Any state) {
     require_not_null(array);
@@ -1151,17 +1432,14 @@ Array ia_filter_state(Array array, IntIntIntAnyToBool predicate, int x, Any stat
         ps[i] = predicate(a[i], i, x, state);
         if (ps[i]) n++;
     }
-    int *b = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = b;
     return result;
 }
 
@@ -1199,13 +1477,10 @@ Array ia_choose(Array array, IntIntIntToIntOption f, int x) {
             b[n++] = op.some;
         }
     }
-    int *c = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(int));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = c;
     return result;
 }
 
@@ -1223,13 +1498,10 @@ Array ia_choose_state(Array array, IntIntIntAnyToIntOption f, int x, Any state)
             b[n++] = op.some;
         }
     }
-    int *c = xmalloc(n * sizeof(int));
+    Array result = a_alloc(n, sizeof(int), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(int));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(int);
-    result->a = c;
     return result;
 }
 
@@ -1360,6 +1632,7 @@ bool ia_test_equal_file_line(const char *file, const char *function, int line, A
 
 void ia_test_all(void) {
     ia_create_test();
+    ia_push_pop_test();
     ia_range_test();
     ia_of_string_test();
     ia_fn_test();
@@ -1374,6 +1647,8 @@ void ia_test_all(void) {
     ia_last_index_from_test();
     ia_last_index_fn_test();
     ia_sort_test();
+    ia_sort_from_to_test();
+    ia_sort_parallel_test();
     ia_sort_dec_test();
 //    ia_insert_test();
 //    ia_remove_test();
@@ -1381,7 +1656,9 @@ void ia_test_all(void) {
     ia_each_state_test();
     ia_foldl_test();
     ia_foldr_test();
+    ia_reductions_test();
     ia_filter_test();
+    ia_builtins_test();
     // ia_filter_state_test();
     ia_choose_test();
     ia_exists_test();
@@ -139,6 +139,23 @@ Increments array element at index by value. Avoids common pattern: set(a, i, get
 int ia_inc(Array array, int index, int value);
 #endif
 
+/**
+Appends value at the end of the array. Takes amortized constant time.
+@param[in,out] array int array
+@param[in] value value to append
+@see a_push, a_reserve
+*/
+void ia_push(Array array, int value);
+
+/**
+Removes the last element of the array and returns it.
+@param[in,out] array int array
+@return the removed element
+@pre "not empty", length > 0
+@see a_pop
+*/
+int ia_pop(Array array);
+
 /**
 Prints the array.
 @param[in] array int array
@@ -249,6 +266,23 @@ Sorts the elements in increasing order. The input array is modified.
 */
 void ia_sort(Array array);
 
+/**
+Sorts the elements array[from, to) in increasing order. The other elements are not touched. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array int array
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+@see a_view
+*/
+void ia_sort_from_to(Array array, int from, int to);
+
+/**
+Sorts the elements in increasing order with the given number of threads. The result is the same as that of @ref ia_sort. Each thread sorts a range of the array, then the ranges are merged (see @ref a_sort_parallel). Arrays of less than 2 * @ref A_SORT_PARALLEL_MIN elements are sorted by the calling thread alone. The input array is modified.
+@param[in,out] array int array
+@param[in] threads number of threads, 0 for one per processor
+@pre "non-negative thread count", threads >= 0
+*/
+void ia_sort_parallel(Array array, int threads);
+
 /**
 Sorts the elements in decreasing order.The input array is modified.
 @param[in,out] array int array
@@ -289,6 +323,8 @@ int f(int element, int index, int x) {}
 @param[in] x provided to each invocation of f
 @pre "not null", f
 
+If f is @ref ia_times, the array is multiplied by x in a vectorized loop, without calling f.
+
 <b>Step by step:</b><br/>
 array[0] := f(array[0], 0, x)<br/>
 array[1] := f(array[1], 1, x)<br/>
@@ -331,6 +367,8 @@ int f(int element, int index, int x) {}
 @param[in] x provided to each invocation of f
 @return the mapped array
 @pre "not null", f
+
+If f is @ref ia_times, the elements are multiplied by x in a vectorized loop, without calling f.
 */
 Array ia_map(Array array, IntIntIntToInt f, int x);
 
@@ -363,6 +401,8 @@ int f(int state, int element, int index) {}
 @return the accumulated state
 @pre "not null", f
 
+If f is @ref int_plus or @ref int_minus, the elements are summed like in @ref ia_sum. If f is @ref int_mult, the loop does not call f. The result is the same.
+
 <b>Step by step:</b><br/>
 state := f(state, array[0], 0)<br/>
 state := f(state, array[1], 1)<br/>
@@ -383,6 +423,8 @@ int f(int element, int state, int index) {}
 @return the accumulated state
 @pre "not null", f
 
+If f is @ref int_plus, the elements are summed like in @ref ia_sum. If f is @ref int_mult, the loop does not call f. The result is the same.
+
 <b>Step by step:</b><br/>
 state := f(array[n-1], state, n-1)<br/>
 ... <br/>
@@ -391,6 +433,77 @@ state := f(array[0], state, 0)
 */
 int ia_foldr(Array array, IntIntIntToInt f, int state);
 
+/**
+Returns the sum of the elements. The sum is a long, so it does not overflow like @c ia_foldl(array, int_plus, 0) would. Vectorized (AVX2 or SSE2, chosen at runtime), about as fast as reading the array.
+@param[in] array int array
+@return the sum, 0 for an empty array
+*/
+long ia_sum(Array array);
+
+/**
+Returns the smallest element.
+@param[in] array int array
+@return the smallest element
+@pre "not empty", a_length(array) > 0
+@see ia_min_index
+*/
+int ia_min(Array array);
+
+/**
+Returns the index of the smallest element. If there are several, the index of the first one. Vectorized like @ref ia_sum.
+@param[in] array int array
+@return the index of the smallest element, -1 for an empty array
+*/
+int ia_min_index(Array array);
+
+/**
+Returns the largest element.
+@param[in] array int array
+@return the largest element
+@pre "not empty", a_length(array) > 0
+@see ia_max_index
+*/
+int ia_max(Array array);
+
+/**
+Returns the index of the largest element. If there are several, the index of the first one. Vectorized like @ref ia_sum.
+@param[in] array int array
+@return the index of the largest element, -1 for an empty array
+*/
+int ia_max_index(Array array);
+
+/**
+Returns the mean of the elements.
+@param[in] array int array
+@return the mean
+@pre "not empty", a_length(array) > 0
+*/
+double ia_mean(Array array);
+
+/**
+Returns the (population) variance of the elements, i.e., the mean of the squared deviations from the mean. Takes two passes over the array, which avoids the cancellation of the one-pass formula.
+@param[in] array int array
+@return the variance
+@pre "not empty", a_length(array) > 0
+*/
+double ia_variance(Array array);
+
+/**
+Returns the dot product of a and b, i.e., the sum of a[i] * b[i]. Products and sum are computed with 64 bits.
+@param[in] a int array
+@param[in] b int array
+@return the dot product
+@pre "same length", a_length(a) == a_length(b)
+*/
+long ia_dot(Array a, Array b);
+
+/**
+Returns the Euclidean (L2) norm of the elements, i.e., the square root of the sum of their squares, computed in double precision.
+@param[in] array int array
+@return the norm
+*/
+double ia_norm(Array array);
+
 /**
 Predicates
 */
@@ -424,6 +537,8 @@ bool predicate(int element, int index, int x) {}
 @param[in] x given to each invocation of predicate
 @return filtered array
 @pre "not null", predicate
+
+If predicate is @ref ia_gt, @ref ia_ge, @ref ia_lt, @ref ia_le, @ref ia_even, or @ref int_odd, the elements are compared to x in a vectorized loop, without calling predicate and without a temporary array.
 */
 Array ia_filter(Array array, IntIntIntToBool predicate, int x);
 
@@ -268,40 +268,22 @@ List il_of_dl(List list) {
 int il_get(List list, int index) {
     require_not_null(list);
     require_element_size_int(list);
-    int i = 0;
-    for (IntListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            return node->value;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
-    return 0;
+    IntListNode *node = l_node_at(list, index);
+    return node->value;
 }
 
 void il_set(List list, int index, int value) {
     require_not_null(list);
     require_element_size_int(list);
-    int i = 0;
-    for (IntListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value = value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    IntListNode *node = l_node_at(list, index);
+    node->value = value;
 }
 
 void il_inc(List list, int index, int value) {
     require_not_null(list);
     require_element_size_int(list);
-    int i = 0;
-    for (IntListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value += value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    IntListNode *node = l_node_at(list, index);
+    node->value += value;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -370,7 +352,7 @@ void il_append(List list, int value) {
     require_not_null(list);
     require_element_size_int(list);
     // allocate memory for next-pointer and content
-    IntListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    IntListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     // if this is the first element of the list set first pointer
@@ -384,13 +366,14 @@ void il_append(List list, int value) {
     }
     // the new node is the last node of the list
     list->last = node;
+    list->n++;
 }
 
 void il_prepend(List list, int value) {
     require_not_null(list);
     require_element_size_int(list);
     // allocate memory for next-pointer and content
-    IntListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    IntListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     node->next = list->first;
@@ -398,6 +381,8 @@ void il_prepend(List list, int value) {
     if (list->last == NULL) {
         list->last = node;
     }
+    list->n++;
+    list->cursor_index++;
 }
 
 void il_print(List list) {
@@ -753,6 +738,50 @@ List il_sort_dec(List list) {
     return l_sort(list, int_compare_dec);
 }
 
+void il_sort_inplace(List list);
+
+static void il_sort_inplace_test(void) {
+    printsln((String)__func__);
+    List ac, ex;
+
+    ac = il_of_string("5, 4, 3, 2, 1");
+    ex = il_of_string("1, 2, 3, 4, 5, 6");
+    il_sort_inplace(ac);
+    il_append(ac, 6);
+    il_test_equal(ac, ex);
+    l_free(ac);
+    l_free(ex);
+
+    ac = il_of_string("1, 2, 1, 3, 2");
+    ex = il_of_string("1, 1, 2, 2, 3");
+    il_sort_inplace(ac);
+    il_test_equal(ac, ex);
+    l_free(ac);
+    l_free(ex);
+
+    ac = il_of_string("");
+    ex = il_of_string("");
+    il_sort_inplace(ac);
+    il_test_equal(ac, ex);
+    l_free(ac);
+    l_free(ex);
+
+    ac = il_of_string("-3, 7, -2, 8, -1");
+    ex = il_of_string("-3, -2, -1, 7, 8");
+    il_get(ac, 3);
+    il_sort_inplace(ac);
+    il_test_equal(ac, ex);
+    test_equal_i(il_get(ac, 3), 7);
+    l_free(ac);
+    l_free(ex);
+}
+
+void il_sort_inplace(List list) {
+    require_not_null(list);
+    require_element_size_int(list);
+    l_sort_inplace(list, int_compare);
+}
+
 void il_insert(List list, int index, int value);
 
 static void il_insert_test(void) {
@@ -1329,6 +1358,11 @@ bool il_test_equal_file_line(const char *file, const char *function, int line, L
         printf("%s, line %d: Actual and expected lengths differ\n", file, line);
         return false;
     }
+    if (a->n != i || e->n != i) {
+        printf("%s, line %d: Length %d differs from the number of nodes %d\n", 
+                file, line, a->n != i ? a->n : e->n, i);
+        return false;
+    }
     printf("%s, line %d: Check passed.\n", file, line);
     base_count_success();
     return true;
@@ -1354,6 +1388,7 @@ void il_test_all(void) {
     il_index_fn_test();
     il_sort_test();
     il_sort_dec_test();
+    il_sort_inplace_test();
     il_insert_test();
     il_remove_test();
     il_each_test();
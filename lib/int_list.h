@@ -99,7 +99,7 @@ The input list is not modified.
 List il_of_dl(List list);
 
 /**
-Returns list element at index.
+Returns list element at index. Accessing the elements in order takes amortized constant time per element (see @ref l_get).
 @param[in] list int list
 @param[in] index index of list element to return
 @return list element
@@ -234,6 +234,13 @@ Creates a new list. Does not modify the original list.
 */
 List il_sort_dec(List list);
 
+/**
+Sorts the elements in increasing order in place. Equal elements keep their relative order (stable sort).
+Does not create a new list, the nodes are relinked (see @ref l_sort_inplace).
+@param[in,out] list int list
+*/
+void il_sort_inplace(List list);
+
 /**
 Inserts value into list at position index.
 Does nothing if index is not valid, i.e., if not in interval [0,n].
@@ -16,13 +16,120 @@
  */
 #define VALUE(node) ((Any)(((ListNode*)(node)) + 1))
 
+///////////////////////////////////////////////////////////////////////////////
+// Nodes
+
+/*
+ * Nodes are allocated with base_node_calloc (see l_node_alloc), which takes 
+ * small nodes from a pool of slabs. Pooled nodes are recognized by free, so 
+ * nodes can be freed like any other block.
+ */
+
+void l_node_free(Any node) {
+    free(node);
+}
+
+static void l_node_pool_test(void) {
+    printsln((String)__func__);
+    List a;
+
+    // nodes are blocks that free accepts
+    a = l_create(sizeof(int));
+    ListNode *node = l_node_alloc(a);
+    test_equal_b(node->next == NULL, true);
+#ifndef NO_MEMORY_TRACKING
+    test_equal_b(memory_footprint(node, sizeof(int)).tracker > 0, true); // reported if leaked
+#endif
+    free(node);
+
+    // a chain may mix pooled nodes with nodes of an arena and of the heap
+    Arena arena = arena_create(256);
+    arena_enter(arena);
+    ListNode *arena_node = l_node_alloc(a);
+    arena_leave();
+    ListNode *heap_node = xcalloc(1, sizeof(ListNode) + sizeof(int));
+    node = l_node_alloc(a);
+    node->next = arena_node;
+    arena_node->next = heap_node;
+    heap_node->next = l_node_alloc(a);
+    base_free_chain(node);
+    arena_free(arena);
+
+    // freed nodes are reused
+    node = l_node_alloc(a);
+    free(node);
+    test_equal_b(l_node_alloc(a) == (Any)node, true);
+    free(node);
+
+    // slabs whose nodes are all free are returned to the system
+    size_t before = base_node_pool_bytes();
+    for (int i = 0; i < 20000; i++) l_append(a, &i);
+    size_t full = base_node_pool_bytes();
+    test_equal_b(full > before, true);
+    l_remove(a, 0);
+    test_equal_i(*(int*)l_get(a, 0), 1);
+    l_free(a);
+    test_equal_b(base_node_pool_bytes() < full, true);
+    test_equal_b(base_node_pool_bytes() <= before + 64 * 1024, true); // keeps at most one empty slab
+
+    // large nodes are not pooled, but work the same
+    Byte big[129] = { 7 };
+    a = l_create(sizeof(big));
+    l_append(a, big);
+    l_prepend(a, big);
+    test_equal_i(((Byte*)l_get(a, 1))[0], 7);
+    l_remove(a, 0);
+    l_free(a);
+}
+
+static void l_footprint_test(void) {
+    printsln((String)__func__);
+    List a = l_create(sizeof(int));
+    Footprint head = memory_footprint(a, 0);
+    Footprint f = l_footprint(a);
+    test_equal_i(f.payload, 0);
+    test_equal_i(f.structure, head.structure);
+    test_equal_i(f.tracker, head.tracker);
+    for (int i = 0; i < 1000; i++) {
+        l_append(a, &i);
+    }
+    f = l_footprint(a);
+    Footprint node = memory_footprint(a->first, sizeof(int));
+    test_equal_i(f.payload, 1000 * sizeof(int));
+    test_equal_i(f.tracker, head.tracker + 1000 * node.tracker);
+    // pooled nodes of 12 bytes use blocks of 16 bytes (plus the header of memory tracking)
+    test_equal_i(f.structure, head.structure + 1000 * (16 - sizeof(int)));
+
+    // the same elements in an array cost less
+    Array b = a_create(1000, sizeof(int));
+    Footprint g = a_footprint(b);
+    test_equal_i(g.payload, f.payload);
+    test_equal_b(g.payload + g.structure + g.tracker < f.payload + f.structure + f.tracker, true);
+    a_free(b);
+    l_free(a);
+
+    // large nodes are allocated individually
+    Byte big[129] = { 7 };
+    a = l_create(sizeof(big));
+    l_append(a, big);
+    f = l_footprint(a);
+    node = memory_footprint(a->first, sizeof(big));
+    test_equal_i(f.payload, sizeof(big));
+    test_equal_i(f.structure, head.structure + node.structure);
+    test_equal_i(f.tracker, head.tracker + node.tracker);
+    test_equal_b(node.structure >= sizeof(ListNode*), true);
+    l_free(a);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 /*
  * Appends a zero-initialized node to list.
  */
 static ListNode *l_append_empty(List list) {
     require_not_null(list);
     // allocate memory for next-pointer and content
-    Any a = xcalloc(1, sizeof(ListNode*) + list->s);
+    Any a = l_node_alloc(list);
     // if this is the first element of the result set first pointer
     if (list->first == NULL) {
         list->first = a;
@@ -34,6 +141,7 @@ static ListNode *l_append_empty(List list) {
     }
     // the new node is the last node of the list
     list->last = a;
+    list->n++;
     return a;
 }
 
@@ -160,7 +268,7 @@ List l_fn(int n, int s, AnyFn init, Any state) {
     List list = l_create(s);
     for (int i = 0; i < n; i++) {
         // allocate memory for next-pointer and content
-        Any a = xcalloc(1, sizeof(ListNode*) + s);
+        Any a = l_node_alloc(list);
         // if this is the first element of the list set first pointer
         if (list->first == NULL) {
             list->first = a;
@@ -172,6 +280,7 @@ List l_fn(int n, int s, AnyFn init, Any state) {
         }
         // the new node is the last node of the list
         list->last = a;
+        list->n++;
 //        Any element = a + sizeof(ListNode*); // arithmetic on void-pointers is a gcc extension!
         Any element = (ListNode*)a + 1;
         finit(element, i, state);
@@ -443,40 +552,112 @@ List l_of_a(Array array) {
 
 void l_free(List list) {
     if (list != NULL) {
-        ListNode *next = NULL;
-        for (ListNode *node = list->first; node != NULL; node = next) {
-            next = node->next;
-            free(node);
-        }
+        base_free_chain(list->first);
         list->s = 0;
+        list->n = 0;
         list->first = NULL;
         list->last = NULL;
+        list->cursor = NULL;
         free(list);
     }
 }
 
-Any l_get(List list, int index) {
+Footprint l_footprint(List list) {
     require_not_null(list);
-    int i = 0;
-    for (ListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            return node + 1;
+    Footprint f = memory_footprint(list, 0);
+    for (ListNode *node = list->first; node != NULL; node = node->next) {
+        Footprint e = memory_footprint(node, list->s);
+        f.payload += e.payload;
+        f.structure += e.structure;
+        f.tracker += e.tracker;
+    }
+    return f;
+}
+
+static void l_node_at_test(void) {
+    printsln((String)__func__);
+    // random mix of indexed accesses and mutations, compared to an array
+    int m = 200;
+    int *ex = xmalloc(m * sizeof(int));
+    int n = 0;
+    List ac = l_create(sizeof(int));
+    bool ok = true;
+    for (int r = 0; r < 5000; r++) {
+        int op = i_rnd(6);
+        int index = i_rnd(n + 3) - 1; // also out of range
+        int near = l_length(ac) > 0 && ac->cursor != NULL ? ac->cursor_index + i_rnd(3) - 1 : 0;
+        int value = r;
+        if (op == 0 && n < m) {
+            l_append(ac, &value);
+            ex[n++] = value;
+        } else if (op == 1 && n < m) {
+            l_prepend(ac, &value);
+            memmove(ex + 1, ex, n * sizeof(int));
+            ex[0] = value;
+            n++;
+        } else if (op == 2 && n < m) {
+            l_insert(ac, index, &value);
+            if (index <= 0) index = 0;
+            if (index <= n) {
+                memmove(ex + index + 1, ex + index, (n - index) * sizeof(int));
+                ex[index] = value;
+                n++;
+            }
+        } else if (op == 3 && n > 0) {
+            l_remove(ac, index);
+            if (index <= 0) index = 0;
+            if (index < n) {
+                memmove(ex + index, ex + index + 1, (n - index - 1) * sizeof(int));
+                n--;
+            }
+        } else if (op == 4 && near >= 0 && near < n) {
+            l_set(ac, near, &value);
+            ex[near] = value;
+        } else if (n > 0) {
+            index = i_rnd(n);
+            ok = ok && *(int*)l_get(ac, index) == ex[index];
         }
+        ok = ok && l_length(ac) == n;
     }
-    require_x("index in range", false, "index == %d", index);
-    return NULL;
+    for (int i = 0; i < n; i++) {
+        ok = ok && *(int*)l_get(ac, i) == ex[i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        ok = ok && *(int*)l_get(ac, i) == ex[i];
+    }
+    test_equal_b(ok, true);
+    l_free(ac);
+    free(ex);
 }
 
-void l_set(List list, int index, Any value) {
+Any l_node_at(List list, int index) {
     require_not_null(list);
+    require_x("index in range", index >= 0 && index < list->n, "index == %d, length == %d", index, list->n);
+    ListNode *node = list->first;
     int i = 0;
-    for (ListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            memcpy(node + 1, value, list->s);
-            return;
-        }
+    if (index == list->n - 1) {
+        node = list->last;
+        i = index;
+    } else if (list->cursor != NULL && list->cursor_index <= index) {
+        node = list->cursor;
+        i = list->cursor_index;
     }
-    require_x("index in range", false, "index == %d", index);
+    for (; i < index; i++) {
+        node = node->next;
+    }
+    list->cursor = node;
+    list->cursor_index = index;
+    return node;
+}
+
+Any l_get(List list, int index) {
+    ListNode *node = l_node_at(list, index);
+    return node + 1;
+}
+
+void l_set(List list, int index, Any value) {
+    ListNode *node = l_node_at(list, index);
+    memcpy(node + 1, value, list->s);
 }
 
 static void l_iterator_test(void) {
@@ -523,7 +704,7 @@ Any l_next(ListIterator *iter) {
 void l_append(List list, Any value) {
     require_not_null(list);
     // allocate memory for next-pointer and content
-    Any a = xcalloc(1, sizeof(ListNode*) + list->s);
+    Any a = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     memcpy((ListNode*)a + 1, value, list->s);
     // if this is the first element of the list set first pointer
@@ -537,12 +718,13 @@ void l_append(List list, Any value) {
     }
     // the new node is the last node of the list
     list->last = a;
+    list->n++;
 }
 
 void l_prepend(List list, Any value) {
     require_not_null(list);
     // allocate memory for next-pointer and content
-    Any a = xcalloc(1, sizeof(ListNode*) + list->s);
+    Any a = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     memcpy((ListNode*)a + 1, value, list->s);
     ListNode *node = a;
@@ -551,15 +733,68 @@ void l_prepend(List list, Any value) {
     if (list->last == NULL) {
         list->last = node;
     }
+    list->n++;
+    list->cursor_index++;
+}
+
+int l_length(List list);
+
+static bool l_is_odd(int *element, int index, Any state) {
+    return (*element & 1) == 1;
+}
+
+static void l_twice(int *element, int index, Any state, int *mapped_element) {
+    *mapped_element = 2 * *element;
+}
+
+static void l_length_test(void) {
+    printsln((String)__func__);
+    int i;
+    List ac = l_create(sizeof(int));
+    test_equal_i(l_length(ac), 0);
+    i = 1; l_append(ac, &i);
+    i = 2; l_append(ac, &i);
+    i = 0; l_prepend(ac, &i);
+    test_equal_i(l_length(ac), 3);
+    i = 3; l_insert(ac, 3, &i); // at the end
+    i = 4; l_append(ac, &i); // after the inserted node
+    i = 9; l_insert(ac, 9, &i); // out of range, not inserted
+    test_equal_i(l_length(ac), 5);
+    test_equal_i(*(int*)l_get(ac, 4), 4);
+    l_remove(ac, 0);
+    l_remove(ac, 3);
+    l_remove(ac, 3); // out of range
+    test_equal_i(l_length(ac), 3);
+
+    List l = l_sub(ac, 1, 3);
+    test_equal_i(l_length(l), 2);
+    l_free(l);
+    l = l_filter(ac, l_is_odd, NULL);
+    test_equal_i(l_length(l), 2);
+    l_free(l);
+    l = l_map(ac, l_twice, sizeof(int), NULL);
+    test_equal_i(l_length(l), 3);
+    l_free(l);
+    l = l_concat(ac, ac);
+    test_equal_i(l_length(l), 6);
+    l_free(l);
+    l = l_reverse(ac);
+    test_equal_i(l_length(l), 3);
+    l_free(l);
+    l = l_shuffle(ac);
+    test_equal_i(l_length(l), 3);
+    l_free(l);
+
+    while (l_length(ac) > 0) l_remove(ac, 0);
+    test_equal_b(ac->first == NULL && ac->last == NULL, true);
+    i = 5; l_append(ac, &i);
+    test_equal_i(l_length(ac), 1);
+    l_free(ac);
 }
 
 int l_length(List list) {
     require_not_null(list);
-    int n = 0;
-    for (ListNode *node = list->first; node != NULL; node = node->next) {
-        n++;
-    }
-    return n;
+    return list->n;
 }
 
 int l_element_size(List list) {
@@ -912,14 +1147,17 @@ static void l_shuffle_test(void) {
 List l_shuffle(List list) {
     require_not_null(list);
     int n = l_length(list);
-    Array indices = ia_range(0, n);
-    a_shuffle(indices);
+    Array a = a_create(n, list->s);
+    int i = 0;
+    for (ListNode *node = list->first; node != NULL; node = node->next, i++) {
+        a_set(a, i, node + 1);
+    }
+    a_shuffle(a);
     List result = l_create(list->s);
-    for (int i = 0; i < n; i++) {
-        int j = ia_get(indices, i);
-        l_append(result, l_get(list, j));
+    for (i = 0; i < n; i++) {
+        l_append(result, a_get(a, i));
     }
-    a_free(indices);
+    a_free(a);
     return result;
 }
 
@@ -1005,6 +1243,192 @@ List l_sort(List list, Comparator c) {
     return result;
 }
 
+List l_sort_stable(List list, Comparator c);
+
+static CmpResult l_compare_int_pair_i(ConstAny a, ConstAny b) {
+    int x = ((IntPair*)a)->i;
+    int y = ((IntPair*)b)->i;
+    return (x < y) ? LT : ((x > y) ? GT : EQ);
+}
+
+static void l_sort_stable_test(void) {
+    printsln((String)__func__);
+    List a = l_create(sizeof(IntPair));
+    for (int j = 0; j < 100; j++) {
+        IntPair p = { (j * 7) % 5, j };
+        l_append(a, &p);
+    }
+    List s = l_sort_stable(a, l_compare_int_pair_i);
+    test_equal_i(l_length(s), 100);
+    IntPair *prev = NULL;
+    bool stable = true;
+    for (ListNode *node = s->first; node != NULL; node = node->next) {
+        IntPair *p = (IntPair*)(node + 1);
+        if (prev != NULL) {
+            stable = stable && (prev->i < p->i || (prev->i == p->i && prev->j < p->j));
+        }
+        prev = p;
+    }
+    test_equal_b(stable, true);
+    l_free(a);
+    l_free(s);
+
+    a = l_create(sizeof(int));
+    s = l_sort_stable(a, l_compare_i);
+    test_equal_i(l_length(s), 0);
+    l_free(a);
+    l_free(s);
+}
+
+List l_sort_stable(List list, Comparator c) {
+    require_not_null(list);
+    require_not_null(c);
+    int n = l_length(list);
+    Array a = a_create(n, list->s);
+    int i = 0;
+    for (ListNode *node = list->first; node != NULL; node = node->next, i++) {
+        a_set(a, i, node + 1);
+    }
+    a_sort_stable(a, c);
+    List result = l_create(list->s);
+    for (i = 0; i < n; i++) {
+        l_append(result, a_get(a, i));
+    }
+    a_free(a);
+    return result;
+}
+
+void l_sort_inplace(List list, Comparator c);
+
+static void l_sort_inplace_test(void) {
+    printsln((String)__func__);
+    // stable: equal keys keep the order of j
+    List a = l_create(sizeof(IntPair));
+    for (int j = 0; j < 100; j++) {
+        IntPair p = { (j * 7) % 5, j };
+        l_append(a, &p);
+    }
+    ListNode *first = a->first;
+    l_get(a, 50);
+    l_sort_inplace(a, l_compare_int_pair_i);
+    test_equal_i(l_length(a), 100);
+    test_equal_b(a->cursor == NULL, true);
+    IntPair *prev = NULL;
+    bool stable = true, found = false;
+    ListNode *last = NULL;
+    for (ListNode *node = a->first; node != NULL; node = node->next) {
+        IntPair *p = (IntPair*)(node + 1);
+        if (prev != NULL) {
+            stable = stable && (prev->i < p->i || (prev->i == p->i && prev->j < p->j));
+        }
+        prev = p;
+        found = found || node == first; // the nodes are relinked, not copied
+        last = node;
+    }
+    test_equal_b(stable, true);
+    test_equal_b(found, true);
+    test_equal_b(a->last == last, true);
+    l_free(a);
+
+    // random, sorted, reversed, and nearly sorted input, compared to a_sort_stable
+    bool ok = true;
+    for (int kind = 0; kind < 4; kind++) {
+        for (int n = 0; n < 300; n += 1 + n / 4) {
+            Array e = a_create(n, sizeof(IntPair));
+            IntPair *p = e->a;
+            for (int i = 0; i < n; i++) {
+                p[i].i = kind == 0 ? i_rnd(10) : (kind == 2 ? n - i / 3 : i / 3);
+                p[i].j = i;
+            }
+            if (kind == 3 && n > 0) {
+                IntPair x = p[0]; p[0] = p[n - 1]; p[n - 1] = x;
+            }
+            a = l_of_a(e);
+            a_sort_stable(e, l_compare_int_pair_i);
+            l_sort_inplace(a, l_compare_int_pair_i);
+            int i = 0;
+            for (ListNode *node = a->first; node != NULL; node = node->next, i++) {
+                IntPair *q = (IntPair*)(node + 1);
+                ok = ok && i < n && q->i == p[i].i && q->j == p[i].j;
+            }
+            ok = ok && i == n && l_length(a) == n;
+            ok = ok && (n == 0 ? a->last == NULL : ((IntPair*)l_get(a, n - 1))->j == p[n - 1].j);
+            ok = ok && (n == 0 || ((ListNode*)a->last)->next == NULL);
+            l_free(a);
+            a_free(e);
+        }
+    }
+    test_equal_b(ok, true);
+}
+
+/*
+ * Merges the sorted chains a and b, elements of a come first if equal.
+ */
+static ListNode *l_merge_chains(ListNode *a, ListNode *b, Comparator c) {
+    ListNode head, *tail = &head;
+    while (a != NULL && b != NULL) {
+        if (c(VALUE(b), VALUE(a)) < 0) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a != NULL ? a : b;
+    return head.next;
+}
+
+void l_sort_inplace(List list, Comparator c) {
+    require_not_null(list);
+    require_not_null(c);
+    // pending[k] is a sorted chain of 2^k runs (or NULL), the chains of
+    // higher levels hold the earlier elements
+    ListNode *pending[8 * sizeof(int)] = { NULL };
+    int levels = 0;
+    ListNode *node = list->first;
+    while (node != NULL) {
+        // cut the next natural run, reverse it if it is strictly decreasing
+        ListNode *run = node, *next = node->next;
+        if (next != NULL && c(VALUE(node), VALUE(next)) > 0) {
+            run->next = NULL;
+            while (next != NULL && c(VALUE(node), VALUE(next)) > 0) {
+                ListNode *after = next->next;
+                next->next = run;
+                run = next;
+                node = next;
+                next = after;
+            }
+        } else {
+            while (next != NULL && c(VALUE(node), VALUE(next)) <= 0) {
+                node = next;
+                next = next->next;
+            }
+            node->next = NULL;
+        }
+        node = next;
+        // add the run like a carry in a binary counter
+        int k = 0;
+        while (k < levels && pending[k] != NULL) {
+            run = l_merge_chains(pending[k], run, c);
+            pending[k++] = NULL;
+        }
+        pending[k] = run;
+        if (k == levels) levels++;
+    }
+    ListNode *result = NULL;
+    for (int k = 0; k < levels; k++) {
+        if (pending[k] != NULL) {
+            result = result == NULL ? pending[k] : l_merge_chains(pending[k], result, c);
+        }
+    }
+    list->first = result;
+    for (node = result; node != NULL && node->next != NULL; node = node->next);
+    list->last = node;
+    list->cursor = NULL;
+}
+
 void l_insert(List list, int index, Any value);
 
 static void l_insert_test(void) {
@@ -1056,19 +1480,17 @@ void l_insert(List list, int index, Any value) {
         l_prepend(list, value);
         return;
     }
-    // assert: index > 0
-    ListNode *node = list->first;
-    int k = 1;
-    while (node != NULL && k < index) {
-        node = node->next;
-        k++;
-    }
-    if (node != NULL) {
-        ListNode *new_node = xcalloc(1, sizeof(ListNode*) + list->s);
-        memcpy(new_node + 1, value, list->s);
-        new_node->next = node->next;
-        node->next = new_node;
+    if (index >= list->n) {
+        if (index == list->n) l_append(list, value);
+        return;
     }
+    // assert: 0 < index < n, the cursor stays before the new node
+    ListNode *node = l_node_at(list, index - 1);
+    ListNode *new_node = l_node_alloc(list);
+    memcpy(new_node + 1, value, list->s);
+    new_node->next = node->next;
+    node->next = new_node;
+    list->n++;
 }
 
 void l_remove(List list, int index);
@@ -1144,32 +1566,31 @@ static void l_remove_test(void) {
 
 void l_remove(List list, int index) {
     require_not_null(list);
-    if (list->first == NULL) return;
+    if (list->first == NULL || index >= list->n) return;
     // assert: list->first != NULL
     if (index <= 0) {
         ListNode *del = list->first;
         list->first = del->next;
-        free(del);
         if (list->first == NULL) {
             list->last = NULL;
         }
+        if (list->cursor == del) {
+            list->cursor = NULL;
+        }
+        list->cursor_index--;
+        l_node_free(del);
+        list->n--;
         return;
     }
-    // assert: index > 0 && list->first != NULL
-    ListNode *node = list->first;
-    int k = 1;
-    while (node != NULL && k < index) {
-        node = node->next;
-        k++;
-    }
-    if (node != NULL && node->next != NULL) {
-        ListNode *del = node->next;
-        node->next = del->next;
-        free(del);
-        if (node->next == NULL) {
-            list->last = node;
-        }
+    // assert: 0 < index < n, the cursor stays before the removed node
+    ListNode *node = l_node_at(list, index - 1);
+    ListNode *del = node->next;
+    node->next = del->next;
+    if (node->next == NULL) {
+        list->last = node;
     }
+    l_node_free(del);
+    list->n--;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1795,6 +2216,11 @@ bool l_test_equal_file_line(const char *file, const char *function, int line, Li
         printf("%s, line %d: Actual and expected lengths differ\n", file, line);
         return false;
     }
+    if (a->n != i || e->n != i) {
+        printf("%s, line %d: Length %d differs from the number of nodes %d\n", 
+                file, line, a->n != i ? a->n : e->n, i);
+        return false;
+    }
 
     printf("%s, line %d: Check passed.\n", file, line);
     base_count_success();
@@ -1804,6 +2230,8 @@ bool l_test_equal_file_line(const char *file, const char *function, int line, Li
 ///////////////////////////////////////////////////////////////////////////////
 
 void l_test_all(void) {
+    l_node_pool_test();
+    l_footprint_test();
     l_create_test();
     l_of_buffer_test();
     l_fn_test();
@@ -1816,6 +2244,10 @@ void l_test_all(void) {
     l_reverse_test();
     l_shuffle_test();
     l_sort_test();
+    l_sort_stable_test();
+    l_sort_inplace_test();
+    l_length_test();
+    l_node_at_test();
     l_insert_test();
     l_remove_test();
     l_map_test();
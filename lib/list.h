@@ -97,7 +97,40 @@ Free the memory of the list.
 void l_free(List list);
 
 /**
-Returns the memory address of the list element at index i.
+Returns how many bytes the list occupies. The payload are the bytes of the elements (element size times length). The structure is the list head and, for each node, the next pointer and the rounding of the pool or the allocator. The tracker overhead are the headers of memory tracking. Works for all kinds of lists. For string lists and pointer lists, the referenced strings and objects are not included.
+@param[in] list input list
+@return the footprint of the list
+@see memory_footprint
+*/
+Footprint l_footprint(List list);
+
+/**
+Allocates a zero-initialized node for an element of the list. Small nodes come from a pool of recycled nodes, which is much cheaper than allocating each node with @ref xcalloc (see @ref base_node_calloc). With memory tracking, nodes are tracked, such that leaked nodes are reported where they were allocated. Inside an arena (see @ref arena_enter), nodes are allocated from the arena. Nodes can be freed with @ref free.
+@param[in] list the list the node is for (determines the node size)
+@return the new node
+@private
+*/
+#define l_node_alloc(list) base_node_calloc(__FILE__, __func__, __LINE__, sizeof(ListNode*) + (list)->s)
+
+/**
+Frees a node allocated with @ref l_node_alloc. Pooled nodes are returned to the pool.
+@param[in] node the node to free
+@private
+*/
+void l_node_free(Any node);
+
+/**
+Returns the node at index i and moves the cursor of the list there. The search starts at the cursor if it is not behind index i, otherwise at the first node, thus accessing the elements in order takes amortized constant time per element. The last node is found directly. Functions that add or remove nodes keep the cursor valid. A node of the list must not be unlinked without these functions.
+@param[in] list input list
+@param[in] index index of the node
+@return the node, of type ListNode*, IntListNode*, etc.
+@pre "index in range"
+@private
+*/
+Any l_node_at(List list, int index);
+
+/**
+Returns the memory address of the list element at index i. Accessing the elements in order (i, i + 1, ...) takes amortized constant time per element (see @ref l_node_at).
 @param[in] list input list
 @param[in] index index of list element to return
 @return address of list element
@@ -155,7 +188,7 @@ Copies l_element_size(list) bytes from value.
 void l_prepend(List list, Any value);
     
 /**
-Returns the number of elements of the list (not the number of bytes!).
+Returns the number of elements of the list (not the number of bytes!). Takes constant time, the list head keeps count.
 @param[in] list input list
 @return number of elements in list
 */
@@ -275,6 +308,21 @@ il_free(a);
 */
 List l_sort(List list, Comparator c);
 
+/**
+Returns a sorted copy of the list, using comparator c, in which equal elements keep their relative order (stable sort). @ref l_sort is not stable. Sorted and nearly sorted lists take about linear time (see @ref a_sort_stable).
+@param[in] list input list
+@param[in] c comparator function to compare two elements
+@return new list with sorted order
+*/
+List l_sort_stable(List list, Comparator c);
+
+/**
+Sorts the list in place, using comparator c. Equal elements keep their relative order (stable sort). Unlike @ref l_sort, it does not copy the elements and allocates nothing: it relinks the existing nodes by a bottom-up merge sort of the natural runs of the list (increasing or strictly decreasing sequences). Takes O(n log r) time for r runs, thus sorted and reversed lists take linear time. Up to about 10000 elements it is also faster than @ref l_sort for random order, but for large lists in random order it is slower, since each merge pass follows the links to nodes all over memory, whereas @ref l_sort sorts a contiguous copy (see benchmarks/bench_sort_stable.c). The cursor of the list is reset (see @ref l_node_at).
+@param[in,out] list input list
+@param[in] c comparator function to compare two elements
+*/
+void l_sort_inplace(List list, Comparator c);
+
 /**
 Inserts value at index in list. 
 Does nothing if index is not a valid index, i.e. if not interval [0,n].
@@ -38,14 +38,11 @@ static void pa_create_test(void) {
 
 Array pa_create(int n, Any value) {
     require("non-negative length", n >= 0);
-    Any *a = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    Any *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = value;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = a;
     return result;
 }
 
@@ -121,13 +118,11 @@ static void a_sub_test(void) {
 void pa_free(Array array) {
     if (array != NULL) {
         require_element_size_pointer(array);
-        if (array->a != NULL) {
+        if (array->base == NULL) { // a view does not own the objects
             for (int i = 0; i < array->n; i++) {
                 Any s = pa_get(array, i);
                 s_free(s);
             }
-            free(array->a);
-            array->a = NULL;
         }
         array->n = 0;
         array->s = 0;
@@ -152,11 +147,41 @@ void pa_set(Array array, int index, Any value) {
     require_element_size_pointer(array);
     require_x("index in range", index >= 0 && index < array->n, 
             "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     Any *a = array->a;
     a[index] = value;
 }
 #endif
 
+static void pa_push_pop_test(void) {
+    printsln((Any)__func__);
+    Array a = pa_create(0, NULL);
+    pa_push(a, "x");
+    pa_push(a, "y");
+    test_equal_i(a_length(a), 2);
+    test_equal_s(pa_get(a, 0), "x");
+    test_equal_s(pa_pop(a), "y");
+    test_equal_i(a_length(a), 1);
+    a_free(a);
+}
+
+void pa_push(Array array, Any value) {
+    require_not_null(array);
+    require_element_size_pointer(array);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    Any *a = array->a;
+    a[array->n++] = value;
+}
+
+Any pa_pop(Array array) {
+    require_not_null(array);
+    require_element_size_pointer(array);
+    require("not empty", array->n > 0);
+    Any *a = array->a;
+    return a[--array->n];
+}
+
 #if 0
 void pa_print(Array array) {
     require_not_null(array);
@@ -484,6 +509,7 @@ static void pa_sort_test(void) {
 
 void pa_sort(Array array) {
     require_element_size_pointer(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(Any), Any_compare);
 }
 
@@ -509,6 +535,7 @@ static void pa_sort_ignore_case_test(void) {
 
 void pa_sort_ignore_case(Array array) {
     require_element_size_pointer(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(Any), Any_compare_ignore_case);
 }
 
@@ -556,6 +583,7 @@ static void pa_sort_dec_test(void) {
 
 void pa_sort_dec(Array array) {
     require_element_size_pointer(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(Any), Any_compare_dec);
 }
 
@@ -581,6 +609,7 @@ static void pa_sort_dec_ignore_case_test(void) {
 
 void pa_sort_dec_ignore_case(Array array) {
     require_element_size_pointer(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(Any), Any_compare_dec_ignore_case);
 }
 #endif
@@ -593,6 +622,7 @@ void pa_each(Array array, AnyFn f, Any x) {
     require_not_null(array);
     require_element_size_pointer(array);
     require_not_null(f);
+    a_unshare(array);
     AnyIntAnyToAny ff = f;
     Any *a = array->a;
     for (int i = 0; i < array->n; i++) {
@@ -625,14 +655,11 @@ Array pa_map(Array array, AnyIntToAny f) {
     require_element_size_pointer(array);
     int n = array->n;
     Any *a = array->a;
-    Any *b = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    Any *b = result->a;
     for (int i = 0; i < n; i++) {
         b[i] = f(a[i], i);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = b;
     return result;
 
 }
@@ -647,14 +674,11 @@ Array pa_map(Array array, AnyFn f, Any x) {
     AnyIntAnyToAny ff = f;
     int n = array->n;
     Any *a = array->a;
-    Any *b = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    Any *b = result->a;
     for (int i = 0; i < n; i++) {
         b[i] = ff(a[i], i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = b;
     return result;
 }
 
@@ -829,17 +853,14 @@ Array pa_filter(Array array, AnyFn predicate, Any x) {
         ps[i] = f(a[i], i, x);
         if (ps[i]) n++;
     }
-    Any *b = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    Any *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = b;
     return result;
 }
 
@@ -857,17 +878,14 @@ Array pa_filter_state(Array array, AnyFn predicate, Any x, Any state) {
         ps[i] = f(a[i], i, x, state);
         if (ps[i]) n++;
     }
-    Any *b = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    Any *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = b;
     return result;
 }
 
@@ -906,13 +924,10 @@ Array pa_choose(Array array, AnyFn f, Any x) {
             b[n++] = op;
         }
     }
-    int *c = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(Any));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = c;
     return result;
 }
 
@@ -930,13 +945,10 @@ Array pa_choose_state(Array array, AnyFn f, Any x, Any state) {
             b[n++] = op;
         }
     }
-    int *c = xmalloc(n * sizeof(Any));
+    Array result = a_alloc(n, sizeof(Any), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(Any));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(Any);
-    result->a = c;
     return result;
 }
 
@@ -1074,6 +1086,7 @@ bool pa_test_equal_file_line(const char *file, const char *function, int line, A
 
 void pa_test_all(void) {
     pa_create_test();
+    pa_push_pop_test();
     a_copy_test();
     a_sub_test();
     a_concat_test();
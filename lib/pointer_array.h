@@ -53,6 +53,23 @@ Sets array element at index to value.
 void pa_set(Array array, int index, Any value);
 #endif
 
+/**
+Appends value at the end of the array. Takes amortized constant time.
+@param[in,out] array pointer array
+@param[in] value value to append
+@see a_push, a_reserve
+*/
+void pa_push(Array array, Any value);
+
+/**
+Removes the last element of the array and returns it.
+@param[in,out] array pointer array
+@return the removed element
+@pre "not empty", length > 0
+@see a_pop
+*/
+Any pa_pop(Array array);
+
 #if 0
 /**
 Prints the array.
@@ -76,27 +76,15 @@ void pl_free_with_destructor(List list, AnyFn element_destructor) {
 Any pl_get(List list, int index) {
     require_not_null(list);
     require_element_size_pointer(list);
-    int i = 0;
-    for (PointerListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            return node->value;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
-    return 0;
+    PointerListNode *node = l_node_at(list, index);
+    return node->value;
 }
 
 void pl_set(List list, int index, Any value) {
     require_not_null(list);
     require_element_size_pointer(list);
-    int i = 0;
-    for (PointerListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value = value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    PointerListNode *node = l_node_at(list, index);
+    node->value = value;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -167,7 +155,7 @@ void pl_append(List list, Any value) {
     require_not_null(list);
     require_element_size_pointer(list);
     // allocate memory for next-pointer and content
-    PointerListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    PointerListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     // if this is the first element of the list set first pointer
@@ -181,13 +169,14 @@ void pl_append(List list, Any value) {
     }
     // the new node is the last node of the list
     list->last = node;
+    list->n++;
 }
 
 void pl_prepend(List list, Any value) {
     require_not_null(list);
     require_element_size_pointer(list);
     // allocate memory for next-pointer and content
-    PointerListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    PointerListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     node->next = list->first;
@@ -195,6 +184,8 @@ void pl_prepend(List list, Any value) {
     if (list->last == NULL) {
         list->last = node;
     }
+    list->n++;
+    list->cursor_index++;
 }
 
 static void print_elem(String elem) {
@@ -805,6 +796,11 @@ bool pl_test_equal_file_line(const char *file, const char *function, int line, L
         printf("%s, line %d: Actual and expected lengths differ\n", file, line);
         return false;
     }
+    if (a->n != i || e->n != i) {
+        printf("%s, line %d: Length %d differs from the number of nodes %d\n", 
+                file, line, a->n != i ? a->n : e->n, i);
+        return false;
+    }
     printf("%s, line %d: Check passed.\n", file, line);
     base_count_success();
     return true;
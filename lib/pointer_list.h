@@ -66,7 +66,7 @@ void element_destructor(Any element) { }
 void pl_free_with_destructor(List list, AnyFn element_destructor);
 
 /**
-Returns list element at index.
+Returns list element at index. Accessing the elements in order takes amortized constant time per element (see @ref l_get).
 @param[in] list pointer list
 @param[in] index index of list element to return
 @return list element
@@ -162,7 +162,7 @@ struct Funcs {
     int line;
 };
 
-static Funcs* funcs = NULL;
+static __thread Funcs* funcs = NULL; // each thread has its own stack
 
 void push_func(const char* func, int line) {
     Funcs* f = xmalloc(sizeof(Funcs));
@@ -7,6 +7,7 @@
 #include "array.h"
 #include "string.h"
 #include "string_array.h"
+#include "array_sort.h"
 
 
 
@@ -39,14 +40,11 @@ static void sa_create_test(void) {
 
 Array sa_create(int n, String value) {
     require("non-negative length", n >= 0);
-    String *a = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *a = result->a;
     for (int i = 0; i < n; i++) {
         a[i] = value;
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = a;
     return result;
 }
 
@@ -103,7 +101,8 @@ Array sa_of_string(String s) {
     }
     
     n++; // n commas, n + 1 array elements
-    String *a = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *a = result->a;
     t = s;
     int i = 0;
     char *start = s;
@@ -117,10 +116,6 @@ Array sa_of_string(String s) {
         start = t;
     }
     a[i++] = s_sub(start, 0, t - start);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = a;
     return result;
 }
 
@@ -139,7 +134,8 @@ Array sa_split(String s, char separator) {
     }
     
     n++; // n separators, n + 1 array elements
-    String *a = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *a = result->a;
     t = s;
     int i = 0;
     char *start = s;
@@ -153,10 +149,6 @@ Array sa_split(String s, char separator) {
         start = t;
     }
     a[i++] = s_sub(start, 0, t - start);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = a;
     return result;
 }
 
@@ -232,13 +224,11 @@ static void a_sub_test(void) {
 void sa_free(Array array) {
     if (array != NULL) {
         require_element_size_string(array);
-        if (array->a != NULL) {
+        if (array->base == NULL) { // a view does not own the strings
             for (int i = 0; i < array->n; i++) {
                 String s = sa_get(array, i);
                 s_free(s);
             }
-            free(array->a);
-            array->a = NULL;
         }
         array->n = 0;
         array->s = 0;
@@ -263,11 +253,44 @@ void sa_set(Array array, int index, String value) {
     require_element_size_string(array);
     require_x("index in range", index >= 0 && index < array->n, 
             "index == %d, length == %d", index, array->n);
+    a_unshare(array);
     String *a = array->a;
     a[index] = value;
 }
 #endif
 
+static void sa_push_pop_test(void) {
+    printsln((String)__func__);
+    Array a = sa_create(0, "");
+    sa_push(a, s_copy("a"));
+    sa_push(a, s_copy("b"));
+    sa_push(a, s_copy("c"));
+    test_equal_i(a_length(a), 3);
+    test_equal_s(sa_get(a, 1), "b");
+    String s = sa_pop(a);
+    test_equal_s(s, "c");
+    s_free(s);
+    test_equal_i(a_length(a), 2);
+    sa_free(a);
+}
+
+void sa_push(Array array, String value) {
+    require_not_null(array);
+    require_element_size_string(array);
+    a_unshare(array);
+    if (array->n >= array->c) a_grow(array, 1);
+    String *a = array->a;
+    a[array->n++] = value;
+}
+
+String sa_pop(Array array) {
+    require_not_null(array);
+    require_element_size_string(array);
+    require("not empty", array->n > 0);
+    String *a = array->a;
+    return a[--array->n];
+}
+
 void sa_print(Array array) {
     require_not_null(array);
     require_element_size_string(array);
@@ -607,9 +630,69 @@ static void sa_sort_test(void) {
 void sa_sort(Array array) {
     require_not_null(array);
     require_element_size_string(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(String), string_compare);
 }
 
+static void sa_sort_from_to_test(void) {
+    printsln((String)__func__);
+    Array ac = sa_of_string("e, d, c, b, a");
+    Array ex = sa_of_string("e, b, c, d, a");
+    sa_sort_from_to(ac, 1, 4);
+    sa_test_equal(ac, ex);
+    sa_free(ac);
+    sa_free(ex);
+}
+
+void sa_sort_from_to(Array array, int from, int to) {
+    require_not_null(array);
+    require_element_size_string(array);
+    a_unshare(array);
+    if (from < 0) from = 0;
+    if (to > array->n) to = array->n;
+    if (from < to) {
+        String *a = array->a;
+        qsort(a + from, to - from, sizeof(String), string_compare);
+    }
+}
+
+static void string_sort_range(Any a, int n, int s, Comparator c) {
+    qsort(a, n, sizeof(String), string_compare);
+}
+
+static inline bool string_less(const String *x, const String *y) {
+    return s_compare(*x, *y) < 0;
+}
+
+A_MERGE_DEFINE(string_merge, String, string_less)
+
+static const ASortParallel string_sort_parallel = { string_sort_range, string_merge_split, string_merge_merge };
+
+static void sa_sort_parallel_test(void) {
+    printsln((String)__func__);
+    int n = 2 * A_SORT_PARALLEL_MIN + 5;
+    Array input = sa_create(n, NULL);
+    for (int i = 0; i < n; i++) {
+        sa_set(input, i, s_of_int(i_rnd(n)));
+    }
+    Array ex = a_copy(input); // shares the strings
+    sa_sort(ex);
+    for (int threads = 0; threads <= 3; threads++) {
+        Array ac = a_copy(input);
+        sa_sort_parallel(ac, threads);
+        sa_test_equal(ac, ex);
+        a_free(ac);
+    }
+    a_free(ex);
+    sa_free(input);
+}
+
+void sa_sort_parallel(Array array, int threads) {
+    require_not_null(array);
+    require_element_size_string(array);
+    a_sort_parallel_with(array, NULL, threads, &string_sort_parallel);
+}
+
 static CmpResult string_compare_ignore_case(ConstAny a, ConstAny b) {
     require_not_null(a);
     require_not_null(b);
@@ -622,7 +705,6 @@ void sa_sort_ignore_case(Array array);
 
 static void sa_sort_ignore_case_test(void) {
     printsln((String)__func__);
-#if 0
     Array ac, ex;
     ac = sa_of_string("a, b, c, A, B");
     ex = sa_of_string("a, A, b, B, c");
@@ -630,13 +712,13 @@ static void sa_sort_ignore_case_test(void) {
     sa_test_equal(ac, ex);
     sa_free(ac);
     sa_free(ex);
-#endif
 }
 
 void sa_sort_ignore_case(Array array) {
     require_not_null(array);
     require_element_size_string(array);
-    qsort(array->a, array->n, sizeof(String), string_compare_ignore_case);
+    a_unshare(array);
+    a_sort_stable(array, string_compare_ignore_case);
 }
 
 static CmpResult string_compare_dec(ConstAny a, ConstAny b) {
@@ -684,6 +766,7 @@ static void sa_sort_dec_test(void) {
 void sa_sort_dec(Array array) {
     require_not_null(array);
     require_element_size_string(array);
+    a_unshare(array);
     qsort(array->a, array->n, sizeof(String), string_compare_dec);
 }
 
@@ -699,7 +782,6 @@ void sa_sort_dec_ignore_case(Array array);
 
 static void sa_sort_dec_ignore_case_test(void) {
     printsln((String)__func__);
-#if 0
     Array ac, ex;
     ac = sa_of_string("a, b, c, A, B");
     ex = sa_of_string("c, b, B, a, A");
@@ -707,13 +789,13 @@ static void sa_sort_dec_ignore_case_test(void) {
     sa_test_equal(ac, ex);
     sa_free(ac);
     sa_free(ex);
-#endif
 }
 
 void sa_sort_dec_ignore_case(Array array) {
     require_not_null(array);
     require_element_size_string(array);
-    qsort(array->a, array->n, sizeof(String), string_compare_dec_ignore_case);
+    a_unshare(array);
+    a_sort_stable(array, string_compare_dec_ignore_case);
 }
 
 #if 0
@@ -732,6 +814,7 @@ void sa_each(Array array, StringIntStringToString f, String x) {
     require_not_null(array);
     require_not_null(f);
     require_element_size_string(array);
+    a_unshare(array);
     String *a = array->a;
     for (int i = 0; i < array->n; i++) {
         a[i] = f(a[i], i, x);
@@ -746,14 +829,11 @@ Array sa_map(Array array, StringIntStringToString f, String x) {
     require_element_size_string(array);
     int n = array->n;
     String *a = array->a;
-    String *b = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *b = result->a;
     for (int i = 0; i < n; i++) {
         b[i] = f(a[i], i, x);
     }
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = b;
     return result;
 }
 
@@ -930,17 +1010,14 @@ Array sa_filter(Array array, StringIntStringToBool predicate, String x) {
         ps[i] = predicate(a[i], i, x);
         if (ps[i]) n++;
     }
-    String *b = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = b;
     return result;
 }
 
@@ -957,17 +1034,14 @@ Array sa_filter_state(Array array, StringIntStringAnyToBool predicate, String x,
         ps[i] = predicate(a[i], i, x, state);
         if (ps[i]) n++;
     }
-    String *b = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    String *b = result->a;
     for (int i = 0, j = 0; i < array->n; i++) {
         if (ps[i]) {
             b[j++] = a[i];
         }
     }
     free(ps);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = b;
     return result;
 }
 
@@ -1006,13 +1080,10 @@ Array sa_choose(Array array, StringIntStringToStringOption f, String x) {
             b[n++] = op.some;
         }
     }
-    int *c = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(String));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = c;
     return result;
 }
 
@@ -1029,13 +1100,10 @@ Array sa_choose_state(Array array, StringIntStringAnyToStringOption f, String x,
             b[n++] = op.some;
         }
     }
-    int *c = xmalloc(n * sizeof(String));
+    Array result = a_alloc(n, sizeof(String), false);
+    int *c = result->a;
     memcpy(c, b, n * sizeof(String));
     free(b);
-    Array result = xmalloc(sizeof(ArrayHead));
-    result->n = n;
-    result->s = sizeof(String);
-    result->a = c;
     return result;
 }
 
@@ -1175,6 +1243,7 @@ bool sa_test_equal_file_line(const char *file, const char *function, int line, A
 
 void sa_test_all(void) {
     sa_create_test();
+    sa_push_pop_test();
     sa_of_string_test();
     a_copy_test();
     a_sub_test();
@@ -1191,6 +1260,8 @@ void sa_test_all(void) {
     sa_reverse_test();
     sa_shuffle_test();
     sa_sort_test();
+    sa_sort_from_to_test();
+    sa_sort_parallel_test();
     sa_sort_ignore_case_test();
     sa_sort_dec_test();
     sa_sort_dec_ignore_case_test();
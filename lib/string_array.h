@@ -77,6 +77,23 @@ Sets array element at index to value.
 void sa_set(Array array, int index, String value);
 #endif
 
+/**
+Appends value at the end of the array. Takes amortized constant time. The array takes ownership of the string, like with @ref sa_set.
+@param[in,out] array String array
+@param[in] value value to append
+@see a_push, a_reserve
+*/
+void sa_push(Array array, String value);
+
+/**
+Removes the last element of the array and returns it. The caller takes ownership of the string.
+@param[in,out] array String array
+@return the removed element
+@pre "not empty", length > 0
+@see a_pop
+*/
+String sa_pop(Array array);
+
 /**
 Prints the array.
 @param[in] array String array
@@ -171,7 +188,24 @@ Sorts the elements in increasing order. The input array is modified.
 void sa_sort(Array array);
 
 /**
-Sorts the elements in increasing order, ignoring lower/upper case. The input array is modified.
+Sorts the elements array[from, to) in increasing order. The other elements are not touched. Index from is inclusive, index to is exclusive. Indices outside of the array are clamped to the array.
+@param[in,out] array String array
+@param[in] from start index (inclusive)
+@param[in] to end index (exclusive)
+@see a_view
+*/
+void sa_sort_from_to(Array array, int from, int to);
+
+/**
+Sorts the elements in increasing order with the given number of threads. The result is the same as that of @ref sa_sort. Each thread sorts a range of the array, then the ranges are merged (see @ref a_sort_parallel). Arrays of less than 2 * @ref A_SORT_PARALLEL_MIN elements are sorted by the calling thread alone. The input array is modified.
+@param[in,out] array String array
+@param[in] threads number of threads, 0 for one per processor
+@pre "non-negative thread count", threads >= 0
+*/
+void sa_sort_parallel(Array array, int threads);
+
+/**
+Sorts the elements in increasing order, ignoring lower/upper case. Strings that differ only in case keep their relative order (see @ref a_sort_stable). The input array is modified.
 @param[in,out] array String array
 */
 void sa_sort_ignore_case(Array array);
@@ -183,7 +217,7 @@ Sortis the elements in decreasing order.The input array is modified.
 void sa_sort_dec(Array array);
 
 /**
-Sorts the elements in decreasing order, ignoring lower/upper case. The input array is modified.
+Sorts the elements in decreasing order, ignoring lower/upper case. Strings that differ only in case keep their relative order (see @ref a_sort_stable). The input array is modified.
 @param[in,out] array String array
 */
 void sa_sort_dec_ignore_case(Array array);
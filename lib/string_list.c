@@ -154,6 +154,53 @@ static void sl_split_test(void) {
     l_free(ex);
 }
 
+static void sl_split_arena_test(void) {
+    printsln((String)__func__);
+    List ac, ex;
+    String s;
+
+    ex = sl_create();
+    sl_append(ex, "alpha");
+    sl_append(ex, "beta");
+    sl_append(ex, "gamma");
+
+    Arena arena = arena_create(64);
+    test_equal_b(arena_current() == NULL, true);
+    for (int i = 0; i < 3; i++) {
+        arena_enter(arena);
+        test_equal_b(arena_current() == arena, true);
+        ac = sl_split("alpha beta gamma", ' ');
+        s = s_join(ac, ',');
+        sl_free(ac); // no effect in an arena
+        ac = sl_split(s, ',');
+        arena_leave();
+        test_equal_b(arena_current() == NULL, true);
+        sl_test_equal(ac, ex);
+        test_equal_s(s, "alpha,beta,gamma");
+        test_equal_b(arena_bytes(arena) > 0, true);
+        arena_reset(arena);
+        test_equal_i(arena_bytes(arena), 0);
+    }
+
+    // nested arenas, blocks larger than a chunk, resizing arena blocks
+    Arena inner = arena_create(64);
+    arena_enter(arena);
+    String t = xcalloc(200, 1);
+    arena_enter(inner);
+    test_equal_b(arena_current() == inner, true);
+    t = xrealloc(t, 300); // stays in its arena
+    s = s_repeat(100, 'x');
+    arena_leave();
+    test_equal_b(arena_current() == arena, true);
+    arena_leave();
+    test_equal_i(t[199], 0);
+    test_equal_i(s_length(s), 100);
+    arena_free(inner);
+    arena_free(arena);
+
+    l_free(ex);
+}
+
 List sl_split(String s, char separator) {
     require_not_null(s);
     List list = sl_create();
@@ -245,28 +292,16 @@ void sl_free(List list) {
 String sl_get(List list, int index) {
     require_not_null(list);
     require_element_size_string(list);
-    int i = 0;
-    for (StringListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            return node->value;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
-    return 0;
+    StringListNode *node = l_node_at(list, index);
+    return node->value;
 }
 
 void sl_set(List list, int index, String value) {
     require_not_null(list);
     require_element_size_string(list);
     require_not_null(value);
-    int i = 0;
-    for (StringListNode *node = list->first; node != NULL; node = node->next, i++) {
-        if (i == index) {
-            node->value = value;
-            return;
-        }
-    }
-    require_x("index in range", false, "index == %d", index);
+    StringListNode *node = l_node_at(list, index);
+    node->value = value;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -336,7 +371,7 @@ void sl_append(List list, String value) {
     require_element_size_string(list);
     require_not_null(value);
     // allocate memory for next-pointer and content
-    StringListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    StringListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     // if this is the first element of the list set first pointer
@@ -350,6 +385,7 @@ void sl_append(List list, String value) {
     }
     // the new node is the last node of the list
     list->last = node;
+    list->n++;
 }
 
 void sl_prepend(List list, String value) {
@@ -357,7 +393,7 @@ void sl_prepend(List list, String value) {
     require_element_size_string(list);
     require_not_null(value);
     // allocate memory for next-pointer and content
-    StringListNode *node = xcalloc(1, sizeof(ListNode*) + sizeof(value));
+    StringListNode *node = l_node_alloc(list);
     // copy content, leave next-pointer NULL
     node->value = value;
     node->next = list->first;
@@ -365,6 +401,8 @@ void sl_prepend(List list, String value) {
     if (list->last == NULL) {
         list->last = node;
     }
+    list->n++;
+    list->cursor_index++;
 }
 
 void sl_print(List list) {
@@ -626,6 +664,43 @@ List sl_sort_dec(List list) {
     return l_sort(list, String_compare_dec);
 }
 
+void sl_sort_inplace(List list);
+
+static void sl_sort_inplace_test(void) {
+    printsln((String)__func__);
+    List ac, ex;
+
+    ac = sl_of_string("e, d, c, b, a");
+    ex = sl_of_string("a, b, c, d, e, f");
+    sl_sort_inplace(ac);
+    sl_append(ac, s_copy("f"));
+    sl_test_equal(ac, ex);
+    sl_free(ac);
+    sl_free(ex);
+
+    ac = sl_of_string("-1, -2, -3, -1");
+    ex = sl_of_string("-1, -1, -2, -3"); // alphabetic, not numeric sort
+    String first = sl_get(ac, 0);
+    sl_sort_inplace(ac);
+    sl_test_equal(ac, ex);
+    test_equal_b(sl_get(ac, 0) == first, true); // stable, the strings are not copied
+    sl_free(ac);
+    sl_free(ex);
+
+    ac = sl_of_string("");
+    ex = sl_of_string("");
+    sl_sort_inplace(ac);
+    sl_test_equal(ac, ex);
+    sl_free(ac);
+    sl_free(ex);
+}
+
+void sl_sort_inplace(List list) {
+    require_not_null(list);
+    require_element_size_string(list);
+    l_sort_inplace(list, String_compare);
+}
+
 void sl_insert(List list, int index, String value);
 
 static void sl_insert_test(void) {
@@ -1217,6 +1292,11 @@ bool sl_test_equal_file_line(const char *file, const char *function, int line, L
         printf("%s, line %d: Actual and expected lengths differ\n", file, line);
         return false;
     }
+    if (a->n != i || e->n != i) {
+        printf("%s, line %d: Length %d differs from the number of nodes %d\n", 
+                file, line, a->n != i ? a->n : e->n, i);
+        return false;
+    }
     printf("%s, line %d: Check passed.\n", file, line);
     base_count_success();
     return true;
@@ -1258,6 +1338,7 @@ void sl_test_all(void) {
     sl_repeat_test();
     sl_of_string_test();
     sl_split_test();
+    sl_split_arena_test();
     s_join_test();
     sl_prepend_append_test();
     sl_iterator_test();
@@ -1267,6 +1348,7 @@ void sl_test_all(void) {
     sl_index_fn_test();
     sl_sort_test();
     sl_sort_dec_test();
+    sl_sort_inplace_test();
     sl_insert_test();
     sl_remove_test();
     sl_each_test();
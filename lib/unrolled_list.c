@@ -0,0 +1,1180 @@
+/*
+@copyright Apache License, Version 2.0
+*/
+
+#include "unrolled_list.h"
+#include "list.h"
+#include "int_list.h"
+#include "double_list.h"
+#include "string_list.h"
+
+/*
+ * Each chunk holds the elements of about UL_CHUNK_BYTES bytes, but at least
+ * UL_CHUNK_MIN elements. Each chunk except the last holds at least c / 2
+ * elements, thus only the last chunk may be empty.
+ */
+#define UL_CHUNK_BYTES 256
+#define UL_CHUNK_MIN 4
+
+/*
+ * Address of element i of a chunk.
+ */
+#define ELEMENT(list, chunk, i) ((Byte*)((UListChunk*)(chunk) + 1) + (size_t)(i) * (list)->s)
+
+static UListChunk *ul_chunk_alloc(UList list) {
+    UListChunk *chunk = xmalloc(sizeof(UListChunk) + (size_t)list->c * list->s);
+    chunk->next = NULL;
+    chunk->n = 0;
+    chunk->padding = 0;
+    return chunk;
+}
+
+/*
+ * Returns the chunk that contains the element at index (0 <= index < n) and
+ * moves the cursor there. The index of its first element is stored in start.
+ */
+static UListChunk *ul_chunk_at(UList list, int index, int *start) {
+    UListChunk *chunk = list->cursor;
+    int i = list->cursor_index;
+    if (chunk != NULL && index >= i && index < i + chunk->n) {
+        *start = i;
+        return chunk;
+    }
+    chunk = list->first;
+    i = 0;
+    if (index >= list->n - list->last->n) {
+        chunk = list->last;
+        i = list->n - list->last->n;
+    } else if (list->cursor != NULL && list->cursor_index <= index) {
+        chunk = list->cursor;
+        i = list->cursor_index;
+    }
+    while (index >= i + chunk->n) {
+        i += chunk->n;
+        chunk = chunk->next;
+    }
+    list->cursor = chunk;
+    list->cursor_index = i;
+    *start = i;
+    return chunk;
+}
+
+// Checks the structure of the list: element count, chunk fill, last chunk,
+// and cursor.
+static bool ul_check(UList list) {
+    int n = 0;
+    bool cursor_found = list->cursor == NULL;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        if (chunk->n > list->c) return false;
+        if (chunk->next != NULL && chunk->n < list->c / 2) return false;
+        if (chunk->next == NULL && chunk != list->last) return false;
+        if (chunk == list->cursor) {
+            if (list->cursor_index != n) return false;
+            cursor_found = true;
+        }
+        n += chunk->n;
+    }
+    return n == list->n && cursor_found;
+}
+
+static void ul_create_test(void) {
+    printsln((String)__func__);
+    UList list = ul_create(sizeof(int));
+    test_equal_i(ul_length(list), 0);
+    test_equal_i(list->c, 64);
+    test_equal_b(ul_has_next(ul_iterator(list)), false);
+    ul_free(list);
+
+    list = ul_create(sizeof(double));
+    test_equal_i(list->c, 32);
+    ul_free(list);
+
+    Byte big[1000];
+    list = ul_create(sizeof(big));
+    test_equal_i(list->c, UL_CHUNK_MIN);
+    ul_free(list);
+}
+
+UList ul_create(int s) {
+    require("positive size", s > 0);
+    UListHead *list = xcalloc(1, sizeof(UListHead));
+    list->s = s;
+    list->c = UL_CHUNK_BYTES / s;
+    if (list->c < UL_CHUNK_MIN) list->c = UL_CHUNK_MIN;
+    return list;
+}
+
+static void ul_of_l_test(void) {
+    printsln((String)__func__);
+    List a = il_of_string("1, 2, 3, 4, 5");
+    UList b = ul_of_l(a);
+    test_equal_i(ul_length(b), 5);
+    test_equal_i(uil_get(b, 0), 1);
+    test_equal_i(uil_get(b, 4), 5);
+    List c = l_of_ul(b);
+    il_test_equal(c, a);
+    l_free(a);
+    ul_free(b);
+    l_free(c);
+
+    a = il_create();
+    b = ul_of_l(a);
+    test_equal_i(ul_length(b), 0);
+    c = l_of_ul(b);
+    il_test_equal(c, a);
+    l_free(a);
+    ul_free(b);
+    l_free(c);
+}
+
+UList ul_of_l(List list) {
+    require_not_null(list);
+    UList result = ul_create(list->s);
+    for (ListNode *node = list->first; node != NULL; node = node->next) {
+        ul_append(result, node + 1);
+    }
+    return result;
+}
+
+List l_of_ul(UList list) {
+    require_not_null(list);
+    List result = l_create(list->s);
+    UListIterator iter = ul_iterator(list);
+    while (ul_has_next(iter)) {
+        l_append(result, ul_next(&iter));
+    }
+    return result;
+}
+
+void ul_free(UList list) {
+    if (list != NULL) {
+        UListChunk *next = NULL;
+        for (UListChunk *chunk = list->first; chunk != NULL; chunk = next) {
+            next = chunk->next;
+            free(chunk);
+        }
+        list->n = 0;
+        list->first = NULL;
+        list->last = NULL;
+        list->cursor = NULL;
+        free(list);
+    }
+}
+
+int ul_length(UList list) {
+    require_not_null(list);
+    return list->n;
+}
+
+static void ul_footprint_test(void) {
+    printsln((String)__func__);
+    UList a = uil_create();
+    Footprint head = memory_footprint(a, 0);
+    Footprint f = ul_footprint(a);
+    test_equal_i(f.payload, 0);
+    test_equal_i(f.structure, head.structure);
+    test_equal_i(f.tracker, head.tracker);
+    for (int i = 0; i < 1000; i++) {
+        uil_append(a, i);
+    }
+    // 16 chunks, the last one is partially filled
+    f = ul_footprint(a);
+    test_equal_i(f.payload, 1000 * sizeof(int));
+    test_equal_b(f.structure >= head.structure + 16 * sizeof(UListChunk) + (16 * 64 - 1000) * sizeof(int), true);
+
+    // the same elements in a list cost about 5 times as much
+    List b = il_create();
+    for (int i = 0; i < 1000; i++) {
+        il_append(b, i);
+    }
+    Footprint g = l_footprint(b);
+    test_equal_i(g.payload, f.payload);
+    test_equal_b(2 * (f.payload + f.structure + f.tracker) < g.payload + g.structure + g.tracker, true);
+    l_free(b);
+    ul_free(a);
+}
+
+Footprint ul_footprint(UList list) {
+    require_not_null(list);
+    Footprint f = memory_footprint(list, 0);
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        Footprint e = memory_footprint(chunk, (size_t)chunk->n * list->s);
+        f.payload += e.payload;
+        f.structure += e.structure;
+        f.tracker += e.tracker;
+    }
+    return f;
+}
+
+static void ul_get_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, i);
+    }
+    bool ok = true;
+    for (int i = 0; i < 200; i++) {
+        ok = ok && uil_get(list, i) == i;
+    }
+    for (int i = 199; i >= 0; i -= 7) {
+        ok = ok && uil_get(list, i) == i;
+    }
+    test_equal_b(ok, true);
+    test_equal_b(ul_check(list), true);
+    for (int i = 0; i < 200; i++) {
+        uil_set(list, i, 2 * i);
+    }
+    int sum = 0;
+    for (int i = 0; i < 200; i++) {
+        sum += uil_get(list, i);
+    }
+    test_equal_i(sum, 199 * 200);
+    test_equal_i(*(int*)ul_get(list, 100), 200);
+    int x = 7;
+    ul_set(list, 100, &x);
+    test_equal_i(uil_get(list, 100), 7);
+    ul_free(list);
+}
+
+Any ul_get(UList list, int index) {
+    require_not_null(list);
+    require_x("index in range", index >= 0 && index < list->n, "index == %d, length == %d", index, list->n);
+    int start;
+    UListChunk *chunk = ul_chunk_at(list, index, &start);
+    return ELEMENT(list, chunk, index - start);
+}
+
+void ul_set(UList list, int index, Any value) {
+    require_not_null(list);
+    require_x("index in range", index >= 0 && index < list->n, "index == %d, length == %d", index, list->n);
+    int start;
+    UListChunk *chunk = ul_chunk_at(list, index, &start);
+    memcpy(ELEMENT(list, chunk, index - start), value, list->s);
+}
+
+/*
+ * Appends a zero-initialized element and returns its address.
+ */
+static Any ul_append_empty(UList list) {
+    if (list->last == NULL || list->last->n == list->c) {
+        UListChunk *chunk = ul_chunk_alloc(list);
+        if (list->last == NULL) {
+            list->first = chunk;
+        } else {
+            list->last->next = chunk;
+        }
+        list->last = chunk;
+    }
+    Any element = ELEMENT(list, list->last, list->last->n);
+    memset(element, 0, list->s);
+    list->last->n++;
+    list->n++;
+    return element;
+}
+
+void ul_append(UList list, Any value) {
+    require_not_null(list);
+    memcpy(ul_append_empty(list), value, list->s);
+}
+
+void ul_prepend(UList list, Any value) {
+    ul_insert(list, 0, value);
+}
+
+static void ul_insert_test(void) {
+    printsln((String)__func__);
+    // inserting at the front splits full chunks
+    UList list = uil_create();
+    int x;
+    for (int i = 0; i < 300; i++) {
+        x = 299 - i;
+        ul_prepend(list, &x);
+    }
+    test_equal_b(ul_check(list), true);
+    bool ok = true;
+    for (int i = 0; i < 300; i++) {
+        ok = ok && uil_get(list, i) == i;
+    }
+    test_equal_b(ok, true);
+
+    // inserting in the middle
+    uil_insert(list, 150, -1);
+    uil_insert(list, 300, -2);
+    uil_insert(list, 302, -3);
+    uil_insert(list, 304, -4); // invalid index
+    uil_insert(list, -1, -4); // invalid index
+    test_equal_i(ul_length(list), 303);
+    test_equal_i(uil_get(list, 149), 149);
+    test_equal_i(uil_get(list, 150), -1);
+    test_equal_i(uil_get(list, 151), 150);
+    test_equal_i(uil_get(list, 300), -2);
+    test_equal_i(uil_get(list, 302), -3);
+    test_equal_b(ul_check(list), true);
+    ul_free(list);
+
+    // inserting into an empty list
+    list = uil_create();
+    uil_insert(list, 0, 5);
+    test_equal_i(ul_length(list), 1);
+    test_equal_i(uil_get(list, 0), 5);
+    ul_free(list);
+}
+
+void ul_insert(UList list, int index, Any value) {
+    require_not_null(list);
+    if (index < 0 || index > list->n) return;
+    if (index == list->n) {
+        ul_append(list, value);
+        return;
+    }
+    int start;
+    UListChunk *chunk = ul_chunk_at(list, index, &start);
+    int i = index - start;
+    if (chunk->n == list->c) {
+        // split: the upper half moves to a new chunk after this one
+        UListChunk *upper = ul_chunk_alloc(list);
+        int h = list->c / 2;
+        upper->n = list->c - h;
+        memcpy(ELEMENT(list, upper, 0), ELEMENT(list, chunk, h), (size_t)upper->n * list->s);
+        chunk->n = h;
+        upper->next = chunk->next;
+        chunk->next = upper;
+        if (list->last == chunk) list->last = upper;
+        if (i > h) {
+            chunk = upper;
+            i -= h;
+        }
+    }
+    memmove(ELEMENT(list, chunk, i + 1), ELEMENT(list, chunk, i), (size_t)(chunk->n - i) * list->s);
+    memcpy(ELEMENT(list, chunk, i), value, list->s);
+    chunk->n++;
+    list->n++;
+}
+
+static void ul_remove_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 300; i++) {
+        uil_append(list, i);
+    }
+    // removing from the front merges chunks
+    for (int i = 0; i < 100; i++) {
+        ul_remove(list, 0);
+    }
+    test_equal_b(ul_check(list), true);
+    test_equal_i(ul_length(list), 200);
+    test_equal_i(uil_get(list, 0), 100);
+    test_equal_i(uil_get(list, 199), 299);
+
+    // removing every other element
+    for (int i = 0; i < 100; i++) {
+        ul_remove(list, i);
+    }
+    test_equal_b(ul_check(list), true);
+    bool ok = true;
+    for (int i = 0; i < 100; i++) {
+        ok = ok && uil_get(list, i) == 101 + 2 * i;
+    }
+    test_equal_b(ok, true);
+
+    ul_remove(list, 100); // invalid index
+    ul_remove(list, -1); // invalid index
+    test_equal_i(ul_length(list), 100);
+
+    // removing from the back leaves an empty last chunk, which is reused
+    while (ul_length(list) > 0) {
+        ul_remove(list, ul_length(list) - 1);
+        ok = ok && ul_check(list);
+    }
+    test_equal_b(ok, true);
+    test_equal_b(ul_has_next(ul_iterator(list)), false);
+    uil_append(list, 1);
+    test_equal_i(uil_get(list, 0), 1);
+    test_equal_b(ul_check(list), true);
+    ul_free(list);
+}
+
+void ul_remove(UList list, int index) {
+    require_not_null(list);
+    if (index < 0 || index >= list->n) return;
+    int start;
+    UListChunk *chunk = ul_chunk_at(list, index, &start);
+    int i = index - start;
+    memmove(ELEMENT(list, chunk, i), ELEMENT(list, chunk, i + 1), (size_t)(chunk->n - i - 1) * list->s);
+    chunk->n--;
+    list->n--;
+    UListChunk *next = chunk->next;
+    if (next != NULL && chunk->n < list->c / 2) {
+        if (chunk->n + next->n <= list->c) {
+            // merge the next chunk into this one
+            memcpy(ELEMENT(list, chunk, chunk->n), ELEMENT(list, next, 0), (size_t)next->n * list->s);
+            chunk->n += next->n;
+            chunk->next = next->next;
+            if (list->last == next) list->last = chunk;
+            free(next);
+        } else {
+            // take elements from the next chunk, such that both are at least half full
+            int k = (next->n - chunk->n) / 2;
+            memcpy(ELEMENT(list, chunk, chunk->n), ELEMENT(list, next, 0), (size_t)k * list->s);
+            memmove(ELEMENT(list, next, 0), ELEMENT(list, next, k), (size_t)(next->n - k) * list->s);
+            chunk->n += k;
+            next->n -= k;
+        }
+    }
+}
+
+static void ul_iterator_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 1000; i++) {
+        uil_append(list, i);
+    }
+    int sum = 0, count = 0;
+    UListIterator iter = ul_iterator(list);
+    while (ul_has_next(iter)) {
+        sum += uil_next(&iter);
+        count++;
+    }
+    test_equal_i(count, 1000);
+    test_equal_i(sum, 999 * 1000 / 2);
+
+    // an empty last chunk is skipped
+    for (int i = 0; i < 1000 - 960; i++) {
+        ul_remove(list, ul_length(list) - 1);
+    }
+    test_equal_i(list->last->n, 0);
+    count = 0;
+    iter = ul_iterator(list);
+    while (ul_has_next(iter)) {
+        if (uil_next(&iter) == count) count++;
+    }
+    test_equal_i(count, 960);
+
+    // iterating by chunks
+    count = 0;
+    sum = 0;
+    iter = ul_iterator(list);
+    while (ul_has_next(iter)) {
+        int n;
+        int *a = ul_next_chunk(&iter, &n);
+        for (int i = 0; i < n; i++) sum += a[i];
+        count += n;
+    }
+    test_equal_i(count, 960);
+    test_equal_i(sum, 959 * 960 / 2);
+
+    // the rest of a partially iterated chunk
+    iter = ul_iterator(list);
+    test_equal_i(uil_next(&iter), 0);
+    int n;
+    int *a = ul_next_chunk(&iter, &n);
+    test_equal_i(n, 63);
+    test_equal_i(a[0], 1);
+    test_equal_i(uil_next(&iter), 64);
+    ul_free(list);
+}
+
+UListIterator ul_iterator(UList list) {
+    require_not_null(list);
+    // only the last chunk may be empty, then the iteration is over
+    UListIterator iter = { list->n > 0 ? list->first : NULL, 0, list->s };
+    return iter;
+}
+
+bool ul_has_next(UListIterator iter) {
+    return iter.chunk != NULL;
+}
+
+Any ul_next(UListIterator *iter) {
+    UListChunk *chunk = iter->chunk;
+    require("iterator has more values", chunk != NULL);
+    Any value = (Byte*)(chunk + 1) + (size_t)iter->i * iter->s;
+    if (++iter->i == chunk->n) {
+        chunk = chunk->next;
+        iter->chunk = chunk != NULL && chunk->n > 0 ? chunk : NULL;
+        iter->i = 0;
+    }
+    return value;
+}
+
+Any ul_next_chunk(UListIterator *iter, int *n) {
+    UListChunk *chunk = iter->chunk;
+    require("iterator has more values", chunk != NULL);
+    require_not_null(n);
+    Any values = (Byte*)(chunk + 1) + (size_t)iter->i * iter->s;
+    *n = chunk->n - iter->i;
+    chunk = chunk->next;
+    iter->chunk = chunk != NULL && chunk->n > 0 ? chunk : NULL;
+    iter->i = 0;
+    return values;
+}
+
+static void ul_inc_in_place(int *element, int index, Any state) {
+    *element += index + *(int*)state;
+}
+
+static void ul_each_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, i);
+    }
+    int x = 1;
+    ul_each(list, ul_inc_in_place, &x);
+    bool ok = true;
+    for (int i = 0; i < 200; i++) {
+        ok = ok && uil_get(list, i) == 2 * i + 1;
+    }
+    test_equal_b(ok, true);
+    ul_free(list);
+
+    list = uil_create();
+    ul_each(list, ul_inc_in_place, &x);
+    test_equal_i(ul_length(list), 0);
+    ul_free(list);
+}
+
+void ul_each(UList list, AnyFn f, Any state) {
+    require_not_null(list);
+    require_not_null(f);
+    AnyIntAnyToVoid ff = f;
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        for (int j = 0; j < chunk->n; j++, i++) {
+            ff(ELEMENT(list, chunk, j), i, state);
+        }
+    }
+}
+
+static void ul_int_pair(int *element, int index, Any state, IntPair *mapped_element) {
+    mapped_element->i = *element;
+    mapped_element->j = index;
+}
+
+static void ul_map_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, 3 * i);
+    }
+    UList mapped = ul_map(list, ul_int_pair, sizeof(IntPair), NULL);
+    test_equal_i(ul_length(mapped), 200);
+    test_equal_i(mapped->c, 32);
+    bool ok = true;
+    for (int i = 0; i < 200; i++) {
+        IntPair *ip = ul_get(mapped, i);
+        ok = ok && ip->i == 3 * i && ip->j == i;
+    }
+    test_equal_b(ok, true);
+    test_equal_b(ul_check(mapped), true);
+    ul_free(mapped);
+    ul_free(list);
+}
+
+UList ul_map(UList list, AnyFn f, int mapped_element_size, Any state) {
+    require_not_null(list);
+    require_not_null(f);
+    require("positive size", mapped_element_size > 0);
+    AnyIntAnyAnyToVoid ff = f;
+    UList result = ul_create(mapped_element_size);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        for (int j = 0; j < chunk->n; j++, i++) {
+            ff(ELEMENT(list, chunk, j), i, state, ul_append_empty(result));
+        }
+    }
+    return result;
+}
+
+static void ul_sum(int *state, int *element, int index) {
+    *state += *element;
+}
+
+static void ul_foldl_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    int sum = 0;
+    ul_foldl(list, ul_sum, &sum);
+    test_equal_i(sum, 0);
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, i);
+    }
+    ul_foldl(list, ul_sum, &sum);
+    test_equal_i(sum, 199 * 200 / 2);
+    ul_free(list);
+}
+
+void ul_foldl(UList list, AnyFn f, Any state) {
+    require_not_null(list);
+    require_not_null(f);
+    AnyAnyIntToVoid ff = f;
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        for (int j = 0; j < chunk->n; j++, i++) {
+            ff(state, ELEMENT(list, chunk, j), i);
+        }
+    }
+}
+
+static bool ul_multiple_of(int *element, int index, Any state) {
+    return *element % *(int*)state == 0;
+}
+
+static void ul_filter_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, i);
+    }
+    int x = 3;
+    UList filtered = ul_filter(list, ul_multiple_of, &x);
+    test_equal_i(ul_length(filtered), 67);
+    bool ok = true;
+    for (int i = 0; i < 67; i++) {
+        ok = ok && uil_get(filtered, i) == 3 * i;
+    }
+    test_equal_b(ok, true);
+    test_equal_b(ul_check(filtered), true);
+    ul_free(filtered);
+
+    x = 1000;
+    filtered = ul_filter(list, ul_multiple_of, &x);
+    test_equal_i(ul_length(filtered), 1);
+    test_equal_i(uil_get(filtered, 0), 0);
+    ul_free(filtered);
+    ul_free(list);
+}
+
+UList ul_filter(UList list, AnyFn predicate, Any state) {
+    require_not_null(list);
+    require_not_null(predicate);
+    AnyIntAnyToBool f = predicate;
+    UList result = ul_create(list->s);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        for (int j = 0; j < chunk->n; j++, i++) {
+            Any element = ELEMENT(list, chunk, j);
+            if (f(element, i, state)) {
+                ul_append(result, element);
+            }
+        }
+    }
+    return result;
+}
+
+static void ul_random_test(void) {
+    printsln((String)__func__);
+    // random mix of indexed accesses and mutations, compared to an array,
+    // with small chunks such that chunks are often split and merged
+    int m = 300;
+    int *ex = xmalloc(m * sizeof(int));
+    int n = 0;
+    Byte e[40] = { 0 };
+    UList ac = ul_create(sizeof(e));
+    test_equal_i(ac->c, 6);
+    bool ok = true;
+    for (int r = 0; r < 20000; r++) {
+        int op = i_rnd(6);
+        int index = i_rnd(n + 3) - 1; // also out of range
+        int value = r;
+        memcpy(e, &value, sizeof(int));
+        if (op == 0 && n < m) {
+            ul_append(ac, e);
+            ex[n++] = value;
+        } else if (op == 1 && n < m) {
+            ul_prepend(ac, e);
+            memmove(ex + 1, ex, n * sizeof(int));
+            ex[0] = value;
+            n++;
+        } else if (op == 2 && n < m) {
+            ul_insert(ac, index, e);
+            if (index >= 0 && index <= n) {
+                memmove(ex + index + 1, ex + index, (n - index) * sizeof(int));
+                ex[index] = value;
+                n++;
+            }
+        } else if (op == 3) {
+            ul_remove(ac, index);
+            if (index >= 0 && index < n) {
+                memmove(ex + index, ex + index + 1, (n - index - 1) * sizeof(int));
+                n--;
+            }
+        } else if (op == 4 && n > 0) {
+            index = i_rnd(n);
+            ul_set(ac, index, e);
+            ex[index] = value;
+        } else if (n > 0) {
+            index = i_rnd(n);
+            ok = ok && *(int*)ul_get(ac, index) == ex[index];
+        }
+        ok = ok && ul_length(ac) == n && ul_check(ac);
+    }
+    int i = 0;
+    UListIterator iter = ul_iterator(ac);
+    while (ul_has_next(iter)) {
+        ok = ok && i < n && *(int*)ul_next(&iter) == ex[i];
+        i++;
+    }
+    test_equal_b(ok, true);
+    test_equal_i(i, n);
+    ul_free(ac);
+    free(ex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Lists of ints
+
+UList uil_create(void) {
+    return ul_create(sizeof(int));
+}
+
+int uil_get(UList list, int index) {
+    require_not_null(list);
+    require_element_size_int(list);
+    return *(int*)ul_get(list, index);
+}
+
+void uil_set(UList list, int index, int value) {
+    require_not_null(list);
+    require_element_size_int(list);
+    ul_set(list, index, &value);
+}
+
+void uil_append(UList list, int value) {
+    require_not_null(list);
+    require_element_size_int(list);
+    ul_append(list, &value);
+}
+
+void uil_insert(UList list, int index, int value) {
+    require_not_null(list);
+    require_element_size_int(list);
+    ul_insert(list, index, &value);
+}
+
+int uil_next(UListIterator *iter) {
+    require("element size int", iter->s == sizeof(int));
+    UListChunk *chunk = iter->chunk;
+    require("iterator has more values", chunk != NULL);
+    int value = ((int*)(chunk + 1))[iter->i];
+    if (++iter->i == chunk->n) {
+        chunk = chunk->next;
+        iter->chunk = chunk != NULL && chunk->n > 0 ? chunk : NULL;
+        iter->i = 0;
+    }
+    return value;
+}
+
+static void uil_functional_test(void) {
+    printsln((String)__func__);
+    UList list = uil_create();
+    for (int i = 0; i < 200; i++) {
+        uil_append(list, i);
+    }
+    uil_each(list, il_times, 2);
+    test_equal_i(uil_get(list, 199), 398);
+    UList mapped = uil_map(list, il_times, 3);
+    test_equal_i(ul_length(mapped), 200);
+    test_equal_i(uil_get(mapped, 100), 600);
+    UList filtered = uil_filter(mapped, il_gt, 1000);
+    test_equal_i(ul_length(filtered), 33);
+    test_equal_i(uil_get(filtered, 0), 1002);
+    test_equal_i(uil_foldl(filtered, int_plus, 0), 3 * 2 * (167 + 199) * 33 / 2);
+    test_equal_i(uil_foldl(filtered, int_minus, 0), -3 * 2 * (167 + 199) * 33 / 2);
+    ul_free(filtered);
+    ul_free(mapped);
+    ul_free(list);
+}
+
+void uil_each(UList list, IntIntIntToInt f, int x) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_int(list);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        int *a = (int*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            a[j] = f(a[j], i, x);
+        }
+    }
+}
+
+UList uil_map(UList list, IntIntIntToInt f, int x) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_int(list);
+    UList result = uil_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        int *a = (int*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            uil_append(result, f(a[j], i, x));
+        }
+    }
+    return result;
+}
+
+int uil_foldl(UList list, IntIntIntToInt f, int init) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_int(list);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        int *a = (int*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            init = f(init, a[j], i);
+        }
+    }
+    return init;
+}
+
+UList uil_filter(UList list, IntIntIntToBool predicate, int x) {
+    require_not_null(predicate);
+    require_not_null(list);
+    require_element_size_int(list);
+    UList result = uil_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        int *a = (int*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            if (predicate(a[j], i, x)) {
+                uil_append(result, a[j]);
+            }
+        }
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Lists of doubles
+
+static void udl_test(void) {
+    printsln((String)__func__);
+    UList list = udl_create();
+    test_equal_i(list->c, 32);
+    for (int i = 0; i < 100; i++) {
+        udl_append(list, 0.5 * i);
+    }
+    udl_insert(list, 50, -1.0);
+    test_within_d(udl_get(list, 49), 24.5, EPSILON);
+    test_within_d(udl_get(list, 50), -1.0, EPSILON);
+    test_within_d(udl_get(list, 51), 25.0, EPSILON);
+    udl_set(list, 50, 100.0);
+    double sum = 0;
+    UListIterator iter = ul_iterator(list);
+    while (ul_has_next(iter)) {
+        sum += udl_next(&iter);
+    }
+    test_within_d(sum, 0.5 * 99 * 100 / 2 + 100.0, EPSILON);
+    ul_free(list);
+}
+
+static void udl_functional_test(void) {
+    printsln((String)__func__);
+    UList list = udl_create();
+    for (int i = 0; i < 100; i++) {
+        udl_append(list, i);
+    }
+    udl_each(list, dl_times, 0.5);
+    test_within_d(udl_get(list, 99), 49.5, EPSILON);
+    UList mapped = udl_map(list, dl_times, 4.0);
+    test_within_d(udl_get(mapped, 10), 20.0, EPSILON);
+    UList filtered = udl_filter(mapped, dl_lt, 10.0);
+    test_equal_i(ul_length(filtered), 5);
+    test_within_d(udl_foldl(filtered, double_plus, 0.0), 2.0 * (0 + 1 + 2 + 3 + 4), EPSILON);
+    test_within_d(udl_foldl(list, double_plus, 0.0), 0.5 * 99 * 100 / 2, EPSILON);
+    ul_free(filtered);
+    ul_free(mapped);
+    ul_free(list);
+}
+
+UList udl_create(void) {
+    return ul_create(sizeof(double));
+}
+
+double udl_get(UList list, int index) {
+    require_not_null(list);
+    require_element_size_double(list);
+    return *(double*)ul_get(list, index);
+}
+
+void udl_set(UList list, int index, double value) {
+    require_not_null(list);
+    require_element_size_double(list);
+    ul_set(list, index, &value);
+}
+
+void udl_append(UList list, double value) {
+    require_not_null(list);
+    require_element_size_double(list);
+    ul_append(list, &value);
+}
+
+void udl_insert(UList list, int index, double value) {
+    require_not_null(list);
+    require_element_size_double(list);
+    ul_insert(list, index, &value);
+}
+
+double udl_next(UListIterator *iter) {
+    require("element size double", iter->s == sizeof(double));
+    return *(double*)ul_next(iter);
+}
+
+void udl_each(UList list, DoubleIntDoubleToDouble f, double x) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_double(list);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        double *a = (double*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            a[j] = f(a[j], i, x);
+        }
+    }
+}
+
+UList udl_map(UList list, DoubleIntDoubleToDouble f, double x) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_double(list);
+    UList result = udl_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        double *a = (double*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            udl_append(result, f(a[j], i, x));
+        }
+    }
+    return result;
+}
+
+double udl_foldl(UList list, DoubleDoubleIntToDouble f, double init) {
+    require_not_null(f);
+    require_not_null(list);
+    require_element_size_double(list);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        double *a = (double*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            init = f(init, a[j], i);
+        }
+    }
+    return init;
+}
+
+UList udl_filter(UList list, DoubleIntDoubleToBool predicate, double x) {
+    require_not_null(predicate);
+    require_not_null(list);
+    require_element_size_double(list);
+    UList result = udl_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        double *a = (double*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            if (predicate(a[j], i, x)) {
+                udl_append(result, a[j]);
+            }
+        }
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Lists of strings
+
+static String usl_concat_free(String element, int index, String x) {
+    String s = s_concat(element, x);
+    s_free(element);
+    return s;
+}
+
+static String usl_concat(String element, int index, String x) {
+    return s_concat(element, x);
+}
+
+static String usl_fold_concat_free(String state, String element, int index) {
+    String s = s_concat(state, element);
+    s_free(state);
+    return s;
+}
+
+static bool usl_ends_with(String element, int index, String x) {
+    return s_ends_with(element, x);
+}
+
+static void usl_test(void) {
+    printsln((String)__func__);
+    UList list = usl_create();
+    usl_append(list, s_copy("b"));
+    usl_append(list, s_copy("d"));
+    usl_insert(list, 0, s_copy("a"));
+    usl_insert(list, 2, s_copy("c"));
+    test_equal_i(ul_length(list), 4);
+    test_equal_s(usl_get(list, 0), "a");
+    test_equal_s(usl_get(list, 2), "c");
+    s_free(usl_get(list, 3));
+    usl_set(list, 3, s_copy("e"));
+    UListIterator iter = ul_iterator(list);
+    test_equal_s(usl_next(&iter), "a");
+    test_equal_s(usl_next(&iter), "b");
+    usl_free(list);
+    usl_free(NULL);
+}
+
+static void usl_functional_test(void) {
+    printsln((String)__func__);
+    UList list = usl_create();
+    for (int i = 0; i < 100; i++) {
+        usl_append(list, s_copy(i % 2 == 0 ? "x" : "y"));
+    }
+    usl_each(list, usl_concat_free, "!");
+    test_equal_s(usl_get(list, 1), "y!");
+    UList mapped = usl_map(list, usl_concat, "?");
+    test_equal_s(usl_get(mapped, 98), "x!?");
+    UList filtered = usl_filter(list, usl_ends_with, "y!");
+    test_equal_i(ul_length(filtered), 50);
+    test_equal_s(usl_get(filtered, 49), "y!");
+    String s = usl_foldl(filtered, usl_fold_concat_free, s_copy("init"));
+    test_equal_i(s_length(s), 4 + 2 * 50);
+    s_free(s);
+    ul_free(filtered); // the strings are shared with list
+    usl_free(mapped);
+    usl_free(list);
+}
+
+UList usl_create(void) {
+    return ul_create(sizeof(String));
+}
+
+void usl_free(UList list) {
+    if (list != NULL) {
+        require_element_size_string(list);
+        UListIterator iter = ul_iterator(list);
+        while (ul_has_next(iter)) {
+            s_free(usl_next(&iter));
+        }
+        ul_free(list);
+    }
+}
+
+String usl_get(UList list, int index) {
+    require_not_null(list);
+    require_element_size_string(list);
+    return *(String*)ul_get(list, index);
+}
+
+void usl_set(UList list, int index, String value) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(value);
+    ul_set(list, index, &value);
+}
+
+void usl_append(UList list, String value) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(value);
+    ul_append(list, &value);
+}
+
+void usl_insert(UList list, int index, String value) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(value);
+    ul_insert(list, index, &value);
+}
+
+String usl_next(UListIterator *iter) {
+    require("element size string", iter->s == sizeof(String));
+    return *(String*)ul_next(iter);
+}
+
+void usl_each(UList list, StringIntStringToString f, String x) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(f);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        String *a = (String*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            a[j] = f(a[j], i, x);
+        }
+    }
+}
+
+UList usl_map(UList list, StringIntStringToString f, String x) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(f);
+    UList result = usl_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        String *a = (String*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            usl_append(result, f(a[j], i, x));
+        }
+    }
+    return result;
+}
+
+String usl_foldl(UList list, StringStringIntToString f, String state) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(f);
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        String *a = (String*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            state = f(state, a[j], i);
+        }
+    }
+    return state;
+}
+
+UList usl_filter(UList list, StringIntStringToBool predicate, String x) {
+    require_not_null(list);
+    require_element_size_string(list);
+    require_not_null(predicate);
+    UList result = usl_create();
+    int i = 0;
+    for (UListChunk *chunk = list->first; chunk != NULL; chunk = chunk->next) {
+        String *a = (String*)(chunk + 1);
+        for (int j = 0; j < chunk->n; j++, i++) {
+            if (predicate(a[j], i, x)) {
+                usl_append(result, a[j]);
+            }
+        }
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ul_test_all(void) {
+    ul_create_test();
+    ul_of_l_test();
+    ul_footprint_test();
+    ul_get_test();
+    ul_insert_test();
+    ul_remove_test();
+    ul_iterator_test();
+    ul_each_test();
+    ul_map_test();
+    ul_foldl_test();
+    ul_filter_test();
+    ul_random_test();
+    uil_functional_test();
+    udl_test();
+    udl_functional_test();
+    usl_test();
+    usl_functional_test();
+}
+
+#if 0
+int main(void) {
+    base_init();
+    ul_test_all();
+    return 0;
+}
+#endif
@@ -0,0 +1,519 @@
+/** @file
+An unrolled list: a linked list of chunks, each of which stores up to c elements inline and contiguously, e.g., 64 ints or 32 doubles per chunk (256 bytes of elements). It has the core functions of the generic list (see list.h) with prefix @c ul_ instead of @c l_: creating, indexed access, inserting and removing, iterating, and @ref ul_each, @ref ul_map, @ref ul_foldl, and @ref ul_filter. Lists of ints, doubles, and strings have the corresponding functions with prefixes @c uil_, @c udl_, and @c usl_. Sorting, searching, and the other functions of list.h are not provided, convert with @ref l_of_ul if needed.
+
+Compared to a @ref List, which has one node per element, an unrolled list follows one next pointer per chunk instead of one per element and its elements are adjacent in memory, so iterating chunk by chunk is about as fast as iterating an array and an int costs about 4.5 instead of 24 bytes (see @ref ul_footprint). The costs of the operations:
+- @ref ul_append: constant time, a new chunk is allocated every c elements
+- @ref ul_get, @ref ul_set: O(n / c) chunks are skipped, starting at the first chunk or at the cursor (the chunk last accessed by index); accessing the elements in order takes amortized constant time per element, accessing the last chunk takes constant time
+- @ref ul_insert, @ref ul_remove: finding the chunk as for @ref ul_get, plus moving up to c elements within the chunk; a full chunk is split in half, a chunk that becomes less than half full takes elements from the next chunk or is merged with it
+- iterating: @ref ul_next returns one element, @ref ul_next_chunk the rest of the current chunk, which can be processed like an array
+- @ref ul_prepend: like inserting at index 0, i.e., moving up to c elements, whereas @ref l_prepend takes constant time
+
+Each chunk except the last holds at least c / 2 elements, thus the list needs at most about twice the memory of its elements, plus a 16 byte header per chunk. See benchmarks/bench_unrolled_list.c for a comparison to @ref List.
+
+@code{.c}
+UList list = uil_create();
+for (int i = 0; i < 1000; i++) {
+    uil_append(list, i);
+}
+uil_insert(list, 500, -1);
+int sum = 0;
+UListIterator iter = ul_iterator(list);
+while (ul_has_next(iter)) {
+    sum += uil_next(&iter);
+}
+ul_free(list);
+@endcode
+
+@author Michael Rohs
+@date 16.10.2026
+@copyright Apache License, Version 2.0
+*/
+
+#ifndef __UNROLLED_LIST_H__
+#define __UNROLLED_LIST_H__
+
+#include "base.h"
+
+/**
+Creates an empty unrolled list of elements of size s.
+@param[in] s element size in bytes
+@return empty list
+@pre "positive size", s > 0
+*/
+UList ul_create(int s);
+
+/**
+Creates an unrolled list with the elements of the list.
+@param[in] list input list of any type
+@return new unrolled list with the same element size and elements
+*/
+UList ul_of_l(List list);
+
+/**
+Creates a list with the elements of the unrolled list.
+@param[in] list input unrolled list
+@return new list with the same element size and elements
+*/
+List l_of_ul(UList list);
+
+/**
+Frees the memory of the unrolled list.
+@param[in,out] list to be freed, unusable thereafter
+*/
+void ul_free(UList list);
+
+/**
+Returns the number of elements in the unrolled list. Takes constant time.
+@param[in] list input list
+@return number of elements
+*/
+int ul_length(UList list);
+
+/**
+Returns how many bytes the unrolled list occupies. The payload are the bytes of the elements. The structure is the list head, the chunk headers, the unused element slots of the chunks, and allocator rounding.
+@param[in] list input list
+@return the footprint of the list
+@see memory_footprint, l_footprint
+*/
+Footprint ul_footprint(UList list);
+
+/**
+Returns the memory address of the element at index. The address is valid until the list is modified.
+@param[in] list input list
+@param[in] index index of the element
+@return address of the element
+@pre "index in range"
+*/
+Any ul_get(UList list, int index);
+
+/**
+Sets the element at index to value. Copies s bytes from value.
+@param[in,out] list input list
+@param[in] index index of the element
+@param[in] value address of the value
+@pre "index in range"
+*/
+void ul_set(UList list, int index, Any value);
+
+/**
+Appends value to the end of the list. Copies s bytes from value.
+@param[in,out] list input list
+@param[in] value address of the value
+*/
+void ul_append(UList list, Any value);
+
+/**
+Prepends value to the front of the list. Copies s bytes from value.
+@param[in,out] list input list
+@param[in] value address of the value
+*/
+void ul_prepend(UList list, Any value);
+
+/**
+Inserts value at index. Copies s bytes from value.
+Does nothing if index is not a valid index, i.e. if not in interval [0,n].
+@param[in,out] list input list
+@param[in] index the position to insert at (index 0 means inserting at the front)
+@param[in] value address of the value
+*/
+void ul_insert(UList list, int index, Any value);
+
+/**
+Removes the element at index.
+Does nothing if index is not a valid index, i.e. if not in interval [0,n).
+@param[in,out] list input list
+@param[in] index index of the element to remove
+*/
+void ul_remove(UList list, int index);
+
+/**
+Returns a fresh iterator for this list. The list must not be modified while iterating.
+@param[in] list input list
+@return iterator
+*/
+UListIterator ul_iterator(UList list);
+
+/**
+Returns true iff there are one or more elements left.
+@param[in] iter an iterator
+@return true iff there are one or more elements left
+*/
+bool ul_has_next(UListIterator iter);
+
+/**
+Returns the address of the next element.
+@param[in,out] iter an iterator, will be advanced to the next element
+@return address of the next element
+@pre "iterator has more values"
+*/
+Any ul_next(UListIterator *iter);
+
+/**
+Returns the address of the next element and the number of elements that follow it contiguously, i.e., the rest of the current chunk, and advances the iterator past them. Processing the elements with a loop over each chunk is as fast as processing an array.
+
+@code{.c}
+UListIterator iter = ul_iterator(list);
+while (ul_has_next(iter)) {
+    int n;
+    int *a = ul_next_chunk(&iter, &n);
+    for (int i = 0; i < n; i++) {
+        sum += a[i];
+    }
+}
+@endcode
+@param[in,out] iter an iterator, will be advanced past the returned elements
+@param[out] n number of returned elements (at least 1)
+@return address of the first of n elements
+@pre "iterator has more values"
+*/
+Any ul_next_chunk(UListIterator *iter, int *n);
+
+/**
+Applies function f to each element of list. The original list is modified (if f modifies the element).
+Function f is called once for each element from first to last.
+@code{.c}
+void f(Any element, int index, Any state) {}
+@endcode
+
+@param[in,out] list input list
+@param[in] f a function that is called for each element of input list
+@param[in] state provided to each invocation of f
+@pre "not null", f
+@see l_each
+*/
+void ul_each(UList list, AnyFn f, Any state);
+
+/**
+Applies function f to each element of list. The original list is not modified.
+Function f is called once for each element from first to last.
+@code{.c}
+void f(Any element, int index, Any state, Any mapped_element) {}
+@endcode
+
+@param[in] list input list
+@param[in] f transformation function, called for each element of input list
+@param[in] mapped_element_size size of elements in the mapped list (in bytes)
+@param[in] state provided to each invocation of f
+@return the mapped list
+@pre "not null", f
+@pre "positive size", mapped_element_size > 0
+@see l_map
+*/
+UList ul_map(UList list, AnyFn f, int mapped_element_size, Any state);
+
+/**
+Folds the list from left to right.
+@code{.c}
+void f(Any state, Any element, int index) {}
+@endcode
+
+@param[in] list input list
+@param[in] f a function that is called for each element of input list
+@param[in,out] state provided to each invocation of f
+@pre "not null", f
+@see l_foldl
+*/
+void ul_foldl(UList list, AnyFn f, Any state);
+
+/**
+Creates a new list with only those elements that satisfy the predicate.
+The original list is not modified.
+@code{.c}
+bool predicate(Any element, int index, Any state) {}
+@endcode
+
+@param[in] list input list
+@param[in] predicate predicate function, returns true iff element should be included
+@param[in] state given to each invocation of predicate (may be NULL)
+@return filtered list
+@pre "not null", predicate
+@see l_filter
+*/
+UList ul_filter(UList list, AnyFn predicate, Any state);
+
+/**
+Creates an empty unrolled list of ints.
+@return empty list
+*/
+UList uil_create(void);
+
+/**
+Returns the int at index.
+@param[in] list input list of ints
+@param[in] index index of the element
+@return element at index
+@pre "index in range"
+*/
+int uil_get(UList list, int index);
+
+/**
+Sets the int at index to value.
+@param[in,out] list input list of ints
+@param[in] index index of the element
+@param[in] value value to set
+@pre "index in range"
+*/
+void uil_set(UList list, int index, int value);
+
+/**
+Appends value to the end of the list of ints.
+@param[in,out] list input list of ints
+@param[in] value value to append
+*/
+void uil_append(UList list, int value);
+
+/**
+Inserts value at index into the list of ints. Does nothing if index is not in interval [0,n].
+@param[in,out] list input list of ints
+@param[in] index the position to insert at
+@param[in] value value to insert
+*/
+void uil_insert(UList list, int index, int value);
+
+/**
+Returns the next int.
+@param[in,out] iter an iterator, will be advanced to the next element
+@return next element
+@pre "iterator has more values"
+*/
+int uil_next(UListIterator *iter);
+
+/**
+Replaces each element of the list of ints by f(element, index, x).
+@param[in,out] list input list of ints
+@param[in] f a function that is called for each element of input list
+@param[in] x provided to each invocation of f
+@pre "not null", f
+@see il_each
+*/
+void uil_each(UList list, IntIntIntToInt f, int x);
+
+/**
+Creates a new list of ints with the elements f(element, index, x). The original list is not modified.
+@param[in] list input list of ints
+@param[in] f transformation function, called for each element of input list
+@param[in] x provided to each invocation of f
+@return the mapped list
+@pre "not null", f
+@see il_map
+*/
+UList uil_map(UList list, IntIntIntToInt f, int x);
+
+/**
+Folds the list of ints from left to right, i.e., computes f(... f(f(init, l0, 0), l1, 1) ..., ln-1, n-1).
+@param[in] list input list of ints
+@param[in] f a function that is called for each element of input list
+@param[in] init initial value of the accumulator
+@return the accumulated value
+@pre "not null", f
+@see il_foldl
+*/
+int uil_foldl(UList list, IntIntIntToInt f, int init);
+
+/**
+Creates a new list of ints with only those elements for which predicate(element, index, x) is true. The original list is not modified.
+@param[in] list input list of ints
+@param[in] predicate predicate function, returns true iff element should be included
+@param[in] x given to each invocation of predicate
+@return filtered list
+@pre "not null", predicate
+@see il_filter
+*/
+UList uil_filter(UList list, IntIntIntToBool predicate, int x);
+
+/**
+Creates an empty unrolled list of doubles.
+@return empty list
+*/
+UList udl_create(void);
+
+/**
+Returns the double at index.
+@param[in] list input list of doubles
+@param[in] index index of the element
+@return element at index
+@pre "index in range"
+*/
+double udl_get(UList list, int index);
+
+/**
+Sets the double at index to value.
+@param[in,out] list input list of doubles
+@param[in] index index of the element
+@param[in] value value to set
+@pre "index in range"
+*/
+void udl_set(UList list, int index, double value);
+
+/**
+Appends value to the end of the list of doubles.
+@param[in,out] list input list of doubles
+@param[in] value value to append
+*/
+void udl_append(UList list, double value);
+
+/**
+Inserts value at index into the list of doubles. Does nothing if index is not in interval [0,n].
+@param[in,out] list input list of doubles
+@param[in] index the position to insert at
+@param[in] value value to insert
+*/
+void udl_insert(UList list, int index, double value);
+
+/**
+Returns the next double.
+@param[in,out] iter an iterator, will be advanced to the next element
+@return next element
+@pre "iterator has more values"
+*/
+double udl_next(UListIterator *iter);
+
+/**
+Replaces each element of the list of doubles by f(element, index, x).
+@param[in,out] list input list of doubles
+@param[in] f a function that is called for each element of input list
+@param[in] x provided to each invocation of f
+@pre "not null", f
+@see dl_each
+*/
+void udl_each(UList list, DoubleIntDoubleToDouble f, double x);
+
+/**
+Creates a new list of doubles with the elements f(element, index, x). The original list is not modified.
+@param[in] list input list of doubles
+@param[in] f transformation function, called for each element of input list
+@param[in] x provided to each invocation of f
+@return the mapped list
+@pre "not null", f
+@see dl_map
+*/
+UList udl_map(UList list, DoubleIntDoubleToDouble f, double x);
+
+/**
+Folds the list of doubles from left to right, i.e., computes f(... f(f(init, l0, 0), l1, 1) ..., ln-1, n-1).
+@param[in] list input list of doubles
+@param[in] f a function that is called for each element of input list
+@param[in] init initial value of the accumulator
+@return the accumulated value
+@pre "not null", f
+@see dl_foldl
+*/
+double udl_foldl(UList list, DoubleDoubleIntToDouble f, double init);
+
+/**
+Creates a new list of doubles with only those elements for which predicate(element, index, x) is true. The original list is not modified.
+@param[in] list input list of doubles
+@param[in] predicate predicate function, returns true iff element should be included
+@param[in] x given to each invocation of predicate
+@return filtered list
+@pre "not null", predicate
+@see dl_filter
+*/
+UList udl_filter(UList list, DoubleIntDoubleToBool predicate, double x);
+
+/**
+Creates an empty unrolled list of strings. Like a @ref sl_create list, the list owns its strings: they are freed by @ref usl_free.
+@return empty list
+*/
+UList usl_create(void);
+
+/**
+Frees the list of strings and its strings.
+@param[in,out] list to be freed, unusable thereafter
+*/
+void usl_free(UList list);
+
+/**
+Returns the string at index. The string is not copied.
+@param[in] list input list of strings
+@param[in] index index of the element
+@return element at index
+@pre "index in range"
+*/
+String usl_get(UList list, int index);
+
+/**
+Sets the string at index to value. The string is not copied, the previous string is not freed.
+@param[in,out] list input list of strings
+@param[in] index index of the element
+@param[in] value string to set
+@pre "index in range"
+@pre "not null", value
+*/
+void usl_set(UList list, int index, String value);
+
+/**
+Appends value to the end of the list of strings. The string is not copied.
+@param[in,out] list input list of strings
+@param[in] value string to append
+@pre "not null", value
+*/
+void usl_append(UList list, String value);
+
+/**
+Inserts value at index into the list of strings. The string is not copied. Does nothing if index is not in interval [0,n].
+@param[in,out] list input list of strings
+@param[in] index the position to insert at
+@param[in] value string to insert
+@pre "not null", value
+*/
+void usl_insert(UList list, int index, String value);
+
+/**
+Returns the next string.
+@param[in,out] iter an iterator, will be advanced to the next element
+@return next element
+@pre "iterator has more values"
+*/
+String usl_next(UListIterator *iter);
+
+/**
+Replaces each element of the list of strings by f(element, index, x). Function f is responsible for freeing the replaced string, if needed.
+@param[in,out] list input list of strings
+@param[in] f a function that is called for each element of input list
+@param[in] x provided to each invocation of f
+@pre "not null", f
+@see sl_each
+*/
+void usl_each(UList list, StringIntStringToString f, String x);
+
+/**
+Creates a new list of strings with the elements f(element, index, x). The original list is not modified.
+@param[in] list input list of strings
+@param[in] f transformation function, called for each element of input list, returns a new string
+@param[in] x provided to each invocation of f
+@return the mapped list
+@pre "not null", f
+@see sl_map
+*/
+UList usl_map(UList list, StringIntStringToString f, String x);
+
+/**
+Folds the list of strings from left to right, i.e., computes f(... f(f(state, l0, 0), l1, 1) ..., ln-1, n-1).
+@param[in] list input list of strings
+@param[in] f a function that is called for each element of input list
+@param[in] state initial value of the accumulator
+@return the accumulated value
+@pre "not null", f
+@see sl_foldl
+*/
+String usl_foldl(UList list, StringStringIntToString f, String state);
+
+/**
+Creates a new list of strings with only those elements for which predicate(element, index, x) is true. The original list is not modified. The strings are not copied, so free the result with @ref ul_free rather than @ref usl_free.
+@param[in] list input list of strings
+@param[in] predicate predicate function, returns true iff element should be included
+@param[in] x given to each invocation of predicate
+@return filtered list
+@pre "not null", predicate
+@see sl_filter
+*/
+UList usl_filter(UList list, StringIntStringToBool predicate, String x);
+
+/**
+Runs the tests of the unrolled list.
+@private
+*/
+void ul_test_all(void);
+
+#endif